@@ -0,0 +1,447 @@
+// -----------------------------------------------------------------------------
+// File: CmpAnalyticMemory.h
+// Description:
+//    Defines a memory component that estimates the latency of each request
+//    with a closed form queueing model instead of simulating request queues.
+//    Each channel and each bank is an M/D/1 queue. Arrival rates and the row
+//    hit probability of each bank are tracked online with exponentially
+//    weighted moving averages, so the cost per request is constant. As the
+//    M/D/1 wait is only defined below full utilization, each queue also
+//    keeps the cycle at which its backlog clears (one value per queue), and
+//    a request waits at least for that backlog. This bounds the throughput
+//    of a channel by its bandwidth. The latency parameters have the same
+//    meaning as those of the simple memory controller (simple-mc), and its
+//    component files can be used as is.
+// -----------------------------------------------------------------------------
+
+#ifndef __CMP_ANALYTIC_MEMORY_H__
+#define __CMP_ANALYTIC_MEMORY_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "MemoryComponent.h"
+#include "DRAMAddressMapping.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+
+
+// -----------------------------------------------------------------------------
+// Class: CmpAnalyticMemory
+// Description:
+//    Analytic memory model. A request sees the expected queueing delay of
+//    its channel and bank, the expected read/write turnaround and the
+//    expected row buffer latency.
+//
+//    Channel service time: channel-delay plus the turnarounds, which happen
+//    once per drain of the write buffer. Reads also wait for part of a write
+//    drain when they arrive during one: the drain takes
+//    D = num-write-buffer-entries * channel-delay + turnarounds, and is in
+//    progress for a fraction of time given by the write arrival rate. The
+//    read waits drain-wait-fraction * D, calibrated against simple-mc.
+//    Bank service time: bank-busy-latency for a row conflict, weighted by
+//    the conflict probability. simple-mc does not keep banks busy, so the
+//    default is 0.
+// -----------------------------------------------------------------------------
+
+class CmpAnalyticMemory : public MemoryComponent {
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  uint32 _numChannels;
+  uint32 _numRanks;
+  uint32 _numBanks;
+  uint32 _rowSize;
+  uint32 _lineSize;
+  string _addressMapping;
+  bool _usePhysicalAddress;
+
+  uint32 _rowHitLatency;
+  uint32 _rowConflictLatency;
+  uint32 _readToWriteLatency;
+  uint32 _writeToReadLatency;
+
+  uint32 _numWriteBufferEntries;
+  uint32 _channelDelay;
+  uint32 _busProcessorRatio;
+  uint32 _bankBusyLatency;
+
+  // weight of a new sample in the moving averages
+  double _smoothing;
+  // utilization at which the queueing delay saturates
+  double _maxUtilization;
+  // fraction of a write drain that a read arriving during it waits for
+  double _drainWaitFraction;
+
+  string _dummyString;
+  uint32 _dummy;
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  // state of a queue (channel or bank)
+  struct Queue {
+    cycles_t lastArrival;
+    // average cycles between arrivals
+    double interArrival;
+    // cycle at which all work that has arrived is done
+    double busyUntil;
+    // utilization summed over requests, for statistics
+    double utilization;
+  };
+
+  // state of a bank
+  struct Bank {
+    Queue queue;
+    addr_t lastRow;
+    // probability that a request hits the open row
+    double hitProbability;
+  };
+
+  // state of a channel
+  struct Channel {
+    Queue queue;
+    // fraction of requests that are writes
+    double writeFraction;
+    vector <Bank> banks;
+  };
+
+  vector <Channel> _channels;
+
+  // per channel statistics. busy cycles are the modeled channel service
+  // times, turnarounds included
+  vector <uint64> _channelAccesses;
+  vector <uint64> _channelBusyCycles;
+
+  DRAMAddressMapping _mapping;
+
+
+  // -------------------------------------------------------------------------
+  // Declare counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(accesses);
+  NEW_COUNTER(reads);
+  NEW_COUNTER(writes);
+  NEW_COUNTER(rowhits);
+  NEW_COUNTER(rowconflicts);
+  NEW_COUNTER(queueing_cycles);
+  NEW_COUNTER(latency_cycles);
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor. It cannot take any arguments
+  // -------------------------------------------------------------------------
+
+  CmpAnalyticMemory() {
+    _numChannels = 1;
+    _numRanks = 1;
+    _numBanks = 8;
+    _rowSize = 8192;
+    _lineSize = 64;
+    _addressMapping = "row-rank-bank-channel-column";
+    _usePhysicalAddress = false;
+    _rowHitLatency = 14;
+    _rowConflictLatency = 34;
+    _readToWriteLatency = 2;
+    _writeToReadLatency = 6;
+    _numWriteBufferEntries = 64;
+    _channelDelay = 4;
+    _busProcessorRatio = 8;
+    _bankBusyLatency = 0;
+    _smoothing = 1.0 / 64;
+    _maxUtilization = 0.98;
+    _drainWaitFraction = 0.25;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Virtual functions to be implemented by the components
+  // -------------------------------------------------------------------------
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter to the component
+  // -------------------------------------------------------------------------
+
+  void AddParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      // Add the list of parameters to the component here
+      CMP_PARAMETER_UINT("num-channels", _numChannels)
+      CMP_PARAMETER_UINT("num-ranks", _numRanks)
+      CMP_PARAMETER_UINT("num-banks", _numBanks)
+      CMP_PARAMETER_UINT("row-size", _rowSize)
+      CMP_PARAMETER_UINT("line-size", _lineSize)
+      CMP_PARAMETER_STRING("address-mapping", _addressMapping)
+      CMP_PARAMETER_BOOLEAN("physical-address", _usePhysicalAddress)
+      CMP_PARAMETER_UINT("num-write-buffer-entries", _numWriteBufferEntries)
+      CMP_PARAMETER_UINT("row-hit-latency", _rowHitLatency)
+      CMP_PARAMETER_UINT("row-conflict-latency", _rowConflictLatency)
+      CMP_PARAMETER_UINT("read-to-write-latency", _readToWriteLatency)
+      CMP_PARAMETER_UINT("write-to-read-latency", _writeToReadLatency)
+      CMP_PARAMETER_UINT("channel-delay", _channelDelay)
+      CMP_PARAMETER_UINT("bus-processor-ratio", _busProcessorRatio)
+      CMP_PARAMETER_UINT("bank-busy-latency", _bankBusyLatency)
+      CMP_PARAMETER_DOUBLE("smoothing", _smoothing)
+      CMP_PARAMETER_DOUBLE("max-utilization", _maxUtilization)
+      CMP_PARAMETER_DOUBLE("drain-wait-fraction", _drainWaitFraction)
+
+      // accepted so that simple-mc files can be used
+      CMP_PARAMETER_STRING("scheduling-algo", _dummyString)
+      CMP_PARAMETER_UINT("rank-to-rank-latency", _dummy)
+
+      CMP_PARAMETER_UINT("stall-count", _dummy)
+      CMP_PARAMETER_UINT("cmp-stall-count", _dummy)
+
+    CMP_PARAMETER_END
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to initialize statistics
+  // -------------------------------------------------------------------------
+
+  void InitializeStatistics() {
+
+    INITIALIZE_COUNTER(accesses, "Total Accesses");
+    INITIALIZE_COUNTER(reads, "Read Accesses");
+    INITIALIZE_COUNTER(writes, "Write Accesses");
+    INITIALIZE_COUNTER(rowhits, "Row Buffer Hits (arrival order)");
+    INITIALIZE_COUNTER(rowconflicts, "Row Buffer Conflicts (arrival order)");
+    INITIALIZE_COUNTER(queueing_cycles, "Total Queueing Delay");
+    INITIALIZE_COUNTER(latency_cycles, "Total Latency");
+    INITIALIZE_VECTOR_COUNTER(_channelAccesses, "channel-accesses",
+        "Accesses of each channel")
+    INITIALIZE_VECTOR_COUNTER(_channelBusyCycles, "channel-busy_cycles",
+        "Modeled busy cycles of each channel")
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation starts
+  // -------------------------------------------------------------------------
+
+  void StartSimulation() {
+
+    _mapping.Initialize(_addressMapping, _numChannels, _numRanks, _numBanks,
+        _rowSize, _lineSize);
+
+    _rowHitLatency *= _busProcessorRatio;
+    _rowConflictLatency *= _busProcessorRatio;
+    _readToWriteLatency *= _busProcessorRatio;
+    _writeToReadLatency *= _busProcessorRatio;
+    _channelDelay *= _busProcessorRatio;
+    _bankBusyLatency *= _busProcessorRatio;
+
+    _channels.resize(_numChannels);
+    _channelAccesses.assign(_numChannels, 0);
+    _channelBusyCycles.assign(_numChannels, 0);
+    for (uint32 i = 0; i < _numChannels; i ++) {
+      InitializeQueue(_channels[i].queue);
+      _channels[i].writeFraction = 0;
+      _channels[i].banks.resize(_numRanks * _numBanks);
+      for (uint32 b = 0; b < _channels[i].banks.size(); b ++) {
+        InitializeQueue(_channels[i].banks[b].queue);
+        _channels[i].banks[b].lastRow = 0;
+        _channels[i].banks[b].hitProbability = 0;
+      }
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called at a heart beat. Argument indicates cycles elapsed after
+  // previous heartbeat
+  // -------------------------------------------------------------------------
+
+  void HeartBeat(cycles_t hbCount) {
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when warmup ends
+  // -------------------------------------------------------------------------
+
+  void EndWarmUp() {
+    MemoryComponent::EndWarmUp();
+    fill(_channelAccesses.begin(), _channelAccesses.end(), 0);
+    fill(_channelBusyCycles.begin(), _channelBusyCycles.end(), 0);
+    for (uint32 i = 0; i < _channels.size(); i ++)
+      _channels[i].queue.utilization = 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation ends
+  // -------------------------------------------------------------------------
+
+  void EndSimulation() {
+    DUMP_STATISTICS;
+    CMP_LOG("average-latency = %.2lf", accesses == 0 ? 0.0 :
+        (double)latency_cycles / accesses);
+    for (uint32 i = 0; i < _channels.size(); i ++)
+      CMP_LOG("channel-utilization-%u = %.3lf", i,
+          _channelAccesses[i] == 0 ? 0.0 :
+          _channels[i].queue.utilization / _channelAccesses[i]);
+    CLOSE_ALL_LOGS;
+  }
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to initialize a queue
+  // -------------------------------------------------------------------------
+
+  void InitializeQueue(Queue &queue) {
+    queue.lastArrival = 0;
+    // start with an idle queue
+    queue.interArrival = 1e9;
+    queue.busyUntil = 0;
+    queue.utilization = 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to record an arrival at a queue and return the expected
+  // waiting time with the given deterministic service time
+  // -------------------------------------------------------------------------
+
+  double Arrive(Queue &queue, cycles_t now, double service) {
+
+    // requests can arrive slightly out of order
+    double gap = (now > queue.lastArrival ? now - queue.lastArrival : 0);
+    queue.lastArrival = max(queue.lastArrival, now);
+    queue.interArrival += _smoothing * (gap - queue.interArrival);
+
+    double rho = service / max(queue.interArrival, 1.0);
+    if (rho > _maxUtilization) rho = _maxUtilization;
+    queue.utilization += rho;
+
+    // backlog of the queue
+    double backlog = max(queue.busyUntil - (double)now, 0.0);
+    queue.busyUntil = max(queue.busyUntil, (double)now) + service;
+
+    return max(rho * service / (2 * (1 - rho)), backlog);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process a request. Return value indicates number of busy
+  // cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessRequest(MemoryRequest *request) {
+
+    bool isWrite = false;
+
+    switch (request -> type) {
+
+    case MemoryRequest::READ: case MemoryRequest::READ_FOR_WRITE: case MemoryRequest::PREFETCH:
+      INCREMENT(reads);
+      break;
+
+    case MemoryRequest::WRITEBACK:
+    case MemoryRequest::CLEAN:
+      INCREMENT(writes);
+      isWrite = true;
+      break;
+
+    // a fake read only carries a hint for the caches. it moves no data
+    case MemoryRequest::FAKE_READ:
+      return 0;
+
+    case MemoryRequest::WRITE:
+    case MemoryRequest::PARTIALWRITE:
+      fprintf(stderr, "Memory controller cannot get a write\n");
+      exit(0);
+    }
+
+    INCREMENT(accesses);
+
+    DRAMAddress location;
+    _mapping.Map(_usePhysicalAddress ? PADDR(request) : VADDR(request),
+        location);
+    Channel &channel = _channels[location.channel];
+    Bank &bank = channel.banks[location.rank * _numBanks + location.bank];
+    cycles_t now = request -> currentCycle;
+
+    // update the row hit probability of the bank
+    bool hit = (bank.lastRow == location.row);
+    if (hit) {
+      INCREMENT(rowhits);
+      if (request -> drain)
+        request -> drain -> rowHits ++;
+    }
+    else {
+      INCREMENT(rowconflicts);
+    }
+    bank.lastRow = location.row;
+    bank.hitProbability += _smoothing * ((hit ? 1.0 : 0.0) -
+        bank.hitProbability);
+    double pHit = bank.hitProbability;
+
+    // writes are drained in batches, with two turnarounds per batch. the
+    // turnarounds occupy the channel, so they are part of its service time
+    channel.writeFraction += _smoothing * ((isWrite ? 1.0 : 0.0) -
+        channel.writeFraction);
+    double turnAround = channel.writeFraction *
+      (_readToWriteLatency + _writeToReadLatency) /
+      max(_numWriteBufferEntries, (uint32)1);
+
+    // queueing delays
+    double bankService = (1 - pHit) * _bankBusyLatency;
+    double channelService = _channelDelay + turnAround;
+    double wait = Arrive(channel.queue, now, channelService) +
+      Arrive(bank.queue, now, bankService);
+
+    // reads that arrive during a write drain wait for part of it
+    if (!isWrite) {
+      double drain = (double)_numWriteBufferEntries * _channelDelay +
+        _readToWriteLatency + _writeToReadLatency;
+      double draining = channel.writeFraction * drain /
+        max(_numWriteBufferEntries, (uint32)1) /
+        max(channel.queue.interArrival, 1.0);
+      if (draining > _maxUtilization) draining = _maxUtilization;
+      wait += draining * drain * _drainWaitFraction;
+    }
+
+    double rowLatency = pHit * _rowHitLatency + (1 - pHit) *
+      _rowConflictLatency;
+    cycles_t latency = (cycles_t)(wait + rowLatency + 0.5);
+
+    ADD_TO_COUNTER(queueing_cycles, (cycles_t)(wait + 0.5));
+    ADD_TO_COUNTER(latency_cycles, latency);
+    _channelAccesses[location.channel] ++;
+    _channelBusyCycles[location.channel] += (cycles_t)(channelService + 0.5);
+
+    request -> AddLatency(latency);
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process the return of a request. Return value indicates
+  // number of busy cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessReturn(MemoryRequest *request) {
+    return 0;
+  }
+
+};
+
+#endif // __CMP_ANALYTIC_MEMORY_H__
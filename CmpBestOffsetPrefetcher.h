@@ -0,0 +1,371 @@
+// -----------------------------------------------------------------------------
+// File: CmpBestOffsetPrefetcher.h
+// Description:
+//    Implements a best-offset prefetcher
+// -----------------------------------------------------------------------------
+
+#ifndef __CMP_BEST_OFFSET_PREFETCHER_H__
+#define __CMP_BEST_OFFSET_PREFETCHER_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "Prefetcher.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+
+
+// -----------------------------------------------------------------------------
+// Class: CmpBestOffsetPrefetcher
+// Description:
+//    Best-offset prefetcher (Michaud, HPCA 2016). On an access to block X,
+//    prefetches X + D. D is learned online. The recent requests (RR) table
+//    holds Y - D for the prefetches of Y that completed, so a hit on X - d in
+//    it means that a prefetch with offset d would have been timely for X.
+//    Each access tests one offset of the list in turn. A learning phase ends
+//    when an offset reaches score-max or after round-max rounds over the
+//    list. The best offset of the phase becomes D, and prefetching is turned
+//    off if its score is bad-score or less. While it is off, the RR table
+//    holds the blocks of the demands that complete. With degree above 1,
+//    only the first prefetch of an access records its base, as the others
+//    are not offset D away from an access.
+//
+//    Addresses are physical and prefetches do not cross pages. Demands that
+//    a completed prefetch with offset D covered are tagged with
+//    d_prefetched, and d_prefID and the prefetches carry the index of D in
+//    the offset list.
+// -----------------------------------------------------------------------------
+
+class CmpBestOffsetPrefetcher : public Prefetcher {
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  uint32 _blockSize;
+  uint32 _pageSize;
+  bool _prefetchOnWrite;
+
+  uint32 _maxOffset;
+  uint32 _rrTableSize;
+  uint32 _scoreMax;
+  uint32 _roundMax;
+  uint32 _badScore;
+  uint32 _degree;
+
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  // offsets 1 to max-offset with no prime factor above 5
+  vector <uint32> _offsets;
+  vector <uint32> _scores;
+
+  // RR table. direct mapped, holds block numbers plus one, 0 is empty
+  vector <addr_t> _rrTable;
+
+  // first prefetches of the accesses that are in flight. indexed like the
+  // RR table, holds block numbers plus one, 0 is empty
+  vector <addr_t> _firstPrefetches;
+
+  // learning state
+  uint32 _testIndex;
+  uint32 _round;
+
+  // current offset (index in the offset list) and whether it is used
+  uint32 _best;
+  bool _prefetchOn;
+
+
+  // -------------------------------------------------------------------------
+  // Declare Counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(num_prefetches);
+  NEW_COUNTER(page_crossings);
+  NEW_COUNTER(phases);
+  NEW_COUNTER(phases_off);
+  NEW_COUNTER(covered_demands);
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor. It cannot take any arguments
+  // -------------------------------------------------------------------------
+
+  CmpBestOffsetPrefetcher() {
+    _blockSize = 64;
+    _pageSize = 4096;
+    _prefetchOnWrite = false;
+
+    _maxOffset = 64;
+    _rrTableSize = 256;
+    _scoreMax = 31;
+    _roundMax = 100;
+    _badScore = 1;
+    _degree = 1;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Virtual functions to be implemented by the components
+  // -------------------------------------------------------------------------
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter to the component
+  // -------------------------------------------------------------------------
+
+  void AddParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      // Add the list of parameters to the component here
+      CMP_PARAMETER_UINT("block-size", _blockSize)
+      CMP_PARAMETER_UINT("page-size", _pageSize)
+      CMP_PARAMETER_BOOLEAN("prefetch-on-write", _prefetchOnWrite)
+
+      CMP_PARAMETER_UINT("max-offset", _maxOffset)
+      CMP_PARAMETER_UINT("rr-table-size", _rrTableSize)
+      CMP_PARAMETER_UINT("score-max", _scoreMax)
+      CMP_PARAMETER_UINT("round-max", _roundMax)
+      CMP_PARAMETER_UINT("bad-score", _badScore)
+      CMP_PARAMETER_UINT("degree", _degree)
+      else if (AddQueueParameter(pname, pvalue)) {}
+
+    CMP_PARAMETER_END
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to initialize statistics
+  // -------------------------------------------------------------------------
+
+  void InitializeStatistics() {
+    INITIALIZE_COUNTER(num_prefetches, "Number of prefetches issued")
+    INITIALIZE_COUNTER(page_crossings, "Prefetches dropped at a page end")
+    INITIALIZE_COUNTER(phases, "Learning phases")
+    INITIALIZE_COUNTER(phases_off, "Learning phases that turned prefetching off")
+    INITIALIZE_COUNTER(covered_demands, "Demands covered by a prefetch")
+    InitializeQueueStatistics();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation starts
+  // -------------------------------------------------------------------------
+
+  void StartSimulation() {
+    _offsets.clear();
+    for (uint32 d = 1; d <= _maxOffset; d ++) {
+      uint32 n = d;
+      while (n % 2 == 0) n /= 2;
+      while (n % 3 == 0) n /= 3;
+      while (n % 5 == 0) n /= 5;
+      if (n == 1) _offsets.push_back(d);
+    }
+    if (_offsets.empty() || _rrTableSize == 0) {
+      fprintf(stderr, "Error: `%s' needs offsets and an RR table\n",
+              _name.c_str());
+      exit(-1);
+    }
+
+    _scores.assign(_offsets.size(), 0);
+    _rrTable.assign(_rrTableSize, 0);
+    _firstPrefetches.assign(_rrTableSize, 0);
+    _testIndex = 0;
+    _round = 0;
+    _best = 0;
+    _prefetchOn = true;
+    StartQueue();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called at a heart beat. Argument indicates cycles elapsed after
+  // previous heartbeat
+  // -------------------------------------------------------------------------
+
+  void HeartBeat(cycles_t hbCount) {
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation ends
+  // -------------------------------------------------------------------------
+
+  void EndSimulation() {
+    DUMP_STATISTICS;
+    CMP_LOG("best-offset = %u", _offsets[_best]);
+    CMP_LOG("prefetch-on = %u", _prefetchOn ? 1 : 0);
+    CLOSE_ALL_LOGS;
+  }
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to process a request. Return value indicates number of busy
+  // cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessRequest(MemoryRequest *request) {
+
+    if (request -> type == MemoryRequest::WRITE ||
+        request -> type == MemoryRequest::WRITEBACK ||
+        request -> type == MemoryRequest::PREFETCH) {
+      // do nothing
+      return 0;
+    }
+
+    if (!_prefetchOnWrite &&
+        (request -> type == MemoryRequest::READ_FOR_WRITE)) {
+      // do nothing
+      return 0;
+    }
+
+    addr_t vcla = VBLOCK_ADDRESS(request, _blockSize);
+    addr_t pcla = PBLOCK_ADDRESS(request, _blockSize);
+    addr_t block = pcla / _blockSize;
+    uint32 pageBlocks = _pageSize / _blockSize;
+    uint32 pageOffset = block % pageBlocks;
+
+    // was the block covered by a prefetch with the current offset?
+    uint32 offset = _offsets[_best];
+    if (_prefetchOn && pageOffset >= offset &&
+        InRRTable(block - offset)) {
+      request -> d_prefetched = true;
+      request -> d_prefID = _best;
+      INCREMENT(covered_demands);
+    }
+
+    Learn(block, pageOffset);
+
+    if (!_prefetchOn)
+      return 0;
+
+    offset = _offsets[_best];
+    for (uint32 i = 1; i <= _degree; i ++) {
+      if (pageOffset + i * offset >= pageBlocks) {
+        INCREMENT(page_crossings);
+        break;
+      }
+      addr_t distance = (addr_t)i * offset * _blockSize;
+      if (IssuePrefetch(request, vcla + distance, pcla + distance, _blockSize,
+                        _best) && i == 1)
+        _firstPrefetches[RRIndex(block + offset)] = block + offset + 1;
+      INCREMENT(num_prefetches);
+    }
+
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process the return of a request. Return value indicates
+  // number of busy cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessReturn(MemoryRequest *request) {
+
+    addr_t block = PBLOCK_ADDRESS(request, _blockSize) / _blockSize;
+
+    // if its the first prefetch of an access, record the base address of
+    // the access. delete the prefetch unless it goes on to fill the levels
+    // above
+    if (request -> iniType == MemoryRequest::COMPONENT &&
+        request -> iniPtr == this) {
+      uint32 offset = _offsets[request -> prefetcherID];
+      // with degree 1, every prefetch is the first of its access
+      addr_t &first = _firstPrefetches[RRIndex(block)];
+      if (_degree == 1 || first == block + 1) {
+        first = 0;
+        InsertRRTable(block - offset);
+      }
+      if (!FillsAbove(request))
+        request -> destroy = true;
+    }
+
+    // with prefetching off, record demand fills
+    else if (!_prefetchOn &&
+             (request -> type == MemoryRequest::READ ||
+              request -> type == MemoryRequest::READ_FOR_WRITE)) {
+      InsertRRTable(block);
+    }
+
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to test the next offset on an access
+  // -------------------------------------------------------------------------
+
+  void Learn(addr_t block, uint32 pageOffset) {
+
+    uint32 offset = _offsets[_testIndex];
+    if (pageOffset >= offset && InRRTable(block - offset)) {
+      _scores[_testIndex] ++;
+      if (_scores[_testIndex] >= _scoreMax) {
+        EndPhase();
+        return;
+      }
+    }
+
+    _testIndex ++;
+    if (_testIndex == _offsets.size()) {
+      _testIndex = 0;
+      _round ++;
+      if (_round == _roundMax)
+        EndPhase();
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to end a learning phase
+  // -------------------------------------------------------------------------
+
+  void EndPhase() {
+    INCREMENT(phases);
+
+    _best = 0;
+    for (uint32 i = 1; i < _scores.size(); i ++)
+      if (_scores[i] > _scores[_best]) _best = i;
+
+    _prefetchOn = (_scores[_best] > _badScore);
+    if (!_prefetchOn)
+      INCREMENT(phases_off);
+
+    _scores.assign(_scores.size(), 0);
+    _testIndex = 0;
+    _round = 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // RR table functions
+  // -------------------------------------------------------------------------
+
+  uint32 RRIndex(addr_t block) {
+    return (block ^ (block >> 8)) % _rrTableSize;
+  }
+
+  bool InRRTable(addr_t block) {
+    return _rrTable[RRIndex(block)] == block + 1;
+  }
+
+  void InsertRRTable(addr_t block) {
+    _rrTable[RRIndex(block)] = block + 1;
+  }
+};
+
+#endif // __CMP_BEST_OFFSET_PREFETCHER_H__
@@ -16,6 +16,7 @@
 // All components inherit from MemoryComponent
 #include "MemoryComponent.h"
 #include "GenericTagStore.h"
+#include "PrefetchAccounting.h"
 #include "Types.h"
 
 // -----------------------------------------------------------------------------
@@ -60,6 +61,7 @@ protected:
     addr_t vcla;
     addr_t pcla;
     uint32 reuse;
+    PrefetchTag prefetch;
     CacheTagValue() { dirty = false; reuse = 0; }
   };
 
@@ -80,6 +82,9 @@ protected:
   map <addr_t, EvictionData> _evictionData;
   map <uint32, uint64> _reuse;
 
+  // prefetch accounting
+  PrefetchAccounting _prefAccounting;
+
 
   // -------------------------------------------------------------------------
   // Declare counters
@@ -139,6 +144,7 @@ public:
       CMP_PARAMETER_BOOLEAN("serial-lookup", _serialLookup)
       CMP_PARAMETER_BOOLEAN("eviction-log", _evictionLog)
       CMP_PARAMETER_BOOLEAN("exclusive", _exclusive)
+      else if (_prefAccounting.AddParameter(pname, pvalue)) {}
 
     CMP_PARAMETER_END
   }
@@ -172,6 +178,17 @@ public:
     // compute the number of sets and initialize the tag store
     _numSets = _size / (_blockSize * _associativity);
     _tags.SetTagStoreParameters(_numSets, _associativity, _policy);
+    _prefAccounting.Start(_numCPUs, _numSets, _associativity);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when warm up ends
+  // -------------------------------------------------------------------------
+
+  void EndWarmUp() {
+    MemoryComponent::EndWarmUp();
+    _prefAccounting.Reset(*_simulatorCycle);
   }
 
     
@@ -182,6 +199,8 @@ public:
 
   void EndSimulation() {
     DUMP_STATISTICS;
+    _prefAccounting.Write(_simulationFolderName + "/" + _name +
+                          ".prefetch-accounting");
     if (_evictionLog) {
       string filename = _simulationFolderName + "/" + _name + ".eviction";
       FILE *file;
@@ -212,6 +231,19 @@ public:
     }
   }
 
+
+  // -------------------------------------------------------------------------
+  // Prefetch filter queries
+  // -------------------------------------------------------------------------
+
+  bool IsCache() {
+    return true;
+  }
+
+  bool HoldsBlock(addr_t vaddr, addr_t paddr) {
+    return _tags.lookup((_virtualTag ? vaddr : paddr) / _blockSize);
+  }
+
 protected:
 
   // -------------------------------------------------------------------------
@@ -274,6 +306,11 @@ protected:
         latency = _tagStoreLatency;
       }
 
+      if (_prefAccounting.Enabled() &&
+          request -> type != MemoryRequest::PREFETCH)
+        _prefAccounting.Demand(request, ctag,
+                               tagentry.valid ? &_tags[ctag].prefetch : NULL);
+
       request -> AddLatency(latency);
       return _tagStoreLatency;
 
@@ -379,8 +416,11 @@ protected:
                    request -> physicalAddress) / _blockSize;
 
     // else check if the block is already present in the cache
-    if (_tags.lookup(ctag))
+    if (_tags.lookup(ctag)) {
+      if (_prefAccounting.Enabled())
+        _prefAccounting.Return(request, _tags[ctag].prefetch);
       return 0;
+    }
 
     table_t <addr_t, CacheTagValue>::entry tagentry;
 
@@ -396,6 +436,9 @@ protected:
     // Need to clean this up
     request -> dirtyReply = false;
 
+    if (_prefAccounting.Enabled())
+      _prefAccounting.Fill(request, _tags[ctag].prefetch);
+
     EvictBlock(tagentry, request);
     return 0;
   }
@@ -419,6 +462,8 @@ protected:
         _reuse[tagentry.value.reuse] ++;
       }
       INCREMENT(evictions);
+      if (_prefAccounting.Enabled())
+        _prefAccounting.Evict(tagentry.key, tagentry.value.prefetch, request);
       if (tagentry.value.dirty) {
         if (_evictionLog) {
           _evictionData[tagentry.key].dirty ++;
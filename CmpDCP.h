@@ -12,9 +12,8 @@
 // Module includes
 // -----------------------------------------------------------------------------
 
-#include "MemoryComponent.h"
-#include "Types.h"
-#include "GenericTagStore.h"
+#include "LLCEngine.h"
+#include "LLCHooks.h"
 
 #include "VictimTagStore.h"
 
@@ -25,31 +24,47 @@
 #define SET_DUEL_PRIME 443
 
 // -----------------------------------------------------------------------------
-// Class: CmpDCP
+// Structure: LLCDCPTagEntry
 // Description:
-//    Last-level cache with decoupled caching and prefetching.
-//
-// The changes to the baseline last-level cache are marked with a
-// comment DCP CHANGE.
+//    Tag entry for decoupled caching and prefetching. A block is fake
+//    demoted by a fake read and dcp demoted by its first use.
+// -----------------------------------------------------------------------------
+
+struct LLCDCPTagEntry : public LLCPrefetchTagEntry {
+  bool fakeDemoted;
+  bool dcpDemoted;
+  LLCDCPTagEntry() {
+    fakeDemoted = false;
+    dcpDemoted = false;
+  }
+};
+
+
+// -----------------------------------------------------------------------------
+// Class: LLCDecoupledPrefetch
+// Description:
+//    Decoupled caching and prefetching. The first demand hit to a prefetched
+//    block demotes it to low priority, as the block was likely prefetched
+//    for that single use. A demand EAF (reuse-prediction) can keep reused
+//    blocks at high priority, and a per-prefetcher accuracy predictor
+//    (accuracy-prediction) inserts inaccurate prefetches at low priority or
+//    drops them. Keeps the prefetch counters itself, so it does not stack on
+//    the prefetch monitor.
 // -----------------------------------------------------------------------------
 
-class CmpDCP : public MemoryComponent {
+template <class Base>
+class LLCDecoupledPrefetch : public Base {
 
 protected:
 
+  LLC_HOOK_MODULE_MEMBERS(Base)
+
+  typedef LLCPrefetchTagEntry P;
+
   // -------------------------------------------------------------------------
   // Parameters
   // -------------------------------------------------------------------------
 
-  uint32 _size;
-  uint32 _blockSize;
-  uint32 _associativity;
-  string _policy;
-
-  uint32 _tagStoreLatency;
-  uint32 _dataStoreLatency;
-
-  // DCP parameters
   bool _prefetchRequestPromote;
   bool _reusePrediction;
   bool _demandReusePrediction;
@@ -63,52 +78,10 @@ protected:
   uint32 _accuracyTableSize; // same as the prefetch table size
   uint32 _prefetchDistance;
   uint32 _accuracyCounterMax;
-  
 
   // -------------------------------------------------------------------------
   // Private members
   // -------------------------------------------------------------------------
- 
-  enum PrefetchState {
-    NOT_PREFETCHED,
-    PREFETCHED_UNUSED,
-    PREFETCHED_USED,
-    PREFETCHED_REUSED,
-  };
-  
-  struct TagEntry {
-    bool dirty;
-    addr_t vcla;
-    addr_t pcla;
-    uint32 appID;
-
-    // prefetch related info
-    PrefetchState prefState;
-    uint32 prefID;
-    bool lowPriority;
-    bool fakeDemoted;
-    bool dcpDemoted;
-
-    // miss counter information
-    uint64 prefetchMiss;
-    uint64 useMiss;
-    
-    // cycle information
-    cycles_t prefetchCycle;
-    cycles_t useCycle;
-    
-    TagEntry() {
-      dirty = false;
-      lowPriority = false;
-      fakeDemoted = false;
-      dcpDemoted = false;
-      prefState = NOT_PREFETCHED;
-    }
-   };
-
-  // tag store
-  uint32 _numSets;
-  generic_tagstore_t <addr_t, TagEntry> _tags;
 
   // D-EAF reuse predictor
   struct SetEntry {
@@ -120,7 +93,6 @@ protected:
   vector <SetEntry> _duelInfo;
   saturating_counter _psel;
   uint32 _pselThreshold;
-  
 
   // accuracy predictor
   struct AccuracyEntry {
@@ -130,24 +102,16 @@ protected:
 
   vector <AccuracyEntry> _accuracyTable;
 
-  vector <uint64> _missCounter;
+  vector <uint32> _missCounter;
   vector <uint64> _procMisses;
 
-
   // -------------------------------------------------------------------------
   // Declare Counters
   // -------------------------------------------------------------------------
 
-  NEW_COUNTER(accesses);
-  NEW_COUNTER(reads);
-  NEW_COUNTER(writebacks);
-  NEW_COUNTER(misses);
-  NEW_COUNTER(evictions);
-  NEW_COUNTER(dirty_evictions);
-
   NEW_COUNTER(prefetches);
   NEW_COUNTER(prefetch_misses);
-  
+
   NEW_COUNTER(fake_reads);
   NEW_COUNTER(fake_read_hits);
 
@@ -157,7 +121,7 @@ protected:
   NEW_COUNTER(predicted_accurate);
   NEW_COUNTER(accurate_predicted_inaccurate);
   NEW_COUNTER(inaccurate_predicted_accurate);
-  
+
   NEW_COUNTER(unused_prefetches);
   NEW_COUNTER(used_prefetches);
   NEW_COUNTER(unreused_prefetches);
@@ -176,20 +140,15 @@ protected:
   NEW_COUNTER(prefetch_lifetime_miss);
 
   NEW_COUNTER(eaf_hits);
-  
-public:
 
-  // -------------------------------------------------------------------------
-  // Constructor. It cannot take any arguments
-  // -------------------------------------------------------------------------
+  // entry of the accuracy table for a prefetcher
+  AccuracyEntry &Accuracy(uint32 prefID) {
+    return _accuracyTable[_perEntryAcc ? prefID : 0];
+  }
+
+public:
 
-  CmpDCP() {
-    _size = 1024;
-    _blockSize = 64;
-    _associativity = 16;
-    _tagStoreLatency = 6;
-    _dataStoreLatency = 15;
-    _policy = "lru";
+  LLCDecoupledPrefetch() {
     _prefetchRequestPromote = false;
     _reusePrediction = false;
     _demandReusePrediction = false;
@@ -205,27 +164,10 @@ public:
     _handleFake = false;
   }
 
+  bool AddHookParameter(string pname, string pvalue) {
 
-  // -------------------------------------------------------------------------
-  // Virtual functions to be implemented by the components
-  // -------------------------------------------------------------------------
-
-  // -------------------------------------------------------------------------
-  // Function to add a parameter to the component
-  // -------------------------------------------------------------------------
-
-  void AddParameter(string pname, string pvalue) {
-      
     CMP_PARAMETER_BEGIN
 
-      // Add the list of parameters to the component here
-      CMP_PARAMETER_UINT("size", _size)
-      CMP_PARAMETER_UINT("block-size", _blockSize)
-      CMP_PARAMETER_UINT("associativity", _associativity)
-      CMP_PARAMETER_STRING("policy", _policy)
-      CMP_PARAMETER_UINT("tag-store-latency", _tagStoreLatency)
-      CMP_PARAMETER_UINT("data-store-latency", _dataStoreLatency)
-
       CMP_PARAMETER_BOOLEAN("prefetch-request-promote", _prefetchRequestPromote)
       CMP_PARAMETER_BOOLEAN("reuse-prediction", _reusePrediction)
       CMP_PARAMETER_BOOLEAN("demand-reuse-prediction", _demandReusePrediction)
@@ -235,27 +177,18 @@ public:
       CMP_PARAMETER_BOOLEAN("no-dcp", _noDCP)
       CMP_PARAMETER_BOOLEAN("use-accuracy-prefetch-hit", _useAccuracyPrefetchHit)
       CMP_PARAMETER_BOOLEAN("handle-fake", _handleFake)
-      
+
       CMP_PARAMETER_UINT("accuracy-table-size", _accuracyTableSize)
       CMP_PARAMETER_UINT("prefetch-distance", _prefetchDistance)
       CMP_PARAMETER_UINT("accuracy-counter-max", _accuracyCounterMax)
+      else return Base::AddHookParameter(pname, pvalue);
 
-    CMP_PARAMETER_END
+    return true;
   }
 
+  void InitializeHookStatistics() {
 
-  // -------------------------------------------------------------------------
-  // Function to initialize statistics
-  // -------------------------------------------------------------------------
-
-  void InitializeStatistics() {
-
-    INITIALIZE_COUNTER(accesses, "Total Accesses")
-    INITIALIZE_COUNTER(reads, "Read Accesses")
-    INITIALIZE_COUNTER(writebacks, "Writeback Accesses")
-    INITIALIZE_COUNTER(misses, "Total Misses")
-    INITIALIZE_COUNTER(evictions, "Evictions")
-    INITIALIZE_COUNTER(dirty_evictions, "Dirty Evictions")
+    Base::InitializeHookStatistics();
 
     INITIALIZE_COUNTER(prefetches, "Total prefetches")
     INITIALIZE_COUNTER(prefetch_misses, "Prefetch misses")
@@ -264,7 +197,7 @@ public:
     INITIALIZE_COUNTER(fake_read_hits, "Fake read hits")
     INITIALIZE_COUNTER(incorrect_fake_demotions, "Incorrect fake demotions")
     INITIALIZE_COUNTER(incorrect_dcp_demotions, "Incorrect dcp demotions")
-      
+
     INITIALIZE_COUNTER(predicted_accurate, "Prefetches predicted to be accurate")
     INITIALIZE_COUNTER(accurate_predicted_inaccurate, "Incorrect accuracy predictions")
     INITIALIZE_COUNTER(inaccurate_predicted_accurate, "Incorrect accuracy predictions")
@@ -274,12 +207,12 @@ public:
     INITIALIZE_COUNTER(unreused_prefetches, "Unreused prefetches")
     INITIALIZE_COUNTER(reused_prefetches, "Reused prefetches")
 
-      INITIALIZE_COUNTER(evicted_pref, "Evicted prefetch")
-      INITIALIZE_COUNTER(evicted_unused_pref, "Evicted unused prefetch")
-      INITIALIZE_COUNTER(evicted_unused_pref_faked, "Evicted unused prefetch faked")
-      INITIALIZE_COUNTER(evicted_usedonce_pref, "Evicted used once prefetch")
-      INITIALIZE_COUNTER(evicted_reused_pref, "Evicted prefetch")
-      
+    INITIALIZE_COUNTER(evicted_pref, "Evicted prefetch")
+    INITIALIZE_COUNTER(evicted_unused_pref, "Evicted unused prefetch")
+    INITIALIZE_COUNTER(evicted_unused_pref_faked, "Evicted unused prefetch faked")
+    INITIALIZE_COUNTER(evicted_usedonce_pref, "Evicted used once prefetch")
+    INITIALIZE_COUNTER(evicted_reused_pref, "Evicted prefetch")
+
     INITIALIZE_COUNTER(prefetch_use_cycle, "Prefetch-to-use Cycles")
     INITIALIZE_COUNTER(prefetch_use_miss, "Prefetch-to-use Misses")
 
@@ -287,18 +220,14 @@ public:
     INITIALIZE_COUNTER(prefetch_lifetime_miss, "Prefetch-lifetime Misses")
 
     INITIALIZE_COUNTER(eaf_hits, "EAF hits")
-  }
 
+    INITIALIZE_VECTOR_COUNTER(_procMisses, "misses", "Misses of each cpu")
+  }
 
-  // -------------------------------------------------------------------------
-  // Function called when simulation starts
-  // -------------------------------------------------------------------------
+  void StartHooks() {
 
-  void StartSimulation() {
+    Base::StartHooks();
 
-    // compute number of sets
-    _numSets = (_size * 1024) / (_blockSize * _associativity);
-    _tags.SetTagStoreParameters(_numSets, _associativity, _policy);
     _missCounter.resize(_numSets, 0);
     _procMisses.resize(_numCPUs, 0);
 
@@ -322,449 +251,323 @@ public:
     // check if an accuracy predictor is needed
     if (_accuracyPrediction) {
       _accuracyTable.resize(_accuracyTableSize);
-      for (int i = 0; i < _accuracyTableSize; i ++) {
+      for (uint32 i = 0; i < _accuracyTableSize; i ++) {
         _accuracyTable[i].counter.set_max(_accuracyCounterMax);
         _accuracyTable[i].ipEAF.SetTagStoreParameters(_prefetchDistance, 1, "fifo");
       }
     }
   }
 
-
-  // -------------------------------------------------------------------------
-  // Function called at a heart beat. Argument indicates cycles elapsed after
-  // previous heartbeat
-  // -------------------------------------------------------------------------
-
-  void HeartBeat(cycles_t hbCount) {
-  }
-
   void EndProcWarmUp(uint32 cpuID) {
+    Base::EndProcWarmUp(cpuID);
     _procMisses[cpuID] = 0;
   }
 
-  void EndSimulation() {
-    DUMP_STATISTICS;
-    for (uint32 i = 0; i < _numCPUs; i ++)
-      CMP_LOG("misses-%u = %llu", i, _procMisses[i]);
-    CLOSE_ALL_LOGS;
+  void OnAccess(MemoryRequest *request) {
+    if (request -> type == MemoryRequest::PREFETCH) {
+      INCREMENT(prefetches);
+    }
+    else
+      Base::OnAccess(request);
   }
 
+  // the replacement state is updated in OnHit, depending on the block
+  bool LookupAndPromote(MemoryRequest *request, addr_t ctag) {
+    return _tags.lookup(ctag);
+  }
 
-protected:
-
-  // -------------------------------------------------------------------------
-  // Function to process a request. Return value indicates number of busy
-  // cycles for the component.
-  // -------------------------------------------------------------------------
-
-  cycles_t ProcessRequest(MemoryRequest *request) {
-
-    // update stats
-    INCREMENT(accesses);
-
-    cycles_t latency;
+  void OnHit(MemoryRequest *request, addr_t ctag) {
 
-    // NO WRITES (Complete or partial)
-    if (request -> type == MemoryRequest::WRITE || 
-        request -> type == MemoryRequest::PARTIALWRITE) {
-      fprintf(stderr, "LLC cannot handle direct writes (yet)\n");
-      exit(0);
-    }
+    Base::OnHit(request, ctag);
 
-    // compute the cache block tag
-    addr_t ctag = VADDR(request) / _blockSize;
-    uint32 index = _tags.index(ctag);
-
-    // check if its a read or write back
-    switch (request -> type) {
-
-    // READ request
-    case MemoryRequest::READ:
-    case MemoryRequest::READ_FOR_WRITE:
-
-      INCREMENT(reads);
-          
-      if (_tags.lookup(ctag)) {
-
-        request -> serviced = true;
-        request -> AddLatency(_tagStoreLatency + _dataStoreLatency);
-
-        // DCP CHANGE: Update state only for demand-fetched or
-        // already used blocks. For prefetched blocks, depromote
-        // to low priority. Code moved into switch case.
-        
-        // read to update replacement policy
-        // _tags.read(ctag);
-        
-        // read to update state
-        TagEntry &tagentry = _tags[ctag];
-        policy_value_t priority;
-        
-        // check the prefetched state
-        switch (tagentry.prefState) {
-        case PREFETCHED_UNUSED:
-          // update state
-          tagentry.prefState = PREFETCHED_USED;
-          tagentry.useMiss = _missCounter[index];
-          tagentry.useCycle = request -> currentCycle;
-
-          // check if block was fake demoted
-          if (tagentry.fakeDemoted)
-            INCREMENT(incorrect_fake_demotions);
-          tagentry.fakeDemoted = false;
-
-          // update accuracy
-          if (_accuracyPrediction) {
-            uint32 prefID = _perEntryAcc ? tagentry.prefID : 0;
-            _accuracyTable[prefID].counter.increment();
-            if (tagentry.lowPriority) {
-              tagentry.lowPriority = false;
-              INCREMENT(accurate_predicted_inaccurate);
-            }
-          }
-
-          // DCP CHANGE: Depromote to low priority
-          // DCP-RP CHANGE: Check if we need to use reuse predictor
-          priority = POLICY_HIGH;
-          if (!_noDCP) {
-            priority = POLICY_LOW;
-            tagentry.dcpDemoted = true;
-          }
-          
-          if (_reusePrediction) {
-            policy_value_t eafPriority =
-              _eaf.test(ctag) ? POLICY_HIGH : POLICY_LOW;
-            SetEntry sentry = _duelInfo[_tags.index(ctag)];
-            if ((sentry.leader && sentry.eaf) || (_psel > _pselThreshold / 2))
-              priority = eafPriority; 
-            else
-              priority = POLICY_HIGH;
-
-            if (priority == POLICY_LOW) tagentry.dcpDemoted = true;
-          }
-          
-          _tags.read(ctag, priority);
-
-          // update counters
-          INCREMENT(used_prefetches);
-          break;
-          
-        case PREFETCHED_USED:
-          _tags.read(ctag, POLICY_HIGH);
-          tagentry.prefState = PREFETCHED_REUSED;
-          if (tagentry.dcpDemoted)
-            INCREMENT(incorrect_dcp_demotions);
-          tagentry.dcpDemoted = false;
-          INCREMENT(reused_prefetches);
-          break;
-          
-        case NOT_PREFETCHED:
-        case PREFETCHED_REUSED:
+    if (request -> type == MemoryRequest::PREFETCH) {
+      // if accuracy predictor should be used on prefetch hits
+      if (_accuracyPrediction && _useAccuracyPrefetchHit) {
+        // promote if accurate prefetch
+        if (Accuracy(request -> prefetcherID).counter >
+            (_accuracyCounterMax / 2)) {
           _tags.read(ctag, POLICY_HIGH);
-          // do nothing
-          break;
+          INCREMENT(predicted_accurate);
         }
-        
       }
-      else {
-
-        // if reuse prediction is used, update predictor
-        if (_reusePrediction || _demandReusePrediction) {
-          SetEntry sentry = _duelInfo[_tags.index(ctag)];
-          if (sentry.leader) {
-            if (sentry.eaf)
-              _psel.decrement();
-            else
-              _psel.increment();
-          }
-        }
+      // if we should promote on a prefetch request hit?
+      // else do nothing
+      else if (_prefetchRequestPromote)
+        _tags.read(ctag, POLICY_HIGH);
+      return;
+    }
 
-        // check ipEAF if necessary
-        if (_accuracyPrediction) {
-          if (request -> d_prefetched) {
-            uint32 prefID = _perEntryAcc ? request -> d_prefID : 0;
-            AccuracyEntry &accEntry = _accuracyTable[prefID];
-            if (accEntry.ipEAF.lookup(ctag)) {
-              accEntry.ipEAF.invalidate(ctag);
-              accEntry.counter.increment();
-              INCREMENT(accurate_predicted_inaccurate);
-            }
-          }
+    TagEntry &tagentry = _tags[ctag];
+    policy_value_t priority;
+
+    // check the prefetched state
+    switch (tagentry.prefState) {
+    case P::PREFETCHED_UNUSED:
+      // update state
+      tagentry.prefState = P::PREFETCHED_USED;
+      tagentry.useMiss = _missCounter[_tags.index(ctag)];
+      tagentry.useCycle = request -> currentCycle;
+
+      // check if block was fake demoted
+      if (tagentry.fakeDemoted)
+        INCREMENT(incorrect_fake_demotions);
+      tagentry.fakeDemoted = false;
+
+      // update accuracy
+      if (_accuracyPrediction) {
+        Accuracy(tagentry.prefID).counter.increment();
+        if (tagentry.lowPriority) {
+          tagentry.lowPriority = false;
+          INCREMENT(accurate_predicted_inaccurate);
         }
-        
-        INCREMENT(misses);
-        request -> AddLatency(_tagStoreLatency);
-        // _missCounter[index] ++;
-        if (!_done.test(request -> cpuID)) _procMisses[request -> cpuID] ++;
       }
-          
-      return _tagStoreLatency;
-
-    case MemoryRequest::FAKE_READ:
-      INCREMENT(fake_reads);
-      if (_handleFake) {
-        if (_tags.lookup(ctag)) {
-          TagEntry &tagentry = _tags[ctag];
-          if (tagentry.prefState == PREFETCHED_UNUSED) {
-            INCREMENT(fake_read_hits);
-            tagentry.fakeDemoted = true;
-            tagentry.useMiss = _missCounter[index];
-            tagentry.useCycle = request -> currentCycle;
-            // demote the block
-            _tags.read(ctag, POLICY_LOW);
-          }
-        }          
+
+      // demote to low priority, unless the reuse predictor says otherwise
+      priority = POLICY_HIGH;
+      if (!_noDCP) {
+        priority = POLICY_LOW;
+        tagentry.dcpDemoted = true;
       }
-      request -> serviced = true;
-      return 0;
 
-    case MemoryRequest::PREFETCH:
+      if (_reusePrediction) {
+        policy_value_t eafPriority =
+          _eaf.test(ctag) ? POLICY_HIGH : POLICY_LOW;
+        SetEntry &sentry = _duelInfo[_tags.index(ctag)];
+        if ((sentry.leader && sentry.eaf) || (_psel > _pselThreshold / 2))
+          priority = eafPriority;
+        else
+          priority = POLICY_HIGH;
 
-      INCREMENT(prefetches);
-          
-      if (_tags.lookup(ctag)) {
-        request -> serviced = true;
-        request -> AddLatency(_tagStoreLatency + _dataStoreLatency);
-
-        
-        // if accuracy predictor should be used on prefetch hits
-        if (_accuracyPrediction && _useAccuracyPrefetchHit) {
-          // promote if accurate prefetch
-          uint32 prefID = _perEntryAcc ? request -> prefetcherID : 0;
-          AccuracyEntry &accEntry = _accuracyTable[prefID];
-          if (accEntry.counter > (_accuracyCounterMax / 2)) {
-            _tags.read(ctag, POLICY_HIGH);
-            INCREMENT(predicted_accurate);
-          }
-        }
-        
-        // read to update replacement policy
-        // if we shoule promote on a prefetch request hit?
-        // else do nothing
-        else if (_prefetchRequestPromote)
-          _tags.read(ctag, POLICY_HIGH);
-      }
-      else { 
-        if (_accuracyPrediction && _drop) {
-          uint32 prefID = _perEntryAcc ? request -> prefetcherID : 0;
-          AccuracyEntry &accEntry = _accuracyTable[prefID];
-          if (accEntry.counter <= (_accuracyCounterMax / 2)) {
-            request -> serviced = true;
-            if (accEntry.ipEAF.insert(ctag, true).valid)
-              accEntry.counter.decrement();
-            return _tagStoreLatency;
-          }
-        }
-        //        else {
-        //          _missCounter[index] ++;
-        //        }
-        INCREMENT(prefetch_misses);
-        request -> AddLatency(_tagStoreLatency);
+        if (priority == POLICY_LOW) tagentry.dcpDemoted = true;
       }
-          
-      return _tagStoreLatency;
 
-      
-    // WRITEBACK request
-    case MemoryRequest::WRITEBACK:
+      _tags.read(ctag, priority);
+
+      // update counters
+      INCREMENT(used_prefetches);
+      break;
+
+    case P::PREFETCHED_USED:
+      _tags.read(ctag, POLICY_HIGH);
+      tagentry.prefState = P::PREFETCHED_REUSED;
+      if (tagentry.dcpDemoted)
+        INCREMENT(incorrect_dcp_demotions);
+      tagentry.dcpDemoted = false;
+      INCREMENT(reused_prefetches);
+      break;
+
+    case P::NOT_PREFETCHED:
+    case P::PREFETCHED_REUSED:
+      _tags.read(ctag, POLICY_HIGH);
+      break;
+    }
+  }
 
-      INCREMENT(writebacks);
+  void OnMiss(MemoryRequest *request, addr_t ctag) {
 
-      if (_tags.lookup(ctag))
-        _tags[ctag].dirty = true;
-      else
-        INSERT_BLOCK(ctag, true, request);
-
-      request -> serviced = true;
-      return _tagStoreLatency;
+    if (request -> type == MemoryRequest::PREFETCH) {
+      INCREMENT(prefetch_misses);
+      return;
     }
-  }
 
+    // if reuse prediction is used, update predictor
+    if (_reusePrediction || _demandReusePrediction) {
+      SetEntry &sentry = _duelInfo[_tags.index(ctag)];
+      if (sentry.leader) {
+        if (sentry.eaf)
+          _psel.decrement();
+        else
+          _psel.increment();
+      }
+    }
 
-  // -------------------------------------------------------------------------
-  // Function to process the return of a request. Return value indicates
-  // number of busy cycles for the component.
-  // -------------------------------------------------------------------------
-    
-  cycles_t ProcessReturn(MemoryRequest *request) { 
-
-    // if its a writeback from this component, delete it
-    if (request -> iniType == MemoryRequest::COMPONENT &&
-        request -> iniPtr == this) {
-      request -> destroy = true;
-      return 0;
+    // check ipEAF if necessary
+    if (_accuracyPrediction && request -> d_prefetched) {
+      AccuracyEntry &accEntry = Accuracy(request -> d_prefID);
+      if (accEntry.ipEAF.lookup(ctag)) {
+        accEntry.ipEAF.invalidate(ctag);
+        accEntry.counter.increment();
+        INCREMENT(accurate_predicted_inaccurate);
+      }
     }
 
-    // get the cache block tag
-    addr_t ctag = VADDR(request) / _blockSize;
+    Base::OnMiss(request, ctag);
+    if (!_done.test(request -> cpuID)) _procMisses[request -> cpuID] ++;
+  }
 
-    // if the block is already present, return
-    if (_tags.lookup(ctag))
-      return 0;
+  // drop a missing prefetch of an inaccurate prefetcher
+  bool Drop(MemoryRequest *request, addr_t ctag) {
 
-    INSERT_BLOCK(ctag, false, request);
+    if (request -> type == MemoryRequest::PREFETCH &&
+        _accuracyPrediction && _drop) {
+      AccuracyEntry &accEntry = Accuracy(request -> prefetcherID);
+      if (accEntry.counter <= (_accuracyCounterMax / 2)) {
+        if (accEntry.ipEAF.insert(ctag, true).valid)
+          accEntry.counter.decrement();
+        return true;
+      }
+    }
+    return Base::Drop(request, ctag);
+  }
 
+  // a fake read demotes an unused prefetched block
+  cycles_t OtherRequest(MemoryRequest *request, addr_t ctag,
+                        cycles_t busyCycles) {
+
+    if (request -> type != MemoryRequest::FAKE_READ)
+      return Base::OtherRequest(request, ctag, busyCycles);
+
+    INCREMENT(fake_reads);
+    if (_handleFake && _tags.lookup(ctag)) {
+      TagEntry &tagentry = _tags[ctag];
+      if (tagentry.prefState == P::PREFETCHED_UNUSED) {
+        INCREMENT(fake_read_hits);
+        tagentry.fakeDemoted = true;
+        tagentry.useMiss = _missCounter[_tags.index(ctag)];
+        tagentry.useCycle = request -> currentCycle;
+        // demote the block
+        _tags.read(ctag, POLICY_LOW);
+      }
+    }
+    request -> serviced = true;
     return 0;
   }
 
+  policy_value_t InsertionPriority(MemoryRequest *request, addr_t ctag) {
 
-  // -------------------------------------------------------------------------
-  // Function to insert a block into the cache
-  // -------------------------------------------------------------------------
-
-  void INSERT_BLOCK(addr_t ctag, bool dirty, MemoryRequest *request) {
-
-    table_t <addr_t, TagEntry>::entry tagentry;
-    policy_value_t priority = POLICY_HIGH;
+    policy_value_t priority = Base::InsertionPriority(request, ctag);
 
     // if there is demand reuse prediction
     if (_demandReusePrediction &&
         request -> type != MemoryRequest::PREFETCH) {
-      policy_value_t eafPriority = _eaf.test(ctag) ? POLICY_HIGH : POLICY_BIMODAL;
-      SetEntry sentry = _duelInfo[_tags.index(ctag)];
-      if ((sentry.leader && sentry.eaf) || (_psel > _pselThreshold / 2)) {
-        priority = eafPriority; 
-      }
-      else {
+      policy_value_t eafPriority =
+        _eaf.test(ctag) ? POLICY_HIGH : POLICY_BIMODAL;
+      SetEntry &sentry = _duelInfo[_tags.index(ctag)];
+      if ((sentry.leader && sentry.eaf) || (_psel > _pselThreshold / 2))
+        priority = eafPriority;
+      else
         priority = POLICY_HIGH;
-      }
     }
 
-
     // if there is accuracy prediction
     if (_accuracyPrediction &&
         request -> type == MemoryRequest::PREFETCH) {
-      uint32 prefID = _perEntryAcc ? request -> prefetcherID : 0;
-      if (_accuracyTable[prefID].counter >
+      if (Accuracy(request -> prefetcherID).counter >
           (_accuracyCounterMax / 2)) {
         priority = POLICY_HIGH;
         INCREMENT(predicted_accurate);
       }
-      else {
+      else
         priority = POLICY_LOW;
-      }
-    }      
+    }
 
-    // insert the block into the cache
-    tagentry = _tags.insert(ctag, TagEntry(), priority);
-    _tags[ctag].vcla = BLOCK_ADDRESS(VADDR(request), _blockSize);
-    _tags[ctag].pcla = BLOCK_ADDRESS(PADDR(request), _blockSize);
-    _tags[ctag].dirty = dirty;
-    _tags[ctag].appID = request -> cpuID;
-    _tags[ctag].prefState = NOT_PREFETCHED;
+    return priority;
+  }
 
-    uint32 index = _tags.index(ctag);
+  void OnInsert(MemoryRequest *request, addr_t ctag, TagEntry &entry,
+                policy_value_t priority) {
 
-    // Handle prefetch
-    if (request -> type == MemoryRequest::PREFETCH) {
-      _tags[ctag].prefState = PREFETCHED_UNUSED;
-      _tags[ctag].prefID = request -> prefetcherID;
-      _tags[ctag].prefetchCycle = request -> currentCycle;
-      _tags[ctag].prefetchMiss = _missCounter[index];
-      if (priority == POLICY_LOW) {
-        _tags[ctag].lowPriority = true;
-      }
+    Base::OnInsert(request, ctag, entry, priority);
 
+    entry.prefState = P::NOT_PREFETCHED;
+    if (request -> type == MemoryRequest::PREFETCH) {
+      entry.prefState = P::PREFETCHED_UNUSED;
+      entry.prefID = request -> prefetcherID;
+      entry.prefetchCycle = request -> currentCycle;
+      entry.prefetchMiss = _missCounter[_tags.index(ctag)];
+      if (priority == POLICY_LOW)
+        entry.lowPriority = true;
     }
+  }
 
-    // if the evicted tag entry is valid
-    if (tagentry.valid) {
-      INCREMENT(evictions);
+  void OnEvict(MemoryRequest *request, TagTableEntry &victim) {
 
-      TagEntry evicted = tagentry.value;
-      
-      // insert into eaf it its not an unused prefetch
-      if (_reusePrediction) {
-        if (evicted.prefState != PREFETCHED_UNUSED)
-          _eaf.insert(tagentry.key);
-      }
+    Base::OnEvict(request, victim);
 
-      if (evicted.prefState != NOT_PREFETCHED) {
-        INCREMENT(evicted_pref);
-      }
+    TagEntry &evicted = victim.value;
 
-      uint32 evicted_index = _tags.index(tagentry.key);
+    // insert into eaf it its not an unused prefetch
+    if (_reusePrediction && evicted.prefState != P::PREFETCHED_UNUSED)
+      _eaf.insert(victim.key);
 
-      uint64 pref_lifetime_miss = 0;
-      uint64 pref_lifetime_cycle = 0;
+    if (evicted.prefState != P::NOT_PREFETCHED)
+      INCREMENT(evicted_pref);
 
-      // check prefetched state
-      switch (evicted.prefState) {
-      case PREFETCHED_UNUSED:
-        INCREMENT(unused_prefetches);
-        INCREMENT(evicted_unused_pref);
-        if (evicted.fakeDemoted) {
-          INCREMENT(evicted_unused_pref_faked);
-          pref_lifetime_cycle = evicted.useCycle - evicted.prefetchCycle;
-          pref_lifetime_miss = evicted.useMiss - evicted.prefetchMiss + 1;
-        }
-        else {
-          pref_lifetime_cycle = request -> currentCycle - evicted.prefetchCycle;
-          pref_lifetime_miss = _missCounter[evicted_index] - evicted.prefetchMiss;
-        }
+    uint32 index = _tags.index(victim.key);
+
+    uint64 pref_lifetime_miss = 0;
+    uint64 pref_lifetime_cycle = 0;
 
-        // if accuracy prediction is enabled, update the accuracy table
-        if (_accuracyPrediction) {
-          uint32 prefID = _perEntryAcc ? tagentry.value.prefID : 0;
-          AccuracyEntry &accEntry = _accuracyTable[prefID];
-          if (tagentry.value.lowPriority) {
-            if (accEntry.ipEAF.insert(tagentry.key, true).valid)
-              accEntry.counter.decrement();
-          }
-          else {
+    // check prefetched state
+    switch (evicted.prefState) {
+    case P::PREFETCHED_UNUSED:
+      INCREMENT(unused_prefetches);
+      INCREMENT(evicted_unused_pref);
+      if (evicted.fakeDemoted) {
+        INCREMENT(evicted_unused_pref_faked);
+        pref_lifetime_cycle = evicted.useCycle - evicted.prefetchCycle;
+        pref_lifetime_miss = evicted.useMiss - evicted.prefetchMiss + 1;
+      }
+      else {
+        pref_lifetime_cycle = request -> currentCycle - evicted.prefetchCycle;
+        pref_lifetime_miss = _missCounter[index] - evicted.prefetchMiss;
+      }
+
+      // if accuracy prediction is enabled, update the accuracy table
+      if (_accuracyPrediction) {
+        AccuracyEntry &accEntry = Accuracy(evicted.prefID);
+        if (evicted.lowPriority) {
+          if (accEntry.ipEAF.insert(victim.key, true).valid)
             accEntry.counter.decrement();
-            INCREMENT(inaccurate_predicted_accurate);
-          }
-        }
-        
-        break;
-        
-      case PREFETCHED_USED:
-        INCREMENT(unreused_prefetches);
-        INCREMENT(evicted_usedonce_pref);
-        if (tagentry.value.dcpDemoted) {
-          pref_lifetime_cycle = evicted.useCycle - evicted.prefetchCycle;
-          pref_lifetime_miss = evicted.useMiss - evicted.prefetchMiss + 1;
         }
         else {
-          pref_lifetime_cycle = request -> currentCycle - evicted.prefetchCycle;
-          pref_lifetime_miss = _missCounter[evicted_index] - evicted.prefetchMiss;
+          accEntry.counter.decrement();
+          INCREMENT(inaccurate_predicted_accurate);
         }
-        break;
-        
-      case PREFETCHED_REUSED:
-        INCREMENT(evicted_reused_pref);
+      }
+      break;
+
+    case P::PREFETCHED_USED:
+      INCREMENT(unreused_prefetches);
+      INCREMENT(evicted_usedonce_pref);
+      if (evicted.dcpDemoted) {
         pref_lifetime_cycle = evicted.useCycle - evicted.prefetchCycle;
         pref_lifetime_miss = evicted.useMiss - evicted.prefetchMiss + 1;
-        break;
-        
-      case NOT_PREFETCHED:
-        // do nothing
-        break;
       }
+      else {
+        pref_lifetime_cycle = request -> currentCycle - evicted.prefetchCycle;
+        pref_lifetime_miss = _missCounter[index] - evicted.prefetchMiss;
+      }
+      break;
 
-      ADD_TO_COUNTER(prefetch_lifetime_miss, pref_lifetime_miss);
-      ADD_TO_COUNTER(prefetch_lifetime_cycle, pref_lifetime_cycle);
-
+    case P::PREFETCHED_REUSED:
+      INCREMENT(evicted_reused_pref);
+      pref_lifetime_cycle = evicted.useCycle - evicted.prefetchCycle;
+      pref_lifetime_miss = evicted.useMiss - evicted.prefetchMiss + 1;
+      break;
 
-      if (!tagentry.value.lowPriority && !tagentry.value.fakeDemoted
-          && !tagentry.value.dcpDemoted) {
-        _missCounter[evicted_index] ++;
-      }
-      
-      if (tagentry.value.dirty) {
-        INCREMENT(dirty_evictions);
-        MemoryRequest *writeback =
-          new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                            MemoryRequest::WRITEBACK, request -> cmpID, 
-                            tagentry.value.vcla, tagentry.value.pcla, _blockSize,
-                            request -> currentCycle);
-        writeback -> icount = request -> icount;
-        writeback -> ip = request -> ip;
-        SendToNextComponent(writeback);
-      }
+    case P::NOT_PREFETCHED:
+      // do nothing
+      break;
     }
+
+    ADD_TO_COUNTER(prefetch_lifetime_miss, pref_lifetime_miss);
+    ADD_TO_COUNTER(prefetch_lifetime_cycle, pref_lifetime_cycle);
+
+    if (!evicted.lowPriority && !evicted.fakeDemoted && !evicted.dcpDemoted)
+      _missCounter[index] ++;
   }
 };
 
+
+// -----------------------------------------------------------------------------
+// Class: CmpDCP
+// Description:
+//    Last-level cache with decoupled caching and prefetching.
+// -----------------------------------------------------------------------------
+
+class CmpDCP :
+  public LLCDecoupledPrefetch <CmpLLCEngine <CmpDCP, LLCDCPTagEntry> > {
+};
+
 #endif // __CMP_DCP_H__
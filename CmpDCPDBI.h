@@ -0,0 +1,38 @@
+// -----------------------------------------------------------------------------
+// File: CmpDCPDBI.h
+// Description:
+//    Implements a last-level cache with Decoupled Caching and Prefetching
+//    and a dirty block index
+// -----------------------------------------------------------------------------
+
+#ifndef __CMP_DCP_DBI_H__
+#define __CMP_DCP_DBI_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "LLCEngine.h"
+#include "LLCHooks.h"
+#include "CmpDCP.h"
+#include "CmpLLCDBI.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Class: CmpDCPDBI
+// Description:
+//    Last-level cache with decoupled caching and prefetching, that keeps its
+//    dirty bits in a DBI. Blocks that a DBI eviction removes from the cache
+//    are accounted by DCP like replaced blocks.
+// -----------------------------------------------------------------------------
+
+class CmpDCPDBI :
+  public LLCDecoupledPrefetch <LLCDirtyBlockIndex <
+    CmpLLCEngine <CmpDCPDBI, LLCDCPTagEntry> > > {
+};
+
+#endif // __CMP_DCP_DBI_H__
@@ -0,0 +1,769 @@
+// -----------------------------------------------------------------------------
+// File: CmpDDR.h
+// Description:
+//    Defines a DDR3/DDR4 memory system with a built in timing engine. Each
+//    bank is a state machine that is advanced only when a request is
+//    scheduled to it: the activate, precharge and column commands of the
+//    request are placed at the earliest times allowed by the timing
+//    constraints (tRCD, CL, CWL, tRP, tRAS, tRRD, tFAW, tCCD, tRTP, tWR,
+//    tWTR, tRTRS) and by refresh (tRFC every tREFI). The timing parameters
+//    are in DRAM clocks and come from the component file, for example
+//    Components/ddr/DDR3-1600K.
+// -----------------------------------------------------------------------------
+
+#ifndef __CMP_DDR_H__
+#define __CMP_DDR_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "MemoryComponent.h"
+#include "MemoryRequestQueue.h"
+#include "DRAMAddressMapping.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+#include <cmath>
+
+// row id used for the request queues of a closed bank
+#define DDR_CLOSED_ROW (~((addr_t)0))
+
+
+// -----------------------------------------------------------------------------
+// Class: CmpDDR
+// Description:
+//    Event driven DDR timing model. Multiple channels, ranks and banks. The
+//    scheduling algorithms are the same as the simple memory controller.
+// -----------------------------------------------------------------------------
+
+class CmpDDR : public MemoryComponent {
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  // organization
+  uint32 _numChannels;
+  uint32 _numRanks;
+  uint32 _numBanks;
+  uint32 _rowSize;
+  uint32 _lineSize;
+  string _addressMapping;
+  bool _usePhysicalAddress;
+
+  // controller
+  string _schedAlgo;
+  bool _dbiAwareWrites;
+  uint32 _numWriteBufferEntries;
+
+  // clock period of the DRAM in ns and frequency of the processor in GHz
+  double _tCK;
+  double _cpuFrequency;
+
+  // timing parameters in DRAM clocks
+  uint32 _CL;
+  uint32 _CWL;
+  uint32 _BL;
+  uint32 _tRCD;
+  uint32 _tRP;
+  uint32 _tRAS;
+  uint32 _tRRD;
+  uint32 _tCCD;
+  uint32 _tRTP;
+  uint32 _tWR;
+  uint32 _tWTR;
+  uint32 _tRTRS;
+  uint32 _tFAW;
+  uint32 _tRFC;
+  uint32 _tREFI;
+
+  uint32 _dummy;
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  // timing parameters in processor cycles
+  struct Timing {
+    cycles_t clock;
+    cycles_t CL, CWL, burst;
+    cycles_t tRCD, tRP, tRAS, tRRD, tCCD, tRTP, tWR, tWTR, tRTRS, tFAW;
+    cycles_t tRFC, tREFI;
+  } _t;
+
+  // state of a bank. times are the earliest cycle at which the command can
+  // be issued
+  struct Bank {
+    bool open;
+    addr_t row;
+    cycles_t nextActivate;
+    cycles_t nextPrecharge;
+  };
+
+  // state of a rank
+  struct Rank {
+    vector <Bank> banks;
+    // times of the last four activates (tFAW), oldest at actIndex
+    cycles_t actWindow[4];
+    uint32 actIndex;
+    // earliest next activate (tRRD)
+    cycles_t nextActivate;
+    // earliest next read (tWTR)
+    cycles_t nextRead;
+    // next refresh due
+    cycles_t nextRefresh;
+  };
+
+  // state of a channel
+  struct Channel {
+    // per-bank read and write queues. banks of rank r are at r * _numBanks
+    MemoryRequestQueue requests;
+    bool drain;
+    vector <Rank> ranks;
+    // cycle at which the next request can be scheduled
+    cycles_t currentCycle;
+    // earliest next column command (tCCD) and write (read to write)
+    cycles_t nextColumn;
+    cycles_t nextWrite;
+    // cycle at which the data bus is free
+    cycles_t busFree;
+    uint32 lastRank;
+    bool lastWrite;
+  };
+
+  vector <Channel> _channels;
+
+  // per channel statistics
+  vector <uint64> _channelAccesses;
+  vector <uint64> _channelBusyCycles;
+
+  DRAMAddressMapping _mapping;
+
+  // scheduling algorithm
+  MemoryRequest * (CmpDDR::*NextRequest)(MemoryRequestQueue &, bool &);
+
+
+  // -------------------------------------------------------------------------
+  // Declare counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(accesses);
+  NEW_COUNTER(reads);
+  NEW_COUNTER(writes);
+  NEW_COUNTER(rowhits);
+  NEW_COUNTER(rowmisses);
+  NEW_COUNTER(rowconflicts);
+  NEW_COUNTER(activates);
+  NEW_COUNTER(refreshes);
+  NEW_COUNTER(readtowrites);
+  NEW_COUNTER(writetoreads);
+  NEW_COUNTER(read_latency);
+  NEW_COUNTER(write_rowhits);
+  NEW_COUNTER(dbi_queries);
+  NEW_COUNTER(dbi_pulled_writebacks);
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor. It cannot take any arguments. Defaults are DDR3-1600K.
+  // -------------------------------------------------------------------------
+
+  CmpDDR() {
+    _numChannels = 1;
+    _numRanks = 1;
+    _numBanks = 8;
+    _rowSize = 8192;
+    _lineSize = 64;
+    _addressMapping = "row-rank-bank-channel-column";
+    _usePhysicalAddress = false;
+    _schedAlgo = "frfcfs-drain";
+    _dbiAwareWrites = false;
+    _numWriteBufferEntries = 64;
+
+    _tCK = 1.25;
+    _cpuFrequency = 2.666666667;
+    _CL = 11;
+    _CWL = 8;
+    _BL = 8;
+    _tRCD = 11;
+    _tRP = 11;
+    _tRAS = 28;
+    _tRRD = 5;
+    _tCCD = 4;
+    _tRTP = 6;
+    _tWR = 12;
+    _tWTR = 6;
+    _tRTRS = 1;
+    _tFAW = 24;
+    _tRFC = 208;
+    _tREFI = 6240;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Virtual functions to be implemented by the components
+  // -------------------------------------------------------------------------
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter to the component
+  // -------------------------------------------------------------------------
+
+  void AddParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      // Add the list of parameters to the component here
+      CMP_PARAMETER_UINT("num-channels", _numChannels)
+      CMP_PARAMETER_UINT("num-ranks", _numRanks)
+      CMP_PARAMETER_UINT("num-banks", _numBanks)
+      CMP_PARAMETER_UINT("row-size", _rowSize)
+      CMP_PARAMETER_UINT("line-size", _lineSize)
+      CMP_PARAMETER_STRING("address-mapping", _addressMapping)
+      CMP_PARAMETER_BOOLEAN("physical-address", _usePhysicalAddress)
+      CMP_PARAMETER_STRING("scheduling-algo", _schedAlgo)
+      CMP_PARAMETER_BOOLEAN("dbi-aware-writes", _dbiAwareWrites)
+      CMP_PARAMETER_UINT("num-write-buffer-entries", _numWriteBufferEntries)
+
+      CMP_PARAMETER_DOUBLE("tCK", _tCK)
+      CMP_PARAMETER_DOUBLE("cpu-frequency", _cpuFrequency)
+      CMP_PARAMETER_UINT("CL", _CL)
+      CMP_PARAMETER_UINT("CWL", _CWL)
+      CMP_PARAMETER_UINT("BL", _BL)
+      CMP_PARAMETER_UINT("tRCD", _tRCD)
+      CMP_PARAMETER_UINT("tRP", _tRP)
+      CMP_PARAMETER_UINT("tRAS", _tRAS)
+      CMP_PARAMETER_UINT("tRRD", _tRRD)
+      CMP_PARAMETER_UINT("tCCD", _tCCD)
+      CMP_PARAMETER_UINT("tRTP", _tRTP)
+      CMP_PARAMETER_UINT("tWR", _tWR)
+      CMP_PARAMETER_UINT("tWTR", _tWTR)
+      CMP_PARAMETER_UINT("tRTRS", _tRTRS)
+      CMP_PARAMETER_UINT("tFAW", _tFAW)
+      CMP_PARAMETER_UINT("tRFC", _tRFC)
+      CMP_PARAMETER_UINT("tREFI", _tREFI)
+
+      CMP_PARAMETER_UINT("stall-count", _dummy)
+      CMP_PARAMETER_UINT("cmp-stall-count", _dummy)
+
+    CMP_PARAMETER_END
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to initialize statistics
+  // -------------------------------------------------------------------------
+
+  void InitializeStatistics() {
+
+    INITIALIZE_COUNTER(accesses, "Total Accesses");
+    INITIALIZE_COUNTER(reads, "Read Accesses");
+    INITIALIZE_COUNTER(writes, "Write Accesses");
+    INITIALIZE_COUNTER(rowhits, "Row Buffer Hits");
+    INITIALIZE_COUNTER(rowmisses, "Accesses to Closed Banks");
+    INITIALIZE_COUNTER(rowconflicts, "Row Buffer Conflicts");
+    INITIALIZE_COUNTER(activates, "Activates");
+    INITIALIZE_COUNTER(refreshes, "Refreshes");
+    INITIALIZE_COUNTER(readtowrites, "Read to Write Switches");
+    INITIALIZE_COUNTER(writetoreads, "Write to Read Switches");
+    INITIALIZE_COUNTER(read_latency, "Total Read Latency");
+    INITIALIZE_COUNTER(write_rowhits, "Write Row Buffer Hits");
+    INITIALIZE_VECTOR_COUNTER(_channelAccesses, "channel-accesses",
+        "Accesses of each channel")
+    INITIALIZE_VECTOR_COUNTER(_channelBusyCycles, "channel-busy_cycles",
+        "Busy cycles of each channel")
+    INITIALIZE_COUNTER(dbi_queries, "DBI Dirty Row Queries");
+    INITIALIZE_COUNTER(dbi_pulled_writebacks, "Writebacks Pulled from the DBI");
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation starts
+  // -------------------------------------------------------------------------
+
+  void StartSimulation() {
+
+    _mapping.Initialize(_addressMapping, _numChannels, _numRanks, _numBanks,
+        _rowSize, _lineSize);
+    NextRequest = GetSchedulingAlgorithmFunction(_schedAlgo);
+
+    // convert the timing parameters to processor cycles
+    _t.clock = ToCycles(1);
+    _t.CL = ToCycles(_CL);
+    _t.CWL = ToCycles(_CWL);
+    _t.burst = ToCycles(_BL / 2);
+    _t.tRCD = ToCycles(_tRCD);
+    _t.tRP = ToCycles(_tRP);
+    _t.tRAS = ToCycles(_tRAS);
+    _t.tRRD = ToCycles(_tRRD);
+    _t.tCCD = ToCycles(_tCCD);
+    _t.tRTP = ToCycles(_tRTP);
+    _t.tWR = ToCycles(_tWR);
+    _t.tWTR = ToCycles(_tWTR);
+    _t.tRTRS = ToCycles(_tRTRS);
+    _t.tFAW = ToCycles(_tFAW);
+    _t.tRFC = ToCycles(_tRFC);
+    _t.tREFI = ToCycles(_tREFI);
+
+    _channels.resize(_numChannels);
+    _channelAccesses.assign(_numChannels, 0);
+    _channelBusyCycles.assign(_numChannels, 0);
+    for (uint32 i = 0; i < _numChannels; i ++) {
+      Channel &channel = _channels[i];
+      channel.requests.SetNumBanks(_numRanks * _numBanks);
+      for (uint32 b = 0; b < _numRanks * _numBanks; b ++)
+        channel.requests.SetOpenRow(b, DDR_CLOSED_ROW);
+      channel.drain = false;
+      channel.currentCycle = _currentCycle;
+      channel.nextColumn = 0;
+      channel.nextWrite = 0;
+      channel.busFree = 0;
+      channel.lastRank = 0;
+      channel.lastWrite = false;
+
+      channel.ranks.resize(_numRanks);
+      for (uint32 r = 0; r < _numRanks; r ++) {
+        Rank &rank = channel.ranks[r];
+        rank.banks.resize(_numBanks);
+        for (uint32 b = 0; b < _numBanks; b ++) {
+          rank.banks[b].open = false;
+          rank.banks[b].row = 0;
+          rank.banks[b].nextActivate = 0;
+          rank.banks[b].nextPrecharge = 0;
+        }
+        for (uint32 a = 0; a < 4; a ++)
+          rank.actWindow[a] = 0;
+        rank.actIndex = 0;
+        rank.nextActivate = 0;
+        rank.nextRead = 0;
+        // stagger the refreshes of the ranks
+        rank.nextRefresh = _t.tREFI * (r + 1) / _numRanks;
+      }
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called at a heart beat. Argument indicates cycles elapsed after
+  // previous heartbeat
+  // -------------------------------------------------------------------------
+
+  void HeartBeat(cycles_t hbCount) {
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when warmup ends
+  // -------------------------------------------------------------------------
+
+  void EndWarmUp() {
+    MemoryComponent::EndWarmUp();
+    fill(_channelAccesses.begin(), _channelAccesses.end(), 0);
+    fill(_channelBusyCycles.begin(), _channelBusyCycles.end(), 0);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation ends
+  // -------------------------------------------------------------------------
+
+  void EndSimulation() {
+    DUMP_STATISTICS;
+    CMP_LOG("average-read-latency = %.2lf", reads == 0 ? 0.0 :
+        (double)read_latency / reads);
+    CMP_LOG("write-rowhit-rate = %.4lf", writes == 0 ? 0.0 :
+        (double)write_rowhits / writes);
+    CLOSE_ALL_LOGS;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the earliest cycle at which the component has work to
+  // do. A busy channel with queued requests schedules again when it is free.
+  // Requests that the scheduler holds on a free channel (writes below the
+  // drain threshold) wait for an arrival and are not an event.
+  // -------------------------------------------------------------------------
+
+  bool NextEvent(cycles_t &cycle) {
+    bool valid = MemoryComponent::NextEvent(cycle);
+    for (uint32 i = 0; i < _channels.size(); i ++) {
+      Channel &channel = _channels[i];
+      if (channel.requests.Empty() ||
+          channel.currentCycle <= (*_simulatorCycle))
+        continue;
+      if (!valid || channel.currentCycle < cycle)
+        cycle = channel.currentCycle;
+      valid = true;
+    }
+    return valid;
+  }
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to convert DRAM clocks to processor cycles
+  // -------------------------------------------------------------------------
+
+  cycles_t ToCycles(uint32 clocks) {
+    return (cycles_t)ceil(clocks * _tCK * _cpuFrequency - 1e-6);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the scheduling algorithm function
+  // -------------------------------------------------------------------------
+
+  MemoryRequest * (CmpDDR::*GetSchedulingAlgorithmFunction(
+        string algo)) (MemoryRequestQueue &, bool &) {
+    if (algo.compare("fcfs") == 0) return &CmpDDR::FCFS;
+    if (algo.compare("fcfs-drain") == 0) return &CmpDDR::FCFSDrainWhenFull;
+    if (algo.compare("frfcfs") == 0) return &CmpDDR::FRFCFS;
+    if (algo.compare("frfcfs-drain") == 0) return &CmpDDR::FRFCFSDrainWhenFull;
+    fprintf(stderr, "Error: Unknown scheduling algorithm `%s' for `%s'\n",
+        algo.c_str(), _name.c_str());
+    exit(-1);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the location of a request. The bank index is the index
+  // of the bank within the channel.
+  // -------------------------------------------------------------------------
+
+  void GetLocation(MemoryRequest *request, DRAMAddress &location,
+      uint32 &bankIndex) {
+    _mapping.Map(_usePhysicalAddress ? PADDR(request) : VADDR(request),
+        location);
+    bankIndex = location.rank * _numBanks + location.bank;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to perform the refreshes of a rank that are due by the given
+  // cycle. A refresh precharges all banks and blocks activates for tRFC.
+  // -------------------------------------------------------------------------
+
+  void Refresh(Channel &channel, uint32 rankIndex, cycles_t now) {
+
+    if (_tREFI == 0) return;
+
+    Rank &rank = channel.ranks[rankIndex];
+
+    while (rank.nextRefresh <= now) {
+
+      cycles_t start = rank.nextRefresh;
+      bool anyOpen = false;
+      for (uint32 b = 0; b < _numBanks; b ++) {
+        Bank &bank = rank.banks[b];
+        start = max(start, bank.open ? bank.nextPrecharge : bank.nextActivate);
+        anyOpen = anyOpen || bank.open;
+      }
+      if (anyOpen)
+        start += _t.tRP;
+
+      cycles_t end = start + _t.tRFC;
+      for (uint32 b = 0; b < _numBanks; b ++) {
+        Bank &bank = rank.banks[b];
+        if (bank.open) {
+          bank.open = false;
+          channel.requests.SetOpenRow(rankIndex * _numBanks + b,
+              DDR_CLOSED_ROW);
+        }
+        bank.nextActivate = max(bank.nextActivate, end);
+      }
+
+      INCREMENT(refreshes);
+      rank.nextRefresh += _t.tREFI;
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process a request. Return value indicates number of busy
+  // cycles for the channel. The request is returned when its data burst
+  // completes.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessRequest(MemoryRequest *request) {
+
+    INCREMENT(accesses);
+
+    bool isWrite = false;
+
+    switch (request -> type) {
+
+    case MemoryRequest::READ: case MemoryRequest::READ_FOR_WRITE: case MemoryRequest::PREFETCH:
+      INCREMENT(reads);
+      break;
+
+    case MemoryRequest::WRITEBACK:
+      INCREMENT(writes);
+      isWrite = true;
+      break;
+
+    case MemoryRequest::WRITE:
+    case MemoryRequest::PARTIALWRITE:
+      fprintf(stderr, "Memory controller cannot get a write\n");
+      exit(0);
+    }
+
+    DRAMAddress location;
+    uint32 bankIndex;
+    GetLocation(request, location, bankIndex);
+    Channel &channel = _channels[location.channel];
+    Rank &rank = channel.ranks[location.rank];
+    Bank &bank = rank.banks[location.bank];
+
+    cycles_t now = request -> currentCycle;
+    Refresh(channel, location.rank, now);
+
+    // cycle of the first command issued for the request
+    cycles_t first = now;
+    cycles_t ready = now;
+    bool hit = (bank.open && bank.row == location.row);
+
+    if (hit) {
+      INCREMENT(rowhits);
+      if (isWrite)
+        INCREMENT(write_rowhits);
+      if (request -> drain)
+        request -> drain -> rowHits ++;
+    }
+
+    else {
+
+      // precharge the open row
+      if (bank.open) {
+        INCREMENT(rowconflicts);
+        cycles_t precharge = max(now, bank.nextPrecharge);
+        first = precharge;
+        ready = precharge + _t.tRP;
+      }
+      else {
+        INCREMENT(rowmisses);
+      }
+
+      // activate the row
+      cycles_t activate = max(ready, max(bank.nextActivate,
+            rank.nextActivate));
+      activate = max(activate, rank.actWindow[rank.actIndex] + _t.tFAW);
+      if (!bank.open)
+        first = activate;
+
+      INCREMENT(activates);
+      rank.actWindow[rank.actIndex] = activate;
+      rank.actIndex = (rank.actIndex + 1) % 4;
+      rank.nextActivate = activate + _t.tRRD;
+      bank.nextActivate = activate + _t.tRAS + _t.tRP;
+      bank.nextPrecharge = activate + _t.tRAS;
+      bank.open = true;
+      bank.row = location.row;
+      channel.requests.SetOpenRow(bankIndex, location.row);
+
+      // pull the other dirty blocks of the row while it is open
+      if (_dbiAwareWrites && isWrite)
+        PullDirtyRow(request, location, bankIndex);
+
+      ready = activate + _t.tRCD;
+    }
+
+    // column command
+    cycles_t latency = (isWrite ? _t.CWL : _t.CL);
+    cycles_t column = max(ready, channel.nextColumn);
+    if (isWrite) column = max(column, channel.nextWrite);
+    else column = max(column, rank.nextRead);
+
+    // the data burst must start after the bus is free
+    cycles_t busFree = channel.busFree;
+    if (location.rank != channel.lastRank)
+      busFree += _t.tRTRS;
+    if (column + latency < busFree)
+      column = busFree - latency;
+
+    if (hit)
+      first = column;
+
+    cycles_t dataEnd = column + latency + _t.burst;
+
+    // update the state
+    if (isWrite) {
+      if (!channel.lastWrite) INCREMENT(readtowrites);
+      bank.nextPrecharge = max(bank.nextPrecharge, dataEnd + _t.tWR);
+      rank.nextRead = max(rank.nextRead, dataEnd + _t.tWTR);
+    }
+    else {
+      if (channel.lastWrite) INCREMENT(writetoreads);
+      bank.nextPrecharge = max(bank.nextPrecharge, column + _t.tRTP);
+      // a write burst can follow a read burst after tRTRS
+      if (dataEnd + _t.tRTRS > _t.CWL)
+        channel.nextWrite = max(channel.nextWrite,
+            dataEnd + _t.tRTRS - _t.CWL);
+      ADD_TO_COUNTER(read_latency, dataEnd - now);
+    }
+
+    channel.lastWrite = isWrite;
+    channel.lastRank = location.rank;
+    channel.nextColumn = column + _t.tCCD;
+    channel.busFree = dataEnd;
+    _channelAccesses[location.channel] ++;
+    _channelBusyCycles[location.channel] += _t.burst;
+
+    request -> AddLatency(dataEnd - now);
+    request -> serviced = true;
+
+    // commands are issued in order, one per clock
+    return first + _t.clock - now;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process the return of a request. Return value indicates
+  // number of busy cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessReturn(MemoryRequest *request) {
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Overriding process pending requests. To do batch processing
+  // -------------------------------------------------------------------------
+
+  void ProcessPendingRequests() {
+
+    // if processing return
+    if (_processing) return;
+    _processing = true;
+
+    // if the request queue is empty return
+    if (_queue.empty() && RequestQueuesEmpty()) {
+      _processing = false;
+      return;
+    }
+
+    MemoryRequest *request;
+
+    // take all the requests in the queue till the simulator cycle and add
+    // them to the read or write queue of their channel
+    while (!_queue.empty()) {
+
+      request = _queue.top();
+      if (request -> currentCycle > (*_simulatorCycle))
+        break;
+      _queue.pop();
+
+      // if the request is already serviced
+      if (request -> serviced) {
+        ProcessReturn(request);
+        SendToNextComponent(request);
+        continue;
+      }
+
+      DRAMAddress location;
+      uint32 bankIndex;
+      GetLocation(request, location, bankIndex);
+      MemoryRequestQueue &requests = _channels[location.channel].requests;
+
+      switch (request -> type) {
+      case MemoryRequest::READ: case MemoryRequest::READ_FOR_WRITE: case MemoryRequest::PREFETCH:
+        requests.Insert(request, READ_QUEUE, bankIndex, location.row);
+        break;
+
+      case MemoryRequest::WRITEBACK:
+        requests.Insert(request, WRITE_QUEUE, bankIndex, location.row);
+        break;
+
+      case MemoryRequest::WRITE:
+      case MemoryRequest::PARTIALWRITE:
+        printf("Memory controller cannot receive a direct write\n");
+        exit(0);
+      }
+    }
+
+    // schedule requests on each channel until there are none or the channel
+    // time exceeds simulator time
+    for (uint32 i = 0; i < _channels.size(); i ++) {
+
+      Channel &channel = _channels[i];
+
+      while (channel.currentCycle <= (*_simulatorCycle)) {
+
+        request = (this ->* NextRequest)(channel.requests, channel.drain);
+        if (request == NULL)
+          break;
+
+        cycles_t now = max(request -> currentCycle, channel.currentCycle);
+        channel.currentCycle = now;
+        request -> currentCycle = now;
+        channel.currentCycle += ProcessRequest(request);
+        SendToNextComponent(request);
+      }
+    }
+
+    _processing = false;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to pull the dirty blocks of a row that is activated for a write
+  // from the DBI above. They are added to the write queue of the bank, where
+  // the scheduler finds them as row hits.
+  // -------------------------------------------------------------------------
+
+  void PullDirtyRow(MemoryRequest *request, DRAMAddress &location,
+      uint32 bankIndex) {
+
+    MemoryComponent *dbi = DirtyRowSource(request);
+    if (dbi == NULL)
+      return;
+
+    INCREMENT(dbi_queries);
+    vector <addr_t> vblocks, pblocks;
+    dbi -> DirtyRowBlocks(request, vblocks, pblocks);
+
+    for (uint32 i = 0; i < vblocks.size(); i ++) {
+
+      DRAMAddress block;
+      _mapping.Map(_usePhysicalAddress ? pblocks[i] : vblocks[i], block);
+      if (block.channel != location.channel || block.rank != location.rank ||
+          block.bank != location.bank || block.row != location.row)
+        continue;
+
+      MemoryRequest *writeback = dbi -> CleanBlock(vblocks[i], pblocks[i],
+          request);
+      if (writeback == NULL)
+        continue;
+
+      INCREMENT(dbi_pulled_writebacks);
+      writeback -> cmpID = request -> cmpID;
+      _channels[location.channel].requests.Insert(writeback, WRITE_QUEUE,
+          bankIndex, location.row);
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to check if all channel request queues are empty
+  // -------------------------------------------------------------------------
+
+  bool RequestQueuesEmpty() {
+    for (uint32 i = 0; i < _channels.size(); i ++)
+      if (!_channels[i].requests.Empty())
+        return false;
+    return true;
+  }
+
+
+#include "MemorySchedulers.h"
+
+};
+
+#endif // __CMP_DDR_H__
@@ -1,7 +1,3 @@
-// TODO : Check all interactions with queue, check the timing of _currentCycle
-// Check if mem will accept transactions
-// Check for boundary cases in the new additions
-
 // -----------------------------------------------------------------------------
 // File: CmpDRAMSim.h
 // Description:
@@ -31,11 +27,18 @@
 #define ALIGN_ADDRESS(addr, bytes) (addr & ~(((unsigned long)bytes) - 1L))
 #define tCK 3.0
 
+// DRAMSim2 directory holding the device and system ini files. The Makefile
+// passes the directory the simulator is linked against
+#ifndef DRAMSIM_DIR
+#define DRAMSIM_DIR "."
+#endif
+
 // -----------------------------------------------------------------------------
 // Module includes
 // -----------------------------------------------------------------------------
 
 #include "MemoryComponent.h"
+#include "MemoryRequestQueue.h"
 #include "Types.h"
 #include <DRAMSim.h>
 
@@ -47,6 +50,8 @@
 #include <list>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <set>
 
 using namespace DRAMSim;
 
@@ -70,6 +75,7 @@ protected:
   uint32 _rowSize;
 
   string _schedAlgo;
+  bool _dbiAwareWrites;
 
   /*
   uint32 _rowHitLatency;
@@ -81,30 +87,38 @@ protected:
 
   uint32 _numWriteBufferEntries;
   uint32 _busProcessorRatio;
+
+  // minimum latency of a transaction in DRAM clocks
+  uint32 _minLatency;
   
   uint32 _dummy;
 
+  // DRAMSim2 configuration: directory, device and system ini files (relative
+  // to the directory), name of the results file and memory size in MB
+  string _dramsimDir;
+  string _deviceIni;
+  string _systemIni;
+  string _resultsName;
+  uint32 _memorySize;
+
+  // file to log rejected transactions to. no log if empty
+  string _rejectionLog;
+
   // -------------------------------------------------------------------------
   // Private members
   // -------------------------------------------------------------------------
 
-  // memory request queue
-  list <MemoryRequest *> _readQ;
-  list <MemoryRequest *> _writeQ;
+  // per-bank read and write queues. also tracks the open row of each bank
+  MemoryRequestQueue _requests;
 
   // last operation type
   MemoryRequest::Type _lastOp;
 
-  // open row in each bank
-  vector <addr_t> _openRow;
-
   // scheduling algorithm
-  MemoryRequest * (CmpDRAMSim::*NextRequest)();
+  MemoryRequest * (CmpDRAMSim::*NextRequest)(MemoryRequestQueue &, bool &);
 
   // for scheduling algorithms
   bool _drain;
-  list <MemoryRequest *> _writeRowHits;
-  list <MemoryRequest *> _readRowHits;
 
   // for requests
   uint64_t physicalAddress;
@@ -112,12 +126,22 @@ protected:
   // DRAM time
   cycles_t DRAMtime;
 
-  // output file
+  // rejection log
   ofstream OutFile;
 
   // number of requests pending
   unsigned pendingRequests;
 
+  // processor cycles skipped while DRAMSim was idle. the processor cycle
+  // of DRAM clock c is c * _busProcessorRatio + _skippedCycles
+  cycles_t _skippedCycles;
+
+  // requests sent to DRAMSim, by transaction address in issue order
+  map <uint64_t, list <MemoryRequest *> > _inFlight;
+
+  // issue cycles of the requests sent to DRAMSim
+  multiset <cycles_t> _issueCycles;
+
 
   // -------------------------------------------------------------------------
   // Declare counters
@@ -131,10 +155,11 @@ protected:
   NEW_COUNTER(Writerowhits);
   NEW_COUNTER(Readrowhits);
   NEW_COUNTER(rowconflicts);
-/*
   NEW_COUNTER(readtowrites);
   NEW_COUNTER(writetoreads);
-  
+  NEW_COUNTER(dbi_queries);
+  NEW_COUNTER(dbi_pulled_writebacks);
+/*
 
 NEW_COUNTER(readandprefetch_cycles);
 NEW_COUNTER(writeback_cycles);
@@ -151,7 +176,15 @@ public:
     _rowSize = 8192;				// default to the DDR2_micron_16M_8b_x8_sg3E    
     _numWriteBufferEntries = 64;
     _busProcessorRatio = 8;
-    _schedAlgo = "fcfs";
+    _minLatency = 12;
+    _schedAlgo = "frfcfs-drain";
+    _dbiAwareWrites = false;
+    _dramsimDir = DRAMSIM_DIR;
+    _deviceIni = "ini/DDR2_micron_16M_8b_x8_sg3E.ini";
+    _systemIni = "system.ini";
+    _resultsName = "MyResults";
+    _memorySize = 1024;
+    _rejectionLog = "";
   }
 
 
@@ -168,96 +201,13 @@ public:
   // -------------------------------------------------------------------------
 
 
-	void read_complete(unsigned id, uint64_t address, uint64_t clock_cycle)
-	{
-
-	vector <MemoryRequest *> temp; 
-        MemoryRequest *tempReq;		// All because I can't iterate over a priority_queue
-	unsigned sizequeue = _queue.size();
-	addr_t myaddr;
-	myaddr = address;
-
-                for (unsigned i=0;i<sizequeue;i++){
-		if(!((myaddr==ALIGN_ADDRESS(_queue.top() -> virtualAddress, TRANS_SIZE))&&(_queue.top()->s_f_d)))
-		{
-		tempReq = _queue.top();
-                _queue.pop();	
-		temp.push_back(tempReq);
-		}
-
-		else{
-			tempReq = _queue.top();
-                	_queue.pop();
-			unsigned sizetemp = temp.size();
-			for(unsigned i=0;i<sizetemp;i++)
-			{
-			_queue.push(temp.back());
-			temp.pop_back();
-			}
-
-			tempReq -> serviced = true;
-			tempReq -> s_f_d = false;
-		      
-			cycles_t now = max((cycles_t)(clock_cycle*_busProcessorRatio), _currentCycle);
-			_currentCycle = now;
-
-			pendingRequests--;
-			
-			tempReq -> AddLatency((clock_cycle*_busProcessorRatio) - (tempReq -> currentCycle));
-			tempReq -> cmpID --;
-			((*_hier)[tempReq -> cpuID])[tempReq -> cmpID] -> SimpleAddRequest(tempReq);
-			return;
-                	}
-                }
-		fprintf(stderr, "Returned read transaction has no matching request\n");
-
-	}
-
-	void write_complete(unsigned id, uint64_t address, uint64_t clock_cycle)
-	{
-
-	vector <MemoryRequest *> temp; 
-        MemoryRequest *tempReq;		// All because I can't iterate over a priority_queue
-	unsigned sizequeue = _queue.size();
-	addr_t myaddr;
-	myaddr = address;
-
-                for (unsigned i=0;i<sizequeue;i++){
-		if(!((myaddr==ALIGN_ADDRESS(_queue.top() -> virtualAddress, TRANS_SIZE))&&(_queue.top()->s_f_d)))
-		{
-		tempReq = _queue.top();
-                _queue.pop();	
-		temp.push_back(tempReq);
-		}
-
-		else{
-			tempReq = _queue.top();
-                	_queue.pop();
-			unsigned sizetemp = temp.size();
-			for(unsigned i=0;i<sizetemp;i++)
-			{
-			_queue.push(temp.back());
-			temp.pop_back();
-			}
-
-			tempReq -> serviced = true;
-			tempReq -> s_f_d = false;
-			
-			cycles_t now = max((cycles_t)(clock_cycle*_busProcessorRatio), _currentCycle);
-			_currentCycle = now;
-
-			pendingRequests--;
-			
-			tempReq -> AddLatency((clock_cycle*_busProcessorRatio) - (tempReq -> currentCycle));
-                       	tempReq -> cmpID --;
-			((*_hier)[tempReq -> cpuID])[tempReq -> cmpID] -> SimpleAddRequest(tempReq);
-			return;
-                	}
-                }
-		fprintf(stderr, "Returnede write transaction does not have matching request\n");
-
+  void read_complete(unsigned id, uint64_t address, uint64_t clock_cycle) {
+    TransactionComplete(address, clock_cycle);
+  }
 
-	}
+  void write_complete(unsigned id, uint64_t address, uint64_t clock_cycle) {
+    TransactionComplete(address, clock_cycle);
+  }
 
 	/* This currently does nothing */
 	void power_callback(double a, double b, double c, double d)
@@ -281,7 +231,15 @@ public:
       CMP_PARAMETER_UINT("row-size", _rowSize)
       CMP_PARAMETER_UINT("num-write-buffer-entries", _numWriteBufferEntries)
       CMP_PARAMETER_STRING("scheduling-algo", _schedAlgo)
+      CMP_PARAMETER_BOOLEAN("dbi-aware-writes", _dbiAwareWrites)
       CMP_PARAMETER_UINT("bus-processor-ratio", _busProcessorRatio)
+      CMP_PARAMETER_UINT("min-latency", _minLatency)
+      CMP_PARAMETER_STRING("dramsim-dir", _dramsimDir)
+      CMP_PARAMETER_STRING("device-ini", _deviceIni)
+      CMP_PARAMETER_STRING("system-ini", _systemIni)
+      CMP_PARAMETER_STRING("results-name", _resultsName)
+      CMP_PARAMETER_UINT("memory-size", _memorySize)
+      CMP_PARAMETER_STRING("rejection-log", _rejectionLog)
 
 /*
       CMP_PARAMETER_UINT("row-hit-latency", _rowHitLatency)
@@ -313,9 +271,11 @@ public:
     INITIALIZE_COUNTER(Writerowhits, "Write Row Buffer Hits");
     INITIALIZE_COUNTER(Readrowhits, "Read Row Buffer Hits");
     INITIALIZE_COUNTER(rowconflicts, "Row Buffer Conflicts");
+    INITIALIZE_COUNTER(readtowrites, "Read to Write Switches (issue order)");
+    INITIALIZE_COUNTER(writetoreads, "Write to Read Switches (issue order)");
+    INITIALIZE_COUNTER(dbi_queries, "DBI Dirty Row Queries");
+    INITIALIZE_COUNTER(dbi_pulled_writebacks, "Writebacks Pulled from the DBI");
 /*
-    INITIALIZE_COUNTER(readtowrites, "Read to Write Switches");
-    INITIALIZE_COUNTER(writetoreads, "Write to Read Switches");
 
   INITIALIZE_COUNTER(readandprefetch_cycles, "Number of cycles for Read requests")
   INITIALIZE_COUNTER(writeback_cycles, "Number of cycles for writeback requests")
@@ -328,11 +288,12 @@ public:
   // -------------------------------------------------------------------------
 
   void StartSimulation() {
-    _openRow.resize(_numBanks, 0);
+    _requests.SetNumBanks(_numBanks);
     NextRequest = GetSchedulingAlgorithmFunction(_schedAlgo);
     _drain = false;
     _lastOp = MemoryRequest::READ;
     pendingRequests = 0;
+    _minLatency *= _busProcessorRatio;
 
 /*
     _rowHitLatency *= _busProcessorRatio;
@@ -341,18 +302,21 @@ public:
     _writeToReadLatency *= _busProcessorRatio;
     _channelDelay *= _busProcessorRatio;
 */
-	mem = getMemorySystemInstance("ini/DDR2_micron_16M_8b_x8_sg3E.ini", "system.ini", "/home/abhishek/DRAMSim2", "MyResults", 1024);
-	uint64_t procSpeed = 2666666667;
-	// Here 8 is the busprocessorratio
-        mem->setCPUClockSpeed(procSpeed);
+	mem = getMemorySystemInstance(_deviceIni, _systemIni, _dramsimDir,
+	    _resultsName, _memorySize);
+	// a CPU clock speed of 0 makes one update tick one DRAM clock; the
+	// processor side of the clock is the bus-processor-ratio
+	mem->setCPUClockSpeed(0);
 	DRAMtime = *_simulatorCycle;
+	_skippedCycles = DRAMtime;
 
 	typedef DRAMSim::Callback <CmpDRAMSim, void, uint, uint64_t, uint64_t> dramsim_callback_t;
 	TransactionCompleteCB *read_cb = new dramsim_callback_t(this, &CmpDRAMSim::read_complete);
 	TransactionCompleteCB *write_cb = new dramsim_callback_t(this, &CmpDRAMSim::write_complete);
  
 	mem->RegisterCallbacks(read_cb, write_cb, NULL);
-	OutFile.open("output");
+	if (!_rejectionLog.empty())
+	  OutFile.open(_rejectionLog.c_str());
   }
 
 
@@ -367,20 +331,103 @@ public:
 
   void EndSimulation() {
     DUMP_STATISTICS;
+    CMP_LOG("write-rowhit-rate = %.4lf", writes == 0 ? 0.0 :
+        (double)Writerowhits / writes);
     CLOSE_ALL_LOGS;
-    OutFile.close();
+    if (OutFile.is_open())
+      OutFile.close();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the earliest cycle at which the component has work to
+  // do. DRAMSim does not expose its next event, but no transaction can
+  // complete before the minimum latency has passed since it was issued, and
+  // completions happen on DRAM clock edges.
+  // -------------------------------------------------------------------------
+
+  bool NextEvent(cycles_t &cycle) {
+    bool valid = MemoryComponent::NextEvent(cycle);
+    if (pendingRequests > 0) {
+      cycles_t next = max(DRAMtime + _busProcessorRatio,
+          *(_issueCycles.begin()) + _minLatency);
+      if (!valid || next < cycle)
+        cycle = next;
+      valid = true;
+    }
+    return valid;
   }
 
 
 protected:
 
+  // -------------------------------------------------------------------------
+  // Function to convert a DRAM clock to a processor cycle
+  // -------------------------------------------------------------------------
+
+  cycles_t DRAMToCPU(uint64_t clock_cycle) {
+    return clock_cycle * _busProcessorRatio + _skippedCycles;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to return the request of a completed transaction to the
+  // previous component
+  // -------------------------------------------------------------------------
+
+  void TransactionComplete(uint64_t address, uint64_t clock_cycle) {
+
+    map <uint64_t, list <MemoryRequest *> >::iterator it =
+      _inFlight.find(address);
+    if (it == _inFlight.end()) {
+      fprintf(stderr, "Returned transaction has no matching request\n");
+      return;
+    }
+
+    MemoryRequest *request = it -> second.front();
+    it -> second.pop_front();
+    if (it -> second.empty())
+      _inFlight.erase(it);
+    _issueCycles.erase(_issueCycles.find(request -> dramIssueCycle));
+    pendingRequests --;
+
+    request -> serviced = true;
+    request -> s_f_d = false;
+
+    cycles_t done = max(DRAMToCPU(clock_cycle), request -> currentCycle);
+    _currentCycle = max(done, _currentCycle);
+
+    request -> AddLatency(done - request -> currentCycle);
+    request -> cmpID --;
+    ((*_hier)[request -> cpuID])[request -> cmpID] -> SimpleAddRequest(request);
+  }
+
+
   // -------------------------------------------------------------------------
   // Function to get the scheduling algorithm function
   // -------------------------------------------------------------------------
 
   MemoryRequest * (CmpDRAMSim::*GetSchedulingAlgorithmFunction(
-                                                                        string algo)) () {
-    if (algo.compare("fcfs")) return &CmpDRAMSim::FCFS;
+        string algo)) (MemoryRequestQueue &, bool &) {
+    if (algo.compare("fcfs") == 0) return &CmpDRAMSim::FCFS;
+    if (algo.compare("fcfs-drain") == 0) return &CmpDRAMSim::FCFSDrainWhenFull;
+    if (algo.compare("frfcfs") == 0) return &CmpDRAMSim::FRFCFS;
+    if (algo.compare("frfcfs-drain") == 0)
+      return &CmpDRAMSim::FRFCFSDrainWhenFull;
+    fprintf(stderr, "Error: Unknown scheduling algorithm `%s' for `%s'\n",
+        algo.c_str(), _name.c_str());
+    exit(-1);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the bank and row of a request
+  // -------------------------------------------------------------------------
+
+  void GetBankAndRow(MemoryRequest *request, uint32 &bankIndex, addr_t &rowID) {
+    addr_t logicalRow = (request -> virtualAddress) / _rowSize;
+    bankIndex = logicalRow % _numBanks;
+    rowID = logicalRow / _numBanks;
   }
 
 
@@ -416,12 +463,12 @@ protected:
     }
 
     // Get the row address of the request
-    addr_t logicalRow = (request -> virtualAddress) / _rowSize;
-    uint32 bankIndex = logicalRow % _numBanks;
-    uint32 rowID = logicalRow / _numBanks;
+    uint32 bankIndex;
+    addr_t rowID;
+    GetBankAndRow(request, bankIndex, rowID);
 
     // check if the access is a row hit or conflict, to satisfy the scheduler
-    if (_openRow[bankIndex] == rowID) {
+    if (_requests.IsOpen(bankIndex, rowID)) {
       if((request -> type == MemoryRequest::READ)||(request -> type == MemoryRequest::READ_FOR_WRITE)||(request -> type == MemoryRequest::PREFETCH)){ INCREMENT(Readrowhits);}
       
       else INCREMENT(Writerowhits);
@@ -429,25 +476,72 @@ protected:
 
     else {
       INCREMENT(rowconflicts);
-      _openRow[bankIndex] = rowID;
+      _requests.SetOpenRow(bankIndex, rowID);
+
+      // pull the other dirty blocks of the row while it is open
+      if (_dbiAwareWrites && isWrite)
+        PullDirtyRow(request, bankIndex, rowID);
     }
  
 
     bool accepted = mem->addTransaction(isWrite, addr);
-    if(accepted){
-    request -> s_f_d = true;
-    if(addr == 139779289939584) cout << "sent this at cycle " << *_simulatorCycle<<endl;
-    pendingRequests++;
-    request -> dramIssueCycle = request -> currentCycle;
+    if (accepted) {
+      request -> s_f_d = true;
+      pendingRequests ++;
+      if (isWrite && _lastOp != MemoryRequest::WRITEBACK)
+        INCREMENT(readtowrites);
+      if (!isWrite && _lastOp == MemoryRequest::WRITEBACK)
+        INCREMENT(writetoreads);
+      _lastOp = (isWrite ? MemoryRequest::WRITEBACK : MemoryRequest::READ);
+      request -> dramIssueCycle = request -> currentCycle;
+      _inFlight[addr].push_back(request);
+      _issueCycles.insert(request -> dramIssueCycle);
+    }
+    else {
+      // retry at the next DRAM clock
+      if (OutFile.is_open())
+        OutFile << "DRAMSim rejection occured " << endl;
+      request -> currentCycle = DRAMtime + _busProcessorRatio;
+      this -> AddRequest(request);
     }
-    else OutFile << "DRAMSim rejection occured " << endl;
-
-    this -> AddRequest(request);		// add accepted or non-accepted request to queue of Memory Controller
     return 0;
 
   }
 
 
+  // -------------------------------------------------------------------------
+  // Function to pull the dirty blocks of a row that is opened for a write
+  // from the DBI above. They are added to the write queue of the bank, so
+  // that they are sent to DRAMSim right after the write that opened the row.
+  // -------------------------------------------------------------------------
+
+  void PullDirtyRow(MemoryRequest *request, uint32 bankIndex, addr_t rowID) {
+
+    MemoryComponent *dbi = DirtyRowSource(request);
+    if (dbi == NULL)
+      return;
+
+    INCREMENT(dbi_queries);
+    vector <addr_t> vblocks, pblocks;
+    dbi -> DirtyRowBlocks(request, vblocks, pblocks);
+
+    for (uint32 i = 0; i < vblocks.size(); i ++) {
+
+      if (vblocks[i] / _rowSize != VADDR(request) / _rowSize)
+        continue;
+
+      MemoryRequest *writeback = dbi -> CleanBlock(vblocks[i], pblocks[i],
+          request);
+      if (writeback == NULL)
+        continue;
+
+      INCREMENT(dbi_pulled_writebacks);
+      writeback -> cmpID = request -> cmpID;
+      _requests.Insert(writeback, WRITE_QUEUE, bankIndex, rowID);
+    }
+  }
+
+
   // -------------------------------------------------------------------------
   // Function to process the return of a request. Return value indicates
   // number of busy cycles for the component.
@@ -465,19 +559,28 @@ protected:
 
   void ProcessPendingRequests() {
 
-    
-    while(DRAMtime < *_simulatorCycle){
-    DRAMtime++;						// update the DRAM time
-    mem->update();						
+    // bring DRAMSim up to the simulator time, one update per DRAM clock.
+    // DRAMSim has no next event query, so every clock is ticked while a
+    // transaction is in flight. once none is, the remaining whole DRAM clocks
+    // are skipped in one jump without ticking the memory system
+    while (DRAMtime + _busProcessorRatio <= *_simulatorCycle) {
+      if (pendingRequests == 0) {
+        cycles_t skip = ((*_simulatorCycle - DRAMtime) / _busProcessorRatio) *
+          _busProcessorRatio;
+        DRAMtime += skip;
+        _skippedCycles += skip;
+        break;
+      }
+      DRAMtime += _busProcessorRatio;
+      mem -> update();
     }
 
     // if processing return
-    if (_processing)	return;
+    if (_processing) return;
     _processing = true;
 
     // if the request queue is empty return
-    if (CheckifEmpty(_queue) && _readQ.empty() && _writeQ.empty() 
-        && _readRowHits.empty() && _writeRowHits.empty()) {
+    if (_queue.empty() && _requests.Empty()) {
       _processing = false;
       return;
     }
@@ -485,88 +588,57 @@ protected:
     MemoryRequest *request;
 
     // take all the requests in the queue till the simulator cycle and add
-    // them to the read or write queue.
-    if (!CheckifEmpty(_queue)) {		// this checks if there are non-stalling for DRAM requests in the queue
+    // them to the read or write queue. requests sent to DRAMSim are not in
+    // the queue.
+    while (!_queue.empty()) {
 
-      vector <MemoryRequest *> temp;
+      request = _queue.top();
+      if (request -> currentCycle > (*_simulatorCycle))
+        break;
+      _queue.pop();
+
+      // if the request is already serviced
+      if (request -> serviced) {
+        cycles_t busyCycles = ProcessReturn(request);
+        _currentCycle += busyCycles;
+        SendToNextComponent(request);
+        continue;
+      }
 
-      while(_queue.top()->s_f_d){	// Coz I don't want to pull out s_f_d requests from the queue
-	temp.push_back(_queue.top());
-	_queue.pop();
-	}
-      	
-      request = _queue.top();		// I am bound to get a non-s_f_d request sometime
-
-      while (request -> currentCycle <= (*_simulatorCycle)) {
-        _queue.pop();
-        unsigned sizetemp = temp.size();
-	for(unsigned i=0;i<sizetemp;i++){_queue.push(temp.back());temp.pop_back();}	// rectify the queue
-	
-        // if the request is already serviced
-        if (request -> serviced) {
-          cycles_t busyCycles = ProcessReturn(request);
-	  _currentCycle += busyCycles;
-
-          SendToNextComponent(request);
-        }
-
-        // else add the request to the corresponding queue 
-
-        else {
-
-          switch (request -> type) {
-          case MemoryRequest::READ: case MemoryRequest::READ_FOR_WRITE: case MemoryRequest::PREFETCH: 
-            _readQ.push_back(request);
-            break;
-
-          case MemoryRequest::WRITEBACK:
-            _writeQ.push_back(request);
-            break;
-
-          case MemoryRequest::WRITE:
-          case MemoryRequest::PARTIALWRITE:
-            printf("Memory controller cannot receive a direct write\n");
-            exit(0);
-          }
-        }
-      
+      // else add the request to the corresponding queue
+      uint32 bankIndex;
+      addr_t rowID;
+      GetBankAndRow(request, bankIndex, rowID);
 
-        if (CheckifEmpty(_queue))				// If no non-s_f_d requests present
-	{request = NULL;
-          break;}
+      switch (request -> type) {
+      case MemoryRequest::READ: case MemoryRequest::READ_FOR_WRITE: case MemoryRequest::PREFETCH:
+        _requests.Insert(request, READ_QUEUE, bankIndex, rowID);
+        break;
 
-	while(_queue.top()->s_f_d){				// Coz I don't want to pull out s_f_d requests from the queue
-	temp.push_back(_queue.top());
-	_queue.pop();
-	}
-        request = _queue.top();
-      }
+      case MemoryRequest::WRITEBACK:
+        _requests.Insert(request, WRITE_QUEUE, bankIndex, rowID);
+        break;
 
-	if(request!=NULL){	
-	_queue.push(request);
-	unsigned sizetemp = temp.size();
-	for(unsigned i=0;i<sizetemp;i++){_queue.push(temp.back());temp.pop_back();}	// rectify the queue
-   	}
-      
- 
+      case MemoryRequest::WRITE:
+      case MemoryRequest::PARTIALWRITE:
+        printf("Memory controller cannot receive a direct write\n");
+        exit(0);
+      }
     }
 
-    // process requests until there are none or the component time 
+    // send requests to DRAMSim until there are none or the component time
     // exceeds simulator time
     while (_currentCycle <= (*_simulatorCycle)) {
 
       // get the next request to schedule
-      // TODO: request = (*this.*NextRequest)();
-      request = FRFCFSDrainWhenFull();
+      request = (this ->* NextRequest)(_requests, _drain);
 
       if (request == NULL)
         break;
 
       // process the request
       cycles_t now = max(request -> currentCycle, _currentCycle);
-      cycles_t _prevCycle = _currentCycle;
       _currentCycle = now;
-      
       request -> currentCycle = now;
       ProcessRequest(request);
     }
@@ -574,36 +646,8 @@ protected:
     _processing = false;
   }
 
-  // ------------------------------------------------------------------------
-  // Function to check if queue is devoid of non-s_f_d requests
-  // -----------------------------------------------------------------------
-  bool CheckifEmpty(RequestPriorityQueue _queue){
-	if(_queue.empty())	return true;
-	else{
-	while(!_queue.empty()){
-	if(!(_queue.top()->s_f_d))	return false;
-	_queue.pop();
-	}
-	return true;
-	}
-  }
-
-  // -------------------------------------------------------------------------
-  // Function to check if a request is a row buffer hit
-  // -------------------------------------------------------------------------
-
-  bool IsRowBufferHit(MemoryRequest *request) {
-    addr_t logicalRow = (request -> virtualAddress) / _rowSize;
-    uint32 bankIndex = logicalRow % _numBanks;
-    addr_t rowID = logicalRow / _numBanks;
-    // if logical row of two requests are same, then they have to be in same row buffer
-    if (_openRow[bankIndex] == rowID)
-      return true;
-    return false;
-  }
-
 #include "MemorySchedulers.h"
 
 };
 
-#endif // __CMP_MEMORY_CONTROLLER_H__
+#endif // __CMP_DRAMSIM_H__
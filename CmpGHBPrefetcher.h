@@ -0,0 +1,448 @@
+// -----------------------------------------------------------------------------
+// File: CmpGHBPrefetcher.h
+// Description:
+//    Implements a global history buffer (GHB) PC/DC prefetcher
+// -----------------------------------------------------------------------------
+
+#ifndef __CMP_GHB_PREFETCHER_H__
+#define __CMP_GHB_PREFETCHER_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "Prefetcher.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+#include <map>
+#include <algorithm>
+
+
+// -----------------------------------------------------------------------------
+// Class: CmpGHBPrefetcher
+// Description:
+//    PC/DC prefetcher over a global history buffer (Nesbit and Smith, HPCA
+//    2004). The GHB is a circular buffer of the recent accesses, and each
+//    entry links to the previous access of the same IP. The index table
+//    holds the newest entry of each IP. On an access, the prefetcher walks
+//    the IP's chain back history-length entries and computes the deltas
+//    between them. It looks for an earlier occurrence of the two newest
+//    deltas, and prefetches by replaying the deltas that followed it,
+//    repeating them up to degree prefetches.
+//
+//    Entries are addressed by a running sequence number, so the buffer and
+//    the index table are fixed arrays. A link is stale once the buffer wraps
+//    past it, and the index table replaces the way updated least recently.
+//
+//    Per-IP accuracy and coverage are measured at the prefetcher: a demand
+//    to a block in the recent-prefetch table counts as a useful prefetch of
+//    its IP. They are kept with the IP's index table slot, and moved to a
+//    map when the slot is replaced. They are written to <name>.ip-stats at
+//    the end of simulation.
+//
+//    Demands to prefetched blocks are tagged with d_prefetched, and
+//    d_prefID and the prefetches carry the index table slot of the IP
+//    modulo num-ids, so num-ids must not exceed the accuracy table of a
+//    prefetch-aware LLC below.
+// -----------------------------------------------------------------------------
+
+class CmpGHBPrefetcher : public Prefetcher {
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  uint32 _blockSize;
+  bool _prefetchOnWrite;
+  uint32 _degree;
+
+  uint32 _ghbSize;
+  uint32 _historyLength;
+  uint32 _indexSets;
+  uint32 _indexWays;
+  uint32 _usefulTableSize;
+  uint32 _numIDs;
+
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  struct GHBEntry {
+    // block number of the access
+    addr_t block;
+    // sequence number of the previous access of the same IP
+    uint64 link;
+  };
+
+  struct IndexEntry {
+    bool valid;
+    addr_t ip;
+    // sequence number of the newest access of the IP
+    uint64 head;
+  };
+
+  struct PrefetchedBlock {
+    // block number plus one, 0 is empty
+    addr_t block;
+    addr_t ip;
+    // index table slot of the ip
+    uint32 slot;
+  };
+
+  struct IPStats {
+    uint64 prefetches;
+    uint64 useful;
+    uint64 demands;
+  };
+
+  vector <GHBEntry> _ghb;
+  // sequence number of the next GHB entry. 0 is never a valid link
+  uint64 _next;
+
+  vector <IndexEntry> _index;
+  vector <PrefetchedBlock> _usefulTable;
+
+  // scratch for the chain walk
+  vector <int64> _deltas;
+
+  // statistics of the ip in each index table slot, and of the ips whose
+  // slots were replaced
+  vector <IPStats> _slotStats;
+  map <addr_t, IPStats> _ipStats;
+
+
+  // -------------------------------------------------------------------------
+  // Declare Counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(num_prefetches);
+  NEW_COUNTER(correlation_hits);
+  NEW_COUNTER(useful_prefetches);
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor. It cannot take any arguments
+  // -------------------------------------------------------------------------
+
+  CmpGHBPrefetcher() {
+    _blockSize = 64;
+    _prefetchOnWrite = false;
+    _degree = 4;
+
+    _ghbSize = 256;
+    _historyLength = 16;
+    _indexSets = 32;
+    _indexWays = 4;
+    _usefulTableSize = 1024;
+    _numIDs = 128;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Virtual functions to be implemented by the components
+  // -------------------------------------------------------------------------
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter to the component
+  // -------------------------------------------------------------------------
+
+  void AddParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      // Add the list of parameters to the component here
+      CMP_PARAMETER_UINT("block-size", _blockSize)
+      CMP_PARAMETER_BOOLEAN("prefetch-on-write", _prefetchOnWrite)
+      CMP_PARAMETER_UINT("degree", _degree)
+
+      CMP_PARAMETER_UINT("ghb-size", _ghbSize)
+      CMP_PARAMETER_UINT("history-length", _historyLength)
+      CMP_PARAMETER_UINT("index-sets", _indexSets)
+      CMP_PARAMETER_UINT("index-ways", _indexWays)
+      CMP_PARAMETER_UINT("useful-table-size", _usefulTableSize)
+      CMP_PARAMETER_UINT("num-ids", _numIDs)
+      else if (AddQueueParameter(pname, pvalue)) {}
+
+    CMP_PARAMETER_END
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to initialize statistics
+  // -------------------------------------------------------------------------
+
+  void InitializeStatistics() {
+    INITIALIZE_COUNTER(num_prefetches, "Number of prefetches issued")
+    INITIALIZE_COUNTER(correlation_hits, "Accesses with a delta correlation")
+    INITIALIZE_COUNTER(useful_prefetches, "Prefetched blocks demanded")
+    InitializeQueueStatistics();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation starts
+  // -------------------------------------------------------------------------
+
+  void StartSimulation() {
+    if (_ghbSize == 0 || _indexSets == 0 || _indexWays == 0 ||
+        _usefulTableSize == 0 || _numIDs == 0 || _historyLength < 3) {
+      fprintf(stderr, "Error: `%s' needs non-empty tables, num-ids and a "
+              "history of at least 3 accesses\n", _name.c_str());
+      exit(-1);
+    }
+
+    GHBEntry entry;
+    entry.block = 0;
+    entry.link = 0;
+    _ghb.assign(_ghbSize, entry);
+    _next = 1;
+
+    IndexEntry ientry;
+    ientry.valid = false;
+    _index.assign(_indexSets * _indexWays, ientry);
+
+    IPStats empty = {0, 0, 0};
+    _slotStats.assign(_index.size(), empty);
+
+    PrefetchedBlock pblock;
+    pblock.block = 0;
+    _usefulTable.assign(_usefulTableSize, pblock);
+
+    _deltas.reserve(_historyLength);
+    StartQueue();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called at a heart beat. Argument indicates cycles elapsed after
+  // previous heartbeat
+  // -------------------------------------------------------------------------
+
+  void HeartBeat(cycles_t hbCount) {
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when warmup ends
+  // -------------------------------------------------------------------------
+
+  void EndWarmUp() {
+    MemoryComponent::EndWarmUp();
+    IPStats empty = {0, 0, 0};
+    _slotStats.assign(_slotStats.size(), empty);
+    _ipStats.clear();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation ends
+  // -------------------------------------------------------------------------
+
+  void EndSimulation() {
+    DUMP_STATISTICS;
+
+    // per-IP statistics, most prefetches first
+    for (uint32 i = 0; i < _index.size(); i ++)
+      if (_index[i].valid)
+        RetireStats(i);
+    vector <pair <uint64, addr_t> > order;
+    map <addr_t, IPStats>::iterator it;
+    for (it = _ipStats.begin(); it != _ipStats.end(); it ++)
+      order.push_back(make_pair(it -> second.prefetches, it -> first));
+    sort(order.rbegin(), order.rend());
+
+    NEW_LOG_FILE("ip-stats", "ip-stats");
+    LOG("ip-stats", "ip prefetches useful demands accuracy coverage\n");
+    for (uint32 i = 0; i < order.size(); i ++) {
+      IPStats &stats = _ipStats[order[i].second];
+      LOG("ip-stats", "%llx %llu %llu %llu %.3lf %.3lf\n", order[i].second,
+          stats.prefetches, stats.useful, stats.demands,
+          stats.prefetches == 0 ? 0.0 :
+          (double)stats.useful / stats.prefetches,
+          stats.demands == 0 ? 0.0 : (double)stats.useful / stats.demands);
+    }
+
+    CLOSE_ALL_LOGS;
+  }
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to process a request. Return value indicates number of busy
+  // cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessRequest(MemoryRequest *request) {
+
+    if (request -> type == MemoryRequest::WRITE ||
+        request -> type == MemoryRequest::WRITEBACK ||
+        request -> type == MemoryRequest::PREFETCH) {
+      // do nothing
+      return 0;
+    }
+
+    if (!_prefetchOnWrite &&
+        (request -> type == MemoryRequest::READ_FOR_WRITE)) {
+      // do nothing
+      return 0;
+    }
+
+    addr_t vcla = VBLOCK_ADDRESS(request, _blockSize);
+    addr_t pcla = PBLOCK_ADDRESS(request, _blockSize);
+    addr_t block = vcla / _blockSize;
+    addr_t ip = request -> ip;
+    uint32 slot = IndexSlot(ip);
+
+    // account the demand. a useful prefetch of an ip whose slot has been
+    // replaced since is credited to the ip in the map
+    IPStats &stats = _slotStats[slot];
+    stats.demands ++;
+    PrefetchedBlock &pblock = _usefulTable[block % _usefulTableSize];
+    if (pblock.block == block + 1) {
+      INCREMENT(useful_prefetches);
+      if (_index[pblock.slot].ip == pblock.ip)
+        _slotStats[pblock.slot].useful ++;
+      else
+        _ipStats[pblock.ip].useful ++;
+      request -> d_prefetched = true;
+      request -> d_prefID = pblock.slot % _numIDs;
+      pblock.block = 0;
+    }
+
+    // append the access to the GHB and the IP's chain
+    IndexEntry &ientry = _index[slot];
+    uint64 seq = _next ++;
+    GHBEntry &entry = _ghb[seq % _ghbSize];
+    entry.block = block;
+    entry.link = ientry.head;
+    ientry.head = seq;
+
+    // deltas of the chain, newest first
+    _deltas.clear();
+    addr_t last = block;
+    uint64 link = entry.link;
+    while (_deltas.size() + 1 < _historyLength && Live(link)) {
+      GHBEntry &prev = _ghb[link % _ghbSize];
+      _deltas.push_back((int64)(last - prev.block));
+      last = prev.block;
+      link = prev.link;
+    }
+
+    // find the previous occurrence of the two newest deltas
+    uint32 match = 0;
+    for (uint32 i = 1; i + 1 < _deltas.size(); i ++) {
+      if (_deltas[i] == _deltas[0] && _deltas[i + 1] == _deltas[1]) {
+        match = i;
+        break;
+      }
+    }
+    if (match == 0)
+      return 0;
+
+    INCREMENT(correlation_hits);
+
+    // replay the deltas that followed the occurrence, oldest first
+    addr_t vpref = vcla;
+    addr_t ppref = pcla;
+    for (uint32 i = 0; i < _degree; i ++) {
+      int64 delta = _deltas[match - 1 - (i % match)] * (int64)_blockSize;
+      vpref += delta;
+      ppref += delta;
+      // skip the demanded block and blocks prefetched but not yet demanded
+      addr_t pref = vpref / _blockSize;
+      PrefetchedBlock &issued = _usefulTable[pref % _usefulTableSize];
+      if (pref == block || issued.block == pref + 1)
+        continue;
+      if (!IssuePrefetch(request, vpref, ppref, _blockSize, slot % _numIDs))
+        continue;
+
+      INCREMENT(num_prefetches);
+      stats.prefetches ++;
+      issued.block = pref + 1;
+      issued.ip = ip;
+      issued.slot = slot;
+    }
+
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process the return of a request. Return value indicates
+  // number of busy cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessReturn(MemoryRequest *request) {
+
+    // if its a prefetch from this component, delete it unless it goes on to
+    // fill the levels above
+    if (request -> iniType == MemoryRequest::COMPONENT &&
+        request -> iniPtr == this && !FillsAbove(request)) {
+      request -> destroy = true;
+    }
+
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to check if a GHB link still points to its access
+  // -------------------------------------------------------------------------
+
+  bool Live(uint64 link) {
+    return link != 0 && link + _ghbSize >= _next;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the index table slot of an IP, replacing the way of the
+  // set updated least recently if the IP is not present
+  // -------------------------------------------------------------------------
+
+  uint32 IndexSlot(addr_t ip) {
+    uint32 base = (((ip >> 2) ^ (ip >> 10)) % _indexSets) * _indexWays;
+    uint32 victim = base;
+    for (uint32 i = base; i < base + _indexWays; i ++) {
+      if (_index[i].valid && _index[i].ip == ip)
+        return i;
+      if (!_index[victim].valid)
+        continue;
+      if (!_index[i].valid || _index[i].head < _index[victim].head)
+        victim = i;
+    }
+    if (_index[victim].valid)
+      RetireStats(victim);
+    _index[victim].valid = true;
+    _index[victim].ip = ip;
+    _index[victim].head = 0;
+    return victim;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to move the statistics of the ip in a slot to the map
+  // -------------------------------------------------------------------------
+
+  void RetireStats(uint32 slot) {
+    IPStats &from = _slotStats[slot];
+    if (from.prefetches == 0 && from.useful == 0 && from.demands == 0)
+      return;
+    IPStats &to = _ipStats[_index[slot].ip];
+    to.prefetches += from.prefetches;
+    to.useful += from.useful;
+    to.demands += from.demands;
+    from.prefetches = from.useful = from.demands = 0;
+  }
+};
+
+#endif // __CMP_GHB_PREFETCHER_H__
@@ -0,0 +1,553 @@
+// -----------------------------------------------------------------------------
+// File: CmpInterconnect.h
+// Description:
+//    Defines an on-chip network between the private caches and a shared
+//    component (usually the LLC). It is placed in the hierarchy of every core,
+//    just above the shared component, and is itself shared. Requests cross it
+//    on the way down and their responses on the way up.
+//
+//    The topology is a crossbar, a bidirectional ring or a mesh. Routes are
+//    computed once when the simulation starts. Each directed link keeps the
+//    cycle at which it is free, and a message reserves the links of its route
+//    in order, so contention costs no events of its own.
+// -----------------------------------------------------------------------------
+
+#ifndef __CMP_INTERCONNECT_H__
+#define __CMP_INTERCONNECT_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "MemoryComponent.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+
+
+// -----------------------------------------------------------------------------
+// Class: CmpInterconnect
+// Description:
+//    Network with per-link bandwidth, per-hop latency and first-come
+//    first-served arbitration of each link.
+//
+//    Nodes. crossbar: one node per core, one switch node and one node per
+//    destination, so every route has two links. ring and mesh: one tile per
+//    core or destination, whichever is more. Core c is on tile c, and
+//    destination d on tile d * tiles / destinations. The ring routes the
+//    shorter way around, the mesh routes X first.
+//
+//    Destinations are the slices of the shared component. A block goes to
+//    the destination selected by destination-hash, which takes the same
+//    values as the slice-hash of the LLC. The hash is applied to the address
+//    the shared component indexes the block by, so a physically tagged LLC
+//    is sliced by physical address.
+//
+//    A message is a header of control-size bytes, plus the block if it
+//    carries data (writebacks on the way down, reads on the way up). It
+//    occupies each link for ceil(bytes / link-width) cycles. Writebacks
+//    are not acknowledged, so their responses are not modeled.
+// -----------------------------------------------------------------------------
+
+class CmpInterconnect : public MemoryComponent {
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  string _topology;
+  uint32 _numDestinations;
+  string _destinationHash;
+  uint32 _meshWidth;
+  uint32 _linkWidth;
+  uint32 _hopLatency;
+  uint32 _controlSize;
+  uint32 _blockSize;
+  uint32 _numBuckets;
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  // state of a directed link
+  struct Link {
+    uint32 from, to;
+    // cycle at which the link is free
+    cycles_t free;
+    // statistics
+    uint64 messages;
+    uint64 busyCycles;
+    vector <uint64> waitHistogram;
+  };
+
+  vector <Link> _links;
+  uint32 _destinationBits;
+
+  // mesh link of each tile and direction
+  enum Direction { EAST, WEST, NORTH, SOUTH, NUM_DIRECTIONS };
+  vector <uint32> _meshLinks;
+
+  // routes[core][destination] from the core and back, as link indices
+  vector <vector <vector <uint32> > > _requestRoutes;
+  vector <vector <vector <uint32> > > _responseRoutes;
+
+  // cycle at which statistics collection started
+  cycles_t _statsStart;
+
+  // -------------------------------------------------------------------------
+  // Declare Counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(requests);
+  NEW_COUNTER(responses);
+  NEW_COUNTER(flits);
+  NEW_COUNTER(queueing_cycles);
+  NEW_COUNTER(network_cycles);
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor. It cannot take any arguments
+  // -------------------------------------------------------------------------
+
+  CmpInterconnect() {
+    _topology = "crossbar";
+    _numDestinations = 1;
+    _destinationHash = "mod";
+    _meshWidth = 0;
+    _linkWidth = 32;
+    _hopLatency = 1;
+    _controlSize = 8;
+    _blockSize = 64;
+    _numBuckets = 8;
+    _statsStart = 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Virtual functions to be implemented by the components
+  // -------------------------------------------------------------------------
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter to the component
+  // -------------------------------------------------------------------------
+
+  void AddParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      // Add the list of parameters to the component here
+      CMP_PARAMETER_STRING("topology", _topology)
+      CMP_PARAMETER_UINT("destinations", _numDestinations)
+      CMP_PARAMETER_STRING("destination-hash", _destinationHash)
+      CMP_PARAMETER_UINT("mesh-width", _meshWidth)
+      CMP_PARAMETER_UINT("link-width", _linkWidth)
+      CMP_PARAMETER_UINT("hop-latency", _hopLatency)
+      CMP_PARAMETER_UINT("control-size", _controlSize)
+      CMP_PARAMETER_UINT("block-size", _blockSize)
+      CMP_PARAMETER_UINT("histogram-buckets", _numBuckets)
+
+    CMP_PARAMETER_END
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to initialize statistics
+  // -------------------------------------------------------------------------
+
+  void InitializeStatistics() {
+    INITIALIZE_COUNTER(requests, "Requests")
+    INITIALIZE_COUNTER(responses, "Responses")
+    INITIALIZE_COUNTER(flits, "Link traversals in cycles")
+    INITIALIZE_COUNTER(queueing_cycles, "Cycles spent waiting for links")
+    INITIALIZE_COUNTER(network_cycles, "Cycles spent in the network")
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation starts
+  // -------------------------------------------------------------------------
+
+  void StartSimulation() {
+
+    if (_numDestinations == 0 ||
+        (_numDestinations & (_numDestinations - 1)) != 0) {
+      fprintf(stderr, "Error: `%s' needs a power of two destinations\n",
+              _name.c_str());
+      exit(-1);
+    }
+    if (_destinationHash.compare("mod") != 0 &&
+        _destinationHash.compare("xor") != 0) {
+      fprintf(stderr, "Error: Unknown destination hash `%s' for `%s'\n",
+              _destinationHash.c_str(), _name.c_str());
+      exit(-1);
+    }
+    if (_linkWidth == 0) _linkWidth = 1;
+    if (_numBuckets == 0) _numBuckets = 1;
+
+    _destinationBits = 0;
+    while ((1U << _destinationBits) < _numDestinations) _destinationBits ++;
+
+    _requestRoutes.assign(_numCPUs,
+                          vector <vector <uint32> > (_numDestinations));
+    _responseRoutes.assign(_numCPUs,
+                           vector <vector <uint32> > (_numDestinations));
+
+    if (_topology.compare("crossbar") == 0)
+      BuildCrossbar();
+    else if (_topology.compare("ring") == 0)
+      BuildRing();
+    else if (_topology.compare("mesh") == 0)
+      BuildMesh();
+    else {
+      fprintf(stderr, "Error: Unknown topology `%s' for `%s'\n",
+              _topology.c_str(), _name.c_str());
+      exit(-1);
+    }
+    RegisterLinkStatistics();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called at a heart beat. Argument indicates cycles elapsed after
+  // previous heartbeat
+  // -------------------------------------------------------------------------
+
+  void HeartBeat(cycles_t hbCount) {
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when warmup ends
+  // -------------------------------------------------------------------------
+
+  void EndWarmUp() {
+    MemoryComponent::EndWarmUp();
+    _statsStart = *_simulatorCycle;
+    for (uint32 i = 0; i < _links.size(); i ++) {
+      _links[i].messages = 0;
+      _links[i].busyCycles = 0;
+      fill(_links[i].waitHistogram.begin(), _links[i].waitHistogram.end(), 0);
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation ends. The link statistics are
+  // registered, so only the utilization of the links that carried messages
+  // is logged here.
+  // -------------------------------------------------------------------------
+
+  void EndSimulation() {
+    DUMP_STATISTICS;
+    cycles_t elapsed = *_simulatorCycle - _statsStart;
+    for (uint32 i = 0; i < _links.size(); i ++) {
+      Link &link = _links[i];
+      if (link.messages == 0) continue;
+      CMP_LOG("link-%u-%u-utilization = %.4lf", link.from, link.to,
+              elapsed == 0 ? 0.0 : (double)link.busyCycles / elapsed);
+    }
+    CLOSE_ALL_LOGS;
+  }
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to process a request. Return value indicates number of busy
+  // cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessRequest(MemoryRequest *request) {
+
+    bool data = false;
+    switch (request -> type) {
+    case MemoryRequest::WRITE:
+    case MemoryRequest::PARTIALWRITE:
+    case MemoryRequest::WRITEBACK:
+      data = true;
+      break;
+    default:
+      break;
+    }
+
+    INCREMENT(requests);
+    Send(request, _requestRoutes[request -> cpuID % _numCPUs]
+         [Destination(request)], data);
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process the return of a request. Return value indicates
+  // number of busy cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessReturn(MemoryRequest *request) {
+
+    bool data = false;
+    switch (request -> type) {
+    case MemoryRequest::READ:
+    case MemoryRequest::READ_FOR_WRITE:
+    case MemoryRequest::PREFETCH:
+      data = true;
+      break;
+    case MemoryRequest::WRITE:
+    case MemoryRequest::PARTIALWRITE:
+    case MemoryRequest::WRITEBACK:
+      return 0;
+    default:
+      break;
+    }
+
+    INCREMENT(responses);
+    Send(request, _responseRoutes[request -> cpuID % _numCPUs]
+         [Destination(request)], data);
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the destination of a request
+  // -------------------------------------------------------------------------
+
+  uint32 Destination(MemoryRequest *request) {
+
+    MemoryComponent *shared =
+      ((*_hier)[request -> cpuID])[request -> cmpID + 1];
+    addr_t ctag = shared -> IndexAddress(VADDR(request), PADDR(request)) /
+      _blockSize;
+    if (_destinationHash.compare("mod") == 0)
+      return ctag & (_numDestinations - 1);
+
+    // fold all the tag bits into the destination index
+    addr_t index = 0;
+    for (; ctag != 0; ctag >>= _destinationBits)
+      index ^= ctag & (_numDestinations - 1);
+    return index;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to send a message along a route. The head of the message waits
+  // for each link in turn and the tail follows it through the last link.
+  // -------------------------------------------------------------------------
+
+  void Send(MemoryRequest *request, vector <uint32> &route, bool data) {
+
+    uint32 bytes = _controlSize + (data ? request -> size : 0);
+    cycles_t occupancy = (bytes + _linkWidth - 1) / _linkWidth;
+    if (occupancy == 0) occupancy = 1;
+
+    cycles_t now = request -> currentCycle;
+    cycles_t head = now;
+
+    for (uint32 i = 0; i < route.size(); i ++) {
+      Link &link = _links[route[i]];
+      cycles_t start = max(head, link.free);
+      cycles_t wait = start - head;
+
+      link.free = start + occupancy;
+      link.messages ++;
+      link.busyCycles += occupancy;
+
+      uint32 bucket = 0;
+      while (bucket + 1 < link.waitHistogram.size() && (1ULL << bucket) <= wait)
+        bucket ++;
+      link.waitHistogram[bucket] ++;
+
+      ADD_TO_COUNTER(queueing_cycles, wait);
+      ADD_TO_COUNTER(flits, occupancy);
+      head = start + _hopLatency;
+    }
+
+    cycles_t latency = head + occupancy - 1 - now;
+    ADD_TO_COUNTER(network_cycles, latency);
+    request -> AddLatency(latency);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to register the statistics of each link. Called once the
+  // topology is built, as the registry keeps pointers into _links
+  // -------------------------------------------------------------------------
+
+  void RegisterLinkStatistics() {
+    if (_statsRegistry == NULL) return;
+    char name[64];
+    for (uint32 i = 0; i < _links.size(); i ++) {
+      Link &link = _links[i];
+      sprintf(name, "link-%u-%u-messages", link.from, link.to);
+      _statsRegistry -> AddScalar(_name, name, "Messages on the link",
+          &link.messages);
+      sprintf(name, "link-%u-%u-busy_cycles", link.from, link.to);
+      _statsRegistry -> AddScalar(_name, name, "Busy cycles of the link",
+          &link.busyCycles);
+      sprintf(name, "link-%u-%u-wait", link.from, link.to);
+      _statsRegistry -> AddHistogram(_name, name,
+          "Link waits by power of two buckets", &link.waitHistogram);
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to add a directed link. Returns its index
+  // -------------------------------------------------------------------------
+
+  uint32 AddLink(uint32 from, uint32 to) {
+    Link link;
+    link.from = from;
+    link.to = to;
+    link.free = 0;
+    link.messages = 0;
+    link.busyCycles = 0;
+    link.waitHistogram.resize(_numBuckets, 0);
+    _links.push_back(link);
+    return _links.size() - 1;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to build a crossbar. Cores are nodes 0 to cores - 1, the switch
+  // is node cores, and destinations follow it.
+  // -------------------------------------------------------------------------
+
+  void BuildCrossbar() {
+
+    uint32 xbar = _numCPUs;
+    vector <uint32> coreIn, coreOut, destIn, destOut;
+
+    for (uint32 c = 0; c < _numCPUs; c ++) {
+      coreIn.push_back(AddLink(c, xbar));
+      coreOut.push_back(AddLink(xbar, c));
+    }
+    for (uint32 d = 0; d < _numDestinations; d ++) {
+      destIn.push_back(AddLink(xbar, xbar + 1 + d));
+      destOut.push_back(AddLink(xbar + 1 + d, xbar));
+    }
+
+    for (uint32 c = 0; c < _numCPUs; c ++) {
+      for (uint32 d = 0; d < _numDestinations; d ++) {
+        _requestRoutes[c][d].push_back(coreIn[c]);
+        _requestRoutes[c][d].push_back(destIn[d]);
+        _responseRoutes[c][d].push_back(destOut[d]);
+        _responseRoutes[c][d].push_back(coreOut[c]);
+      }
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the tile of a destination on the ring or mesh
+  // -------------------------------------------------------------------------
+
+  uint32 NumTiles() {
+    return max(_numCPUs, _numDestinations);
+  }
+
+  uint32 DestinationTile(uint32 d) {
+    return d * NumTiles() / _numDestinations;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to build a bidirectional ring. Link 2t goes from tile t to
+  // t + 1 and link 2t + 1 from tile t to t - 1.
+  // -------------------------------------------------------------------------
+
+  void BuildRing() {
+
+    uint32 tiles = NumTiles();
+    for (uint32 t = 0; t < tiles; t ++) {
+      AddLink(t, (t + 1) % tiles);
+      AddLink(t, (t + tiles - 1) % tiles);
+    }
+
+    for (uint32 c = 0; c < _numCPUs; c ++) {
+      for (uint32 d = 0; d < _numDestinations; d ++) {
+        RingRoute(c, DestinationTile(d), _requestRoutes[c][d]);
+        RingRoute(DestinationTile(d), c, _responseRoutes[c][d]);
+      }
+    }
+  }
+
+  void RingRoute(uint32 from, uint32 to, vector <uint32> &route) {
+    uint32 tiles = NumTiles();
+    uint32 forward = (to + tiles - from) % tiles;
+    bool clockwise = (forward <= tiles - forward);
+    for (uint32 t = from; t != to; ) {
+      if (clockwise) {
+        route.push_back(2 * t);
+        t = (t + 1) % tiles;
+      }
+      else {
+        route.push_back(2 * t + 1);
+        t = (t + tiles - 1) % tiles;
+      }
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to build a mesh. Links are added per tile and direction.
+  // -------------------------------------------------------------------------
+
+  void BuildMesh() {
+
+    uint32 tiles = NumTiles();
+    if (_meshWidth == 0)
+      while (_meshWidth * _meshWidth < tiles) _meshWidth ++;
+    uint32 height = (tiles + _meshWidth - 1) / _meshWidth;
+
+    _meshLinks.assign(tiles * NUM_DIRECTIONS, 0);
+    for (uint32 t = 0; t < tiles; t ++) {
+      uint32 x = t % _meshWidth;
+      uint32 y = t / _meshWidth;
+      if (x + 1 < _meshWidth && t + 1 < tiles)
+        _meshLinks[t * NUM_DIRECTIONS + EAST] = AddLink(t, t + 1);
+      if (x > 0)
+        _meshLinks[t * NUM_DIRECTIONS + WEST] = AddLink(t, t - 1);
+      if (y > 0)
+        _meshLinks[t * NUM_DIRECTIONS + NORTH] = AddLink(t, t - _meshWidth);
+      if (y + 1 < height && t + _meshWidth < tiles)
+        _meshLinks[t * NUM_DIRECTIONS + SOUTH] = AddLink(t, t + _meshWidth);
+    }
+
+    for (uint32 c = 0; c < _numCPUs; c ++) {
+      for (uint32 d = 0; d < _numDestinations; d ++) {
+        MeshRoute(c, DestinationTile(d), _requestRoutes[c][d]);
+        MeshRoute(DestinationTile(d), c, _responseRoutes[c][d]);
+      }
+    }
+  }
+
+  // X first, then Y. From the end of a partial last row the route goes north
+  // before east, so every hop is on an existing link.
+  void MeshRoute(uint32 from, uint32 to, vector <uint32> &route) {
+    uint32 tx = to % _meshWidth;
+    uint32 t = from;
+    while (t != to) {
+      uint32 x = t % _meshWidth;
+      Direction dir;
+      if (x < tx && t + 1 < NumTiles()) dir = EAST;
+      else if (x > tx) dir = WEST;
+      else if (t / _meshWidth < to / _meshWidth) dir = SOUTH;
+      else dir = NORTH;
+      route.push_back(_meshLinks[t * NUM_DIRECTIONS + dir]);
+      switch (dir) {
+      case EAST: t ++; break;
+      case WEST: t --; break;
+      case NORTH: t -= _meshWidth; break;
+      default: t += _meshWidth; break;
+      }
+    }
+  }
+};
+
+#endif // __CMP_INTERCONNECT_H__
@@ -8,10 +8,17 @@
 
 /*
 It is the job of LLC to generate writebacks with good row buffer locality that are to be sent to the
-memory controller so that it can make use of this locality to avoid turnaround time ( and write recovery latency) in the channel 
+memory controller so that it can make use of this locality to avoid turnaround time ( and write recovery latency) in the channel
 (aggressive write back)
-Right now, we assume that  the memory controller does this correctly, if it does not, we will have to look into 
+Right now, we assume that  the memory controller does this correctly, if it does not, we will have to look into
 behaviour of memory controller
+
+Since the tag store holds no dirty state, a read that is predicted to miss can skip the tag lookup and go
+straight to memory (bypass-prediction). Only the DBI is checked, because memory has stale data for a
+block that is dirty in the cache. The predictor is a table of saturating counters indexed by cpu or by
+instruction pointer (bypass-predictor), optionally backed by the last hit/miss outcome of recently
+accessed regions (bypass-region-size). The tag store is still probed without updating replacement
+state to train the predictor and measure its accuracy.
 */
 
 #ifndef __CMP_LLC_DBI_H__
@@ -21,469 +28,483 @@ behaviour of memory controller
 // Module includes
 // -----------------------------------------------------------------------------
 
-#include "MemoryComponent.h"
-#include "Types.h"
-#include "GenericTagStore.h"
+#include "LLCEngine.h"
+#include "LLCHooks.h"
+#include "DirtyBitmap.h"
 
 // -----------------------------------------------------------------------------
 // Standard includes
 // -----------------------------------------------------------------------------
 
-#include <iostream>
-#include <bitset>
-#include <fstream>
-#include <string>
 
 // -----------------------------------------------------------------------------
-// Few defines
+// Members of the DBI module that the modules above it use
 // -----------------------------------------------------------------------------
 
-#define NUMBER_OF_ROWS 128
-#define BLOCKS_PER_ROW 128
-#define NUMBER_OF_BANKS 8
+#define LLC_DBI_MODULE_MEMBERS(Base) \
+  typedef typename Base::DBIEntry DBIEntry;\
+  using Base::_dbi;\
+  using Base::_blocksPerRow;\
+  using Base::IsDirtyBlock;
+
 
 // -----------------------------------------------------------------------------
-// Class: CmpLLCDBI
+// Class: LLCDirtyBlockIndex
 // Description:
-//    Baseline lastlevel cache with DBI.
+//    Keeps the dirty bits of the cache in a dirty block index (DBI) instead
+//    of the tag store. A DBI entry holds the dirty bits of the blocks of a
+//    logical row. When an entry is evicted from the DBI, the dirty blocks of
+//    its row are written back and removed from the cache. The DBI tells a
+//    DBI-aware memory controller which blocks of an open row are dirty.
 // -----------------------------------------------------------------------------
 
-class CmpLLCDBI : public MemoryComponent {
+template <class Base>
+class LLCDirtyBlockIndex : public Base {
 
 protected:
 
+  LLC_HOOK_MODULE_MEMBERS(Base)
+
   // -------------------------------------------------------------------------
   // Parameters
   // -------------------------------------------------------------------------
 
-  uint32 _size;					// this is the size of in kB of the LLC
-  uint32 _blockSize;
-  uint32 _associativity;
-  string _policy;
   string _dbipolicy;
-  uint32 _policyVal;
   uint32 _dbiPolicyVal;
-
-  uint32 _tagStoreLatency;
-  uint32 _dataStoreLatency;
-
-  uint32 _dbiSize;
+  uint32 _dbiSize;				// number of dbi entries. 0 covers the cache
+  uint32 _dbiAssociativity;			// 0 makes the dbi fully associative
+  uint32 _blocksPerRow;				// blocks tracked by a dbi entry
 
   // -------------------------------------------------------------------------
   // Private members
   // -------------------------------------------------------------------------
 
-  struct TagEntry {
-    //bool dirty;
-    addr_t vcla;
-    addr_t pcla;
-    uint32 appID;
-    TagEntry() { //dirty = false; 
-    }
-  };
-
   struct DBIEntry {
-    bitset <BLOCKS_PER_ROW> dirtyBits;
-    // pointer to a clean request for this current row ?   
-    DBIEntry() { 
-    dirtyBits.reset(); 
+    dirty_bitmap_t dirtyBits;
+    DBIEntry(uint32 blocksPerRow = 0) : dirtyBits(blocksPerRow) {
     }
   };
 
-
-  // tag store
-  uint32 _numSets;
-  generic_tagstore_t <addr_t, TagEntry> _tags;
   generic_tagstore_t <addr_t, DBIEntry> _dbi;
-  policy_value_t _pval;
   policy_value_t _dbipval;
 
-  // dbi
-  uint32 _numdbiEntries;
-
-  // per processor hit/miss counters
-  vector <uint32> _hits;
-  vector <uint32> _misses;
-
-  // -------------------------------------------------------------------------
-  // Output file
-  // -------------------------------------------------------------------------
-
-
   // -------------------------------------------------------------------------
   // Declare Counters
   // -------------------------------------------------------------------------
 
-  NEW_COUNTER(accesses);
-  NEW_COUNTER(reads);
-  NEW_COUNTER(writebacks);
-  NEW_COUNTER(misses);
-  NEW_COUNTER(evictions);
-  NEW_COUNTER(dirty_evictions);
   NEW_COUNTER(dbievictions);
-
   NEW_COUNTER(dbi_eviction_writebacks);
   NEW_COUNTER(tagstore_eviction_writebacks);
   NEW_COUNTER(dbi_misses);
   NEW_COUNTER(dbi_hits);
-// The last two are dicey
+  NEW_COUNTER(pulled_writebacks);
 
-
-public:
+  // check if the DBI holds the dirty bit of a block
+  bool IsDirtyBlock(addr_t ctag) {
+    addr_t logicalRow = ctag / _blocksPerRow;
+    return _dbi.lookup(logicalRow) &&
+      _dbi[logicalRow].dirtyBits[ctag % _blocksPerRow];
+  }
 
   // -------------------------------------------------------------------------
-  // Constructor. It cannot take any arguments
-  // By default, dbi size is equal to the cache size
+  // Function to set the dirty bit of a block whose row is not in the DBI.
+  // If the insert evicts a DBI entry, the dirty blocks of its row are
+  // written back and removed from the cache, so that no block is dirty
+  // without a DBI entry.
   // -------------------------------------------------------------------------
 
-  CmpLLCDBI() {
-    _size = 1024;
-    _blockSize = 64;
-    _associativity = 16;
-    _tagStoreLatency = 6;
-    _dataStoreLatency = 15;
-    _policy = "lru";
-    _dbipolicy = "lru";
-    _policyVal = 0;
-    _dbiPolicyVal = 0;
-    _dbiSize = 0;			// to be used later for size
+  void InsertDirtyRow(MemoryRequest *request, addr_t ctag) {
+
+    addr_t logicalRow = ctag / _blocksPerRow;
+    bool evicted = !_dbi.lookup(logicalRow);
+
+    typename table_t <addr_t, DBIEntry>::entry dbientry =
+      _dbi.insert(logicalRow, DBIEntry(_blocksPerRow), _dbipval);
+    _dbi[logicalRow].dirtyBits.set(ctag % _blocksPerRow);
+    INCREMENT(dbi_misses);
+
+    if (!evicted || !dbientry.valid)
+      return;
+
+    INCREMENT(dbievictions);
+
+    // generate writebacks for all dirty blocks in the row
+    dirty_bitmap_t &evictedBits = dbientry.value.dirtyBits;
+    for (uint32 i = evictedBits.first(); i < _blocksPerRow;
+         i = evictedBits.next(i)) {
+      addr_t discardtag = (dbientry.key * _blocksPerRow) + i;
+      if (!_tags.lookup(discardtag))
+        continue;
+      TagTableEntry discarded = InvalidateBlock(request, discardtag);
+      SendToNextComponent(NewRequest(MemoryRequest::WRITEBACK, request,
+                                     discarded.value.vcla,
+                                     discarded.value.pcla));
+      INCREMENT(dbi_eviction_writebacks);
+    }
   }
 
+public:
 
-  // -------------------------------------------------------------------------
-  // Virtual functions to be implemented by the components
-  // -------------------------------------------------------------------------
+  // By default, dbi size is equal to the cache size
+  LLCDirtyBlockIndex() {
+    _dbipolicy = "lru";
+    _dbiPolicyVal = 0;
+    _dbiSize = 0;
+    _dbiAssociativity = 0;
+    _blocksPerRow = 128;
+  }
 
-  // -------------------------------------------------------------------------
-  // Function to add a parameter to the component
-  // -------------------------------------------------------------------------
+  bool AddHookParameter(string pname, string pvalue) {
 
-  void AddParameter(string pname, string pvalue) {
-      
     CMP_PARAMETER_BEGIN
 
-      // Add the list of parameters to the component here
-      CMP_PARAMETER_UINT("size", _size)
-      CMP_PARAMETER_UINT("block-size", _blockSize)
-      CMP_PARAMETER_UINT("associativity", _associativity)
-      CMP_PARAMETER_STRING("policy", _policy)
       CMP_PARAMETER_STRING("dbi-policy", _dbipolicy)
-      CMP_PARAMETER_UINT("policy-value", _policyVal)
       CMP_PARAMETER_UINT("dbi-policy-value", _dbiPolicyVal)
-      CMP_PARAMETER_UINT("tag-store-latency", _tagStoreLatency)
-      CMP_PARAMETER_UINT("data-store-latency", _dataStoreLatency)
       CMP_PARAMETER_UINT("dbi-size", _dbiSize)
-      
-    CMP_PARAMETER_END
+      CMP_PARAMETER_UINT("dbi-associativity", _dbiAssociativity)
+      CMP_PARAMETER_UINT("blocks-per-row", _blocksPerRow)
+      else return Base::AddHookParameter(pname, pvalue);
+
+    return true;
   }
 
+  void InitializeHookStatistics() {
 
-  // -------------------------------------------------------------------------
-  // Function to initialize statistics
-  // -------------------------------------------------------------------------
-
-  void InitializeStatistics() {
+    Base::InitializeHookStatistics();
 
-    INITIALIZE_COUNTER(accesses, "Total Accesses");
-    INITIALIZE_COUNTER(reads, "Read Accesses");
-    INITIALIZE_COUNTER(writebacks, "Writeback Accesses");
-    INITIALIZE_COUNTER(misses, "Total Misses");
-    INITIALIZE_COUNTER(evictions, "Evictions");
-    INITIALIZE_COUNTER(dirty_evictions, "Dirty Evictions");
     INITIALIZE_COUNTER(dbievictions, "DBI Evictions");
     INITIALIZE_COUNTER(dbi_eviction_writebacks, "DBI Eviction Writebacks");
     INITIALIZE_COUNTER(tagstore_eviction_writebacks, "Tagstore Eviction Writebacks");
     INITIALIZE_COUNTER(dbi_misses, "DBI Accesses");
     INITIALIZE_COUNTER(dbi_hits, "DBI Hits");
+    INITIALIZE_COUNTER(pulled_writebacks, "Writebacks Pulled by the Memory Controller");
   }
 
+  void StartHooks() {
 
-  // -------------------------------------------------------------------------
-  // Function called when simulation starts
-  // -------------------------------------------------------------------------
-
-  void StartSimulation() {
-
-    _numSets = (_size * 1024) / (_blockSize * _associativity);
-
-     _numdbiEntries = _dbiSize;
+    Base::StartHooks();
 
-    _tags.SetTagStoreParameters(_numSets, _associativity, _policy);
-    _dbi.SetTagStoreParameters(1, _numdbiEntries, _dbipolicy);
+    // by default the dbi tracks as many blocks as the cache holds
+    if (_dbiSize == 0)
+      _dbiSize = max((_numSets * _associativity) / _blocksPerRow, (uint32)1);
 
-    switch (_policyVal) {
-    case 0: _pval = POLICY_HIGH; break;
-    case 1: _pval = POLICY_BIMODAL; break;
-    case 2: _pval = POLICY_LOW; break;
-    }
+    if (_dbiAssociativity == 0 || _dbiAssociativity > _dbiSize)
+      _dbiAssociativity = _dbiSize;
+    uint32 dbiSets = (_dbiAssociativity == 0) ? 1 : _dbiSize / _dbiAssociativity;
+    _dbi.SetTagStoreParameters(dbiSets, _dbiAssociativity, _dbipolicy);
 
     switch (_dbiPolicyVal) {
     case 0: _dbipval = POLICY_HIGH; break;
     case 1: _dbipval = POLICY_BIMODAL; break;
     case 2: _dbipval = POLICY_LOW; break;
+    default:
+      fprintf(stderr, "Error: Unknown dbi policy value %u for `%s'\n",
+              _dbiPolicyVal, _name.c_str());
+      exit(-1);
     }
-                           
-    _hits.resize(_numCPUs, 0);
-    _misses.resize(_numCPUs, 0);
   }
 
-
   // -------------------------------------------------------------------------
-  // Function called at a heart beat. Argument indicates cycles elapsed after
-  // previous heartbeat
+  // Dirty row query used by DBI-aware memory controllers
   // -------------------------------------------------------------------------
 
-  void HeartBeat(cycles_t hbCount) {
+  bool TracksDirtyRows() {
+    return true;
   }
 
+  void DirtyRowBlocks(MemoryRequest *request, vector <addr_t> &vblocks,
+      vector <addr_t> &pblocks) {
+
+    addr_t ctag = Self() -> BlockTag(VADDR(request), PADDR(request));
+    addr_t logicalRow = ctag / _blocksPerRow;
+    if (!_dbi.lookup(logicalRow))
+      return;
+
+    dirty_bitmap_t &dirtyBits = _dbi[logicalRow].dirtyBits;
+    for (uint32 i = dirtyBits.first(); i < _blocksPerRow; i = dirtyBits.next(i)) {
+      addr_t tag = (logicalRow * _blocksPerRow) + i;
+      if (tag == ctag || !_tags.lookup(tag))
+        continue;
+      vblocks.push_back(_tags[tag].vcla);
+      pblocks.push_back(_tags[tag].pcla);
+    }
+  }
 
-protected:
+  MemoryRequest *CleanBlock(addr_t vblock, addr_t pblock,
+                            MemoryRequest *request) {
 
-  // -------------------------------------------------------------------------
-  // Function to process a request. Return value indicates number of busy
-  // cycles for the component.
-  // -------------------------------------------------------------------------
+    addr_t ctag = Self() -> BlockTag(vblock, pblock);
+    addr_t logicalRow = ctag / _blocksPerRow;
+    if (!_tags.lookup(ctag) || !IsDirtyBlock(ctag))
+      return NULL;
 
+    _dbi[logicalRow].dirtyBits.reset(ctag % _blocksPerRow);
+    if (!_dbi[logicalRow].dirtyBits.any())
+      _dbi.invalidate(logicalRow);
 
-  cycles_t ProcessRequest(MemoryRequest *request) {
+    INCREMENT(pulled_writebacks);
+    return NewRequest(MemoryRequest::WRITEBACK, request,
+                      _tags[ctag].vcla, _tags[ctag].pcla);
+  }
 
-    // update stats
-    INCREMENT(accesses);
+  // -------------------------------------------------------------------------
+  // Hooks
+  // -------------------------------------------------------------------------
 
-    table_t <addr_t, TagEntry>::entry tagentry;
-    table_t <addr_t, DBIEntry>::entry dbientry;
-    cycles_t latency;
+  void MarkDirty(MemoryRequest *request, addr_t ctag) {
 
-    // NO WRITES (Complete or partial)
-    if (request -> type == MemoryRequest::WRITE || 
-        request -> type == MemoryRequest::PARTIALWRITE) {
-      fprintf(stderr, "LLC annot handle direct writes (yet)\n");
-      exit(0);
+    addr_t logicalRow = ctag / _blocksPerRow;
+    if (_dbi.lookup(logicalRow)) {
+      _dbi[logicalRow].dirtyBits.set(ctag % _blocksPerRow);
+      INCREMENT(dbi_hits);
+      // dummy read to update the replacement policy
+      _dbi.read(logicalRow);
     }
+    else
+      InsertDirtyRow(request, ctag);
+  }
 
-    // compute the cache block tag
-    addr_t ctag = VADDR(request) / _blockSize;
-
-    // compute the cache block logical row, this is used to key into dbi, like ctag is used for tagstores
-    addr_t logicalRow = ctag / BLOCKS_PER_ROW;	
-
-    // check if its a read or write back
-    switch (request -> type) {
+  // the DBI entry is inserted before the block, so that the blocks it
+  // removes free up ways in the set
+  void OnInsert(MemoryRequest *request, addr_t ctag, TagEntry &entry,
+                policy_value_t priority) {
+    Base::OnInsert(request, ctag, entry, priority);
+    if (entry.dirty)
+      InsertDirtyRow(request, ctag);
+  }
 
-      // READ request
-    case MemoryRequest::READ:
-    case MemoryRequest::READ_FOR_WRITE:
-    case MemoryRequest::PREFETCH:
+  bool IsDirty(MemoryRequest *request, TagTableEntry &victim) {
 
-      INCREMENT(reads);
-          
-      tagentry = _tags.read(ctag);
+    if (!IsDirtyBlock(victim.key))
+      return false;
 
-      if (tagentry.valid) {
-        request -> serviced = true;
-        request -> AddLatency(_tagStoreLatency + _dataStoreLatency);
+    // clean the block, and remove the row once its last dirty bit is reset
+    addr_t logicalRow = victim.key / _blocksPerRow;
+    _dbi[logicalRow].dirtyBits.reset(victim.key % _blocksPerRow);
+    if (!_dbi[logicalRow].dirtyBits.any())
+      _dbi.invalidate(logicalRow);
 
-        // update per processor counters
-        _hits[request -> cpuID] ++;
-      }
-      else {
-        INCREMENT(misses);
-        request -> AddLatency(_tagStoreLatency);
+    INCREMENT(tagstore_eviction_writebacks);
+    return true;
+  }
+};
 
-        _misses[request -> cpuID] ++;
-      }
-          
-      return _tagStoreLatency;
 
+// -----------------------------------------------------------------------------
+// Class: LLCLookupBypass
+// Description:
+//    Sends reads that are predicted to miss to memory without a tag lookup,
+//    unless the DBI says the block is dirty. Expects the DBI module below it.
+// -----------------------------------------------------------------------------
 
-      // WRITEBACK request
-    case MemoryRequest::WRITEBACK:
+template <class Base>
+class LLCLookupBypass : public Base {
 
-      INCREMENT(writebacks);
+protected:
 
-      if (_tags.lookup(ctag))
-        {
+  LLC_HOOK_MODULE_MEMBERS(Base)
+  LLC_DBI_MODULE_MEMBERS(Base)
 
-	// this one sets the dirty bit alongwith doing the replacement policy
-        if(_dbi.lookup(logicalRow)){	_dbi[logicalRow].dirtyBits.set(ctag % BLOCKS_PER_ROW);	
-	// Not all clean blocks are guaranteed to have their dirty bit info in the DBI
-	INCREMENT(dbi_hits);
-	// dummy read to update with replacement policy
-        _dbi.read(logicalRow);
-        }
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
 
-	else{
-        table_t <addr_t, DBIEntry>::entry dbientry;    
+  uint32 _dbiLatency;
+  bool _bypassPrediction;
+  string _bypassPredictor;			// cpu or ip
+  uint32 _bypassTableSize;			// entries of the ip indexed table
+  uint32 _bypassCounterMax;
+  uint32 _bypassThreshold;			// predict a miss at or above this value
+  uint32 _bypassRegionSize;			// 0 disables the region history
+  uint32 _bypassRegionEntries;
 
-	HANDLE_DBI_INSERTION(ctag, request, dbientry, true);
-// this will handle dbi insertion when tagstore entry is not present
-        }
-	        
-      }
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
 
-      else
-        INSERT_BLOCK(ctag, true, request);	
+  // bypass predictor. the region history stores whether the last access
+  // to the region hit
+  vector <saturating_counter> _bypassTable;
+  generic_tagstore_t <addr_t, bool> _regionHistory;
 
-      request -> serviced = true;
-      return _tagStoreLatency;
-    }
-  }
+  // -------------------------------------------------------------------------
+  // Declare Counters
+  // -------------------------------------------------------------------------
 
+  NEW_COUNTER(bypass_predictions);
+  NEW_COUNTER(bypasses);
+  NEW_COUNTER(bypass_dirty_blocks);
+  NEW_COUNTER(bypass_lost_hits);
+  NEW_COUNTER(bypass_missed_misses);
+  NEW_COUNTER(bypass_saved_cycles);
 
   // -------------------------------------------------------------------------
-  // Function to process the return of a request. Return value indicates
-  // number of busy cycles for the component.
+  // Bypass predictor. A region that hit on its last access overrides a
+  // miss prediction of the counter
   // -------------------------------------------------------------------------
-    
-  cycles_t ProcessReturn(MemoryRequest *request) { 
-
-    // if its a writeback from this component, delete it
-    if (request -> iniType == MemoryRequest::COMPONENT &&
-        request -> iniPtr == this) {
-      request -> destroy = true;
-      return 0;
-    }
-
-    // get the cache block tag
-    addr_t ctag = VADDR(request) / _blockSize;
 
-    // if the block is already present, return
-    if (_tags.lookup(ctag))
-      return 0;
+  uint32 BYPASS_INDEX(MemoryRequest *request) {
+    if (_bypassPredictor.compare("cpu") == 0)
+      return request -> cpuID;
+    return request -> ip % _bypassTableSize;
+  }
 
-    INSERT_BLOCK(ctag, false, request);
+  bool PREDICT_MISS(MemoryRequest *request) {
+    if (_bypassTable[BYPASS_INDEX(request)] < _bypassThreshold)
+      return false;
+    if (_bypassRegionSize == 0)
+      return true;
+    addr_t region = VADDR(request) / _bypassRegionSize;
+    return !(_regionHistory.lookup(region) && _regionHistory[region]);
+  }
 
-    return 0;
+  void TRAIN_BYPASS_PREDICTOR(MemoryRequest *request, bool hit) {
+    saturating_counter &counter = _bypassTable[BYPASS_INDEX(request)];
+    if (hit) counter.decrement();
+    else counter.increment();
+
+    if (_bypassRegionSize == 0)
+      return;
+    addr_t region = VADDR(request) / _bypassRegionSize;
+    if (_regionHistory.lookup(region)) {
+      _regionHistory.read(region);
+      _regionHistory[region] = hit;
+    }
+    else
+      _regionHistory.insert(region, hit);
   }
 
+public:
 
-  // -------------------------------------------------------------------------
-  // Function to insert a block into the cache
-  // Should check for DBI evictions also
-  // -------------------------------------------------------------------------
+  LLCLookupBypass() {
+    _dbiLatency = 1;
+    _bypassPrediction = false;
+    _bypassPredictor = "ip";
+    _bypassTableSize = 1024;
+    _bypassCounterMax = 3;
+    _bypassThreshold = 3;
+    _bypassRegionSize = 0;
+    _bypassRegionEntries = 256;
+  }
 
-  void INSERT_BLOCK(addr_t ctag, bool dirty, MemoryRequest *request) {
+  bool AddHookParameter(string pname, string pvalue) {
 
-    table_t <addr_t, TagEntry>::entry tagentry;
-    table_t <addr_t, DBIEntry>::entry dbientry;
-    
-    bool DBIevictedEntry;			// indicates if dbientry is evicted or was already present, true if evicted
+    CMP_PARAMETER_BEGIN
 
-    addr_t logicalRow = ctag / BLOCKS_PER_ROW;	
+      CMP_PARAMETER_UINT("dbi-latency", _dbiLatency)
+      CMP_PARAMETER_BOOLEAN("bypass-prediction", _bypassPrediction)
+      CMP_PARAMETER_STRING("bypass-predictor", _bypassPredictor)
+      CMP_PARAMETER_UINT("bypass-table-size", _bypassTableSize)
+      CMP_PARAMETER_UINT("bypass-counter-max", _bypassCounterMax)
+      CMP_PARAMETER_UINT("bypass-threshold", _bypassThreshold)
+      CMP_PARAMETER_UINT("bypass-region-size", _bypassRegionSize)
+      CMP_PARAMETER_UINT("bypass-region-entries", _bypassRegionEntries)
+      else return Base::AddHookParameter(pname, pvalue);
+
+    return true;
+  }
 
-    DBIevictedEntry = !(_dbi.lookup(logicalRow));
+  void InitializeHookStatistics() {
 
-/*
-The following FSM has been implemented :
-1. First insert into _dbi.
-2. If returned dbientry was valid and evicted, generate writebacks for all the entries corresponding to dirty bits in the 
-   evicted dbientry. (nothing to be done when dbientry is valid and already present) Also, delete the tagstore entries 
-   corresponding to these dirty bits. 
-3. Now insert into _tags.
-4. If returned tagentry is valid and dirty (evicted or already present), then generate writeback. 
-*/
+    Base::InitializeHookStatistics();
 
-// if returned entry is due to free list in table, then bool valid will be false
+    INITIALIZE_COUNTER(bypass_predictions, "Reads predicted to miss");
+    INITIALIZE_COUNTER(bypasses, "Reads that bypassed the tag lookup");
+    INITIALIZE_COUNTER(bypass_dirty_blocks, "Predicted misses stopped by the DBI");
+    INITIALIZE_COUNTER(bypass_lost_hits, "Bypassed reads that would have hit");
+    INITIALIZE_COUNTER(bypass_missed_misses, "Misses predicted to hit");
+    INITIALIZE_COUNTER(bypass_saved_cycles, "Lookup cycles saved by bypasses");
+  }
 
-// How to differentiate between evicted and already present, use evictedEntry and lookup
+  void StartHooks() {
 
+    Base::StartHooks();
 
-if(dirty)	HANDLE_DBI_INSERTION(ctag, request, dbientry, DBIevictedEntry);
-     
+    if (_bypassPrediction) {
+      if (_bypassPredictor.compare("cpu") == 0)
+        _bypassTableSize = _numCPUs;
+      else if (_bypassPredictor.compare("ip") != 0) {
+        fprintf(stderr, "Unknown bypass predictor %s\n", _bypassPredictor.c_str());
+        exit(0);
+      }
+      _bypassTable.resize(_bypassTableSize, saturating_counter(_bypassCounterMax, 0));
+      if (_bypassRegionSize != 0)
+        _regionHistory.SetTagStoreParameters(1, _bypassRegionEntries, "lru");
+    }
+  }
 
-// 3. and 4.
+  void LogHookStatistics() {
 
-tagentry = _tags.insert(ctag, TagEntry(), _pval);
+    Base::LogHookStatistics();
 
-    _tags[ctag].vcla = BLOCK_ADDRESS(VADDR(request), _blockSize);
-    _tags[ctag].pcla = BLOCK_ADDRESS(PADDR(request), _blockSize);
-    _tags[ctag].appID = request -> cpuID;		
-    //_dbi.read(logicalRow).value.dirtyBits[ctag % BLOCKS_PER_ROW] = dirty; // already done above    
+    if (_bypassPrediction) {
+      uint64 wrong = bypass_lost_hits + bypass_missed_misses;
+      CMP_LOG("bypass-accuracy = %.4lf", reads == 0 ? 0.0 :
+          1.0 - (double)wrong / reads);
+      // misses includes bypassed reads that would have hit
+      uint64 tagMisses = misses - bypass_lost_hits;
+      CMP_LOG("bypass-coverage = %.4lf", tagMisses == 0 ? 0.0 :
+          (double)(bypasses - bypass_lost_hits) / tagMisses);
+      CMP_LOG("bypass-average-saved-cycles = %.2lf", reads == 0 ? 0.0 :
+          (double)bypass_saved_cycles / reads);
+    }
+  }
 
-    if (tagentry.valid) {
-    // this will let in entries that were evicted, tagentry is always evicted
+  // -------------------------------------------------------------------------
+  // Consults and trains the bypass predictor for a read. A bypassed read
+  // is a miss that does not go through OnMiss
+  // -------------------------------------------------------------------------
 
-      INCREMENT(evictions);		
+  bool SkipLookup(MemoryRequest *request, addr_t ctag, cycles_t &busyCycles) {
 
-     bool specialCase = false;
-     if(dirty)	specialCase = (((dbientry.key == (tagentry.key) / BLOCKS_PER_ROW)&&(dbientry.value.dirtyBits[(tagentry.key) % BLOCKS_PER_ROW])))?true:false;
+    if (!_bypassPrediction)
+      return Base::SkipLookup(request, ctag, busyCycles);
 
+    // probe the tags without touching the replacement state
+    bool hit = _tags.lookup(ctag);
+    bool predictMiss = PREDICT_MISS(request);
+    TRAIN_BYPASS_PREDICTOR(request, hit);
 
-      if (((_dbi.lookup((tagentry.key) / BLOCKS_PER_ROW))&&(_dbi[(tagentry.key) / BLOCKS_PER_ROW].dirtyBits[(tagentry.key) % BLOCKS_PER_ROW])) || specialCase) { 
-    // this will let in entries that were dirty, specialCase leads to extrememly rare dirty evictions
-  
-        INCREMENT(dirty_evictions);
+    if (!predictMiss) {
+      if (!hit) INCREMENT(bypass_missed_misses);
+      return false;
+    }
 
-        // We should check if the dbientry is still present in the DBI, only then clean the corresponding bit
-	if(_dbi.lookup((tagentry.key) / BLOCKS_PER_ROW))	
-        //_dbi.read(logicalRow).value.dirtyBits.reset(ctag % BLOCKS_PER_ROW);	// no need for replacement policy here also
-	_dbi[(tagentry.key) / BLOCKS_PER_ROW].dirtyBits.reset((tagentry.key) % BLOCKS_PER_ROW);
-        // This is a cleaning operation, clean entry in DBI if present
+    INCREMENT(bypass_predictions);
 
-	// ********   also invalidate row if it was the last set bit
-        if(!(_dbi[(tagentry.key) / BLOCKS_PER_ROW].dirtyBits.any()))	_dbi.invalidate((tagentry.key) / BLOCKS_PER_ROW);
+    // memory has stale data for a dirty block
+    if (IsDirtyBlock(ctag)) {
+      INCREMENT(bypass_dirty_blocks);
+      return false;
+    }
 
-        MemoryRequest *writeback =
-          new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                            MemoryRequest::WRITEBACK, request -> cmpID, 
-                            tagentry.value.vcla, tagentry.value.pcla, _blockSize,
-                            request -> currentCycle);
-        // Generating writebacks when entry was already present and dirty, is it necessary (for memory consistency perhaps?)
-	INCREMENT(tagstore_eviction_writebacks);
-        writeback -> icount = request -> icount;
-        writeback -> ip = request -> ip;
-        SendToNextComponent(writeback);
-      } 
+    INCREMENT(bypasses);
+    INCREMENT(misses);
+    request -> AddLatency(_dbiLatency);
 
+    if (hit) {
+      INCREMENT(bypass_lost_hits);
+    }
+    else if (_tagStoreLatency > _dbiLatency) {
+      ADD_TO_COUNTER(bypass_saved_cycles, _tagStoreLatency - _dbiLatency);
     }
-  }
 
-void HANDLE_DBI_INSERTION(addr_t ctag, MemoryRequest *request, table_t <addr_t, DBIEntry>::entry &dbientry, bool DBIevictedEntry){
- 
-    addr_t logicalRow = ctag / BLOCKS_PER_ROW;	
+    // only the DBI is looked up
+    if (_numSlices == 1)
+      busyCycles = _dbiLatency;
+    return true;
+  }
+};
 
-// 1.
-    dbientry = _dbi.insert(logicalRow, DBIEntry(), _dbipval);
-    _dbi[logicalRow].dirtyBits.set(ctag % BLOCKS_PER_ROW);
-    
-    INCREMENT(dbi_misses);
 
-// 2. 
-    if(DBIevictedEntry && dbientry.valid){
-    INCREMENT(dbievictions);    
-    
-    // generate writebacks for all dirty blocks in the row
-      for(uint64 i=0;i<BLOCKS_PER_ROW;i++){
-           
-          if(dbientry.value.dirtyBits[i]){ 
-          addr_t discardtag = (dbientry.key * BLOCKS_PER_ROW) + i;
-       
-	  // now check if the corresponding block is present in the tagstore
-	  // if not, no need to generate writebacks
-	  if(_tags.lookup(discardtag)){
-          
-	  // we have to generate writebacks and remove tagstore entries too
-	  // if we do not remove the tagstore entries, we may have cases where tagentry is there but dbientry is not
-          
-	  table_t <addr_t, TagEntry>::entry discardentry;
-	  discardentry = _tags.invalidate(discardtag);
-          
-          MemoryRequest *writeback =
-          new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                            MemoryRequest::WRITEBACK, request -> cmpID, 
-                            discardentry.value.vcla, discardentry.value.pcla, _blockSize,
-                            request -> currentCycle);
-          
-	  INCREMENT(dbi_eviction_writebacks);
-          writeback -> icount = request -> icount;
-          writeback -> ip = request -> ip;
-          SendToNextComponent(writeback);
-          }
-        }
-      }
-    }
-  }
+// -----------------------------------------------------------------------------
+// Class: CmpLLCDBI
+// Description:
+//    Baseline lastlevel cache with DBI.
+// -----------------------------------------------------------------------------
 
+class CmpLLCDBI :
+  public LLCLookupBypass <LLCDirtyBlockIndex <CmpLLCEngine <CmpLLCDBI> > > {
 };
 
 #endif // __CMP_LLC_DBI_H__
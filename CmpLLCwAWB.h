@@ -9,10 +9,15 @@
 
 /*
 It is the job of LLC to generate writebacks with good row buffer locality that are to be sent to the
-memory controller so that it can make use of this locality to avoid turnaround time ( and write recovery latency) in the channel 
+memory controller so that it can make use of this locality to avoid turnaround time ( and write recovery latency) in the channel
 (aggressive write back)
-Right now, we assume that  the memory controller does this correctly, if it does not, we will have to look into 
+Right now, we assume that  the memory controller does this correctly, if it does not, we will have to look into
 behaviour of memory controller
+
+A row is drained as one batch: a single CLEAN request emits the writebacks for all dirty blocks of
+the row back to back, so that the controller's write queue finds them together and can schedule
+them as row hits. The writebacks of a batch share a WritebackDrain, in which the memory controller
+counts their row buffer hits. The counts are accounted when the last writeback of the batch returns.
 */
 
 #ifndef __CMP_LLC_AWB_H__
@@ -22,89 +27,35 @@ behaviour of memory controller
 // Module includes
 // -----------------------------------------------------------------------------
 
-#include "MemoryComponent.h"
-#include "Types.h"
-#include "GenericTagStore.h"
+#include "LLCEngine.h"
+#include "LLCHooks.h"
+#include "CmpLLCDBI.h"
 
 // -----------------------------------------------------------------------------
 // Standard includes
 // -----------------------------------------------------------------------------
 
-#include <iostream>
-#include <bitset>
-#include <fstream>
-#include <string>
-
-// -----------------------------------------------------------------------------
-// Few defines
-// -----------------------------------------------------------------------------
-
-#define NUMBER_OF_ROWS 128
-#define BLOCKS_PER_ROW 128
-#define NUMBER_OF_BANKS 8
 
 // -----------------------------------------------------------------------------
-// Class: CmpLLCwAWB
+// Class: LLCAggressiveWriteback
 // Description:
-//    Baseline lastlevel cache with DBI and implementing aggressive writeback.
+//    When a dirty block is evicted and its row still has dirty blocks, sends
+//    a CLEAN request for the row to this component. The CLEAN request drains
+//    the row: it writes back all its dirty blocks and removes its DBI entry.
+//    Only one row is cleaned at a time. Expects the DBI module below it.
 // -----------------------------------------------------------------------------
 
-class CmpLLCwAWB : public MemoryComponent {
+template <class Base>
+class LLCAggressiveWriteback : public Base {
 
 protected:
 
-  // -------------------------------------------------------------------------
-  // Parameters
-  // -------------------------------------------------------------------------
-
-  uint32 _size;					// this is the size of in kB of the LLC
-  uint32 _blockSize;
-  uint32 _associativity;
-  string _policy;
-  string _dbipolicy;
-  uint32 _policyVal;
-  uint32 _dbiPolicyVal;
-
-  uint32 _tagStoreLatency;
-  uint32 _dataStoreLatency;
-
-  uint32 _dbiSize;
-
-  // -------------------------------------------------------------------------
-  // Private members
-  // -------------------------------------------------------------------------
-
-  struct TagEntry {
-    //bool dirty;
-    addr_t vcla;
-    addr_t pcla;
-    uint32 appID;
-    TagEntry() { //dirty = false; 
-    }
-  };
-
-  struct DBIEntry {
-    bitset <BLOCKS_PER_ROW> dirtyBits;
-    // pointer to a clean request for this current row ?   
-    DBIEntry() { 
-    dirtyBits.reset(); 
-    }
-  };
-
-
-  // tag store
-  uint32 _numSets;
-  generic_tagstore_t <addr_t, TagEntry> _tags;
-  generic_tagstore_t <addr_t, DBIEntry> _dbi;
-  policy_value_t _pval;
-  policy_value_t _dbipval;
-
-  // dbi
-  uint32 _numdbiEntries;
+  LLC_HOOK_MODULE_MEMBERS(Base)
+  LLC_DBI_MODULE_MEMBERS(Base)
 
-  // per processor hit/miss counters
-  vector <uint32> _hits;
-  vector <uint32> _misses;
+  // number of completed drains by row buffer hits. bucket 0 counts drains
+  // with no hits, bucket i drains with [2^(i-1), 2^i) hits
+  vector <uint64> _drainHits;
 
   // -------------------------------------------------------------------------
   // Structures for cleaning row (aggressive writeback operations)
@@ -117,447 +68,151 @@ protected:
   // Declare Counters
   // -------------------------------------------------------------------------
 
-  NEW_COUNTER(accesses);
-  NEW_COUNTER(reads);
-  NEW_COUNTER(writebacks);
-  NEW_COUNTER(misses);
-  NEW_COUNTER(evictions);
-  NEW_COUNTER(dirty_evictions);
-  NEW_COUNTER(dbievictions);
-
   NEW_COUNTER(agg_writebacks);
-  NEW_COUNTER(dbi_eviction_writebacks);
-  NEW_COUNTER(tagstore_eviction_writebacks);
-
   NEW_COUNTER(clean_requests);
-  
-  NEW_COUNTER(dbi_misses);
-  NEW_COUNTER(dbi_hits);
-// The last two are dicey
-
-public:
+  NEW_COUNTER(drains);
+  NEW_COUNTER(drain_writebacks);
+  NEW_COUNTER(drain_rowhits);
 
   // -------------------------------------------------------------------------
-  // Constructor. It cannot take any arguments
+  // Function to drain a row. Emits writebacks for all its dirty blocks as
+  // one group and removes its dbientry
   // -------------------------------------------------------------------------
 
-  CmpLLCwAWB() {
-    _size = 1024;
-    _blockSize = 64;
-    _associativity = 16;
-    _tagStoreLatency = 6;
-    _dataStoreLatency = 15;
-    _policy = "lru";
-    _dbipolicy = "lru";
-    _policyVal = 0;
-    _dbiPolicyVal = 0;
-    _dbiSize = 0;
-    cleanFlag = true;
-  }
+  void DRAIN_ROW(addr_t row, MemoryRequest *request) {
 
+    dirty_bitmap_t &dirtyBits = _dbi[row].dirtyBits;
+    WritebackDrain *drain = new WritebackDrain();
 
-  // -------------------------------------------------------------------------
-  // Virtual functions to be implemented by the components
-  // -------------------------------------------------------------------------
+    for (uint32 i = dirtyBits.first(); i < _blocksPerRow;
+         i = dirtyBits.next(i)) {
 
-  // -------------------------------------------------------------------------
-  // Function to add a parameter to the component
-  // -------------------------------------------------------------------------
+      addr_t wbtag = (row * _blocksPerRow) + i;
+      if (!_tags.lookup(wbtag))
+        continue;
 
-  void AddParameter(string pname, string pvalue) {
-      
-    CMP_PARAMETER_BEGIN
-
-      // Add the list of parameters to the component here
-      CMP_PARAMETER_UINT("size", _size)
-      CMP_PARAMETER_UINT("block-size", _blockSize)
-      CMP_PARAMETER_UINT("associativity", _associativity)
-      CMP_PARAMETER_STRING("policy", _policy)
-      CMP_PARAMETER_STRING("dbi-policy", _dbipolicy)
-      CMP_PARAMETER_UINT("policy-value", _policyVal)
-      CMP_PARAMETER_UINT("dbi-policy-value", _dbiPolicyVal)
-      CMP_PARAMETER_UINT("tag-store-latency", _tagStoreLatency)
-      CMP_PARAMETER_UINT("data-store-latency", _dataStoreLatency)
-      CMP_PARAMETER_UINT("dbi-size", _dbiSize)
-      
-    CMP_PARAMETER_END
-  }
-
-
-  // -------------------------------------------------------------------------
-  // Function to initialize statistics
-  // -------------------------------------------------------------------------
-
-  void InitializeStatistics() {
+      MemoryRequest *writeback =
+        NewRequest(MemoryRequest::WRITEBACK, request,
+                   _tags[wbtag].vcla, _tags[wbtag].pcla);
+      INCREMENT(agg_writebacks);
+      writeback -> drain = drain;
+      drain -> writebacks ++;
+      drain -> pending ++;
+      SendToNextComponent(writeback);
+    }
 
-    INITIALIZE_COUNTER(accesses, "Total Accesses");
-    INITIALIZE_COUNTER(reads, "Read Accesses");
-    INITIALIZE_COUNTER(writebacks, "Writeback Accesses");
-    INITIALIZE_COUNTER(misses, "Total Misses");
-    INITIALIZE_COUNTER(evictions, "Evictions");
-    INITIALIZE_COUNTER(dirty_evictions, "Dirty Evictions");
-    INITIALIZE_COUNTER(dbievictions, "DBI Evictions");
-    INITIALIZE_COUNTER(agg_writebacks, "Aggressive Writebacks");
-    INITIALIZE_COUNTER(dbi_eviction_writebacks, "DBI Eviction Writebacks");
-    INITIALIZE_COUNTER(tagstore_eviction_writebacks, "Tagstore Eviction Writebacks");
-    INITIALIZE_COUNTER(clean_requests, "Clean Requests");
-    INITIALIZE_COUNTER(dbi_misses, "DBI Accesses");
-    INITIALIZE_COUNTER(dbi_hits, "DBI Hits");
+    _dbi.invalidate(row);
 
+    if (drain -> pending == 0)
+      delete drain;
   }
 
 
   // -------------------------------------------------------------------------
-  // Function called when simulation starts
+  // Function called when a writeback of a drain returns. Accounts the drain
+  // once all its writebacks are back
   // -------------------------------------------------------------------------
 
-  void StartSimulation() {
+  void DRAIN_RETURN(WritebackDrain *drain) {
 
-    _numSets = (_size * 1024) / (_blockSize * _associativity);
-   
-     _numdbiEntries = _dbiSize;	
+    if (-- drain -> pending > 0)
+      return;
 
-    _tags.SetTagStoreParameters(_numSets, _associativity, _policy);
-    _dbi.SetTagStoreParameters(1, _numdbiEntries, _dbipolicy);  
+    INCREMENT(drains);
+    ADD_TO_COUNTER(drain_writebacks, drain -> writebacks);
+    ADD_TO_COUNTER(drain_rowhits, drain -> rowHits);
 
-    switch (_policyVal) {
-    case 0: _pval = POLICY_HIGH; break;
-    case 1: _pval = POLICY_BIMODAL; break;
-    case 2: _pval = POLICY_LOW; break;
-    }
+    uint32 bucket = 0;
+    while (bucket + 1 < _drainHits.size() && (1U << bucket) <= drain -> rowHits)
+      bucket ++;
+    _drainHits[bucket] ++;
 
-    switch (_dbiPolicyVal) {
-    case 0: _dbipval = POLICY_HIGH; break;
-    case 1: _dbipval = POLICY_BIMODAL; break;
-    case 2: _dbipval = POLICY_LOW; break;
-    }
-                           
-    _hits.resize(_numCPUs, 0);
-    _misses.resize(_numCPUs, 0);
+    delete drain;
   }
 
+public:
 
-  // -------------------------------------------------------------------------
-  // Function called at a heart beat. Argument indicates cycles elapsed after
-  // previous heartbeat
-  // -------------------------------------------------------------------------
-
-  void HeartBeat(cycles_t hbCount) {
+  LLCAggressiveWriteback() {
+    cleanFlag = true;
   }
 
+  void InitializeHookStatistics() {
 
-protected:
-
-  // -------------------------------------------------------------------------
-  // Function to process a request. Return value indicates number of busy
-  // cycles for the component.
-  // -------------------------------------------------------------------------
-
-
-  cycles_t ProcessRequest(MemoryRequest *request) {
+    Base::InitializeHookStatistics();
 
-    // update stats
-    INCREMENT(accesses);
-
-    table_t <addr_t, TagEntry>::entry tagentry;
-    table_t <addr_t, DBIEntry>::entry dbientry;
-    cycles_t latency;
-
-    // NO WRITES (Complete or partial)
-    if (request -> type == MemoryRequest::WRITE || 
-        request -> type == MemoryRequest::PARTIALWRITE) {
-      fprintf(stderr, "LLC cannot handle direct writes (yet)\n");
-      exit(0);
-    }
-
-    // compute the cache block tag
-    addr_t ctag = VADDR(request) / _blockSize;
-
-    // compute the cache block logical row, this is used to key into dbi, like ctag is used for tagstores
-    addr_t logicalRow = ctag / BLOCKS_PER_ROW;	
-
-    // check if its a read or write back
-    switch (request -> type) {
-
-      // READ request
-    case MemoryRequest::READ:
-    case MemoryRequest::READ_FOR_WRITE:
-    case MemoryRequest::PREFETCH:
-
-      INCREMENT(reads);
-          
-      tagentry = _tags.read(ctag);
-
-      if (tagentry.valid) {
-        request -> serviced = true;
-        request -> AddLatency(_tagStoreLatency + _dataStoreLatency);
-
-        // update per processor counters
-        _hits[request -> cpuID] ++;
-      }
-      else {
-        INCREMENT(misses);
-        request -> AddLatency(_tagStoreLatency);
-
-        _misses[request -> cpuID] ++;
-      }
-          
-      return _tagStoreLatency;
-
-
-      // WRITEBACK request
-    case MemoryRequest::WRITEBACK:
-
-      INCREMENT(writebacks);
-
-      if (_tags.lookup(ctag)){
-        //_tags[ctag].dirty = true;        
-
-        if(_dbi.lookup(logicalRow)){	
-	_dbi[logicalRow].dirtyBits.set(ctag % BLOCKS_PER_ROW);	
-	// Not all clean blocks are guaranteed to have their dirty bit info in the DBI
-        INCREMENT(dbi_hits);
-	// dummy read to update with replacement policy
-        _dbi.read(logicalRow);
-        }
-
-	else{
-	table_t <addr_t, DBIEntry>::entry dbientry;    
-	
-	HANDLE_DBI_INSERTION(ctag, request, dbientry, true);
-// this will handle dbi insertion when dbi entry is not present  
-	 }   
-        }
-
-      else
-        INSERT_BLOCK(ctag, true, request);
-
-      request -> serviced = true; 
-      return _tagStoreLatency;	
-
-     case MemoryRequest::CLEAN:
-
-     // check if the row hasn't been cleaned yet and the that the corresponding dbientry still exists
-        if((!cleanFlag)&&_dbi.lookup(cleanRow)){
-
-           // We don't count DBI hits because for these accesses, misses don't hurt us           
-           if(!_dbi[cleanRow].dirtyBits.any()){		// row has been cleaned, no cleaning operation left
-             cleanFlag = true;
-             request -> serviced = true;
-             }
-
-           else{
-           int i=0;
-           while(!_dbi[cleanRow].dirtyBits[i])	i++;
-           
-           addr_t wbtag = (cleanRow * BLOCKS_PER_ROW) + i;
-           TagEntry wbentry = _tags[wbtag];
-
-           MemoryRequest *writeback =
-           new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                            MemoryRequest::WRITEBACK, request -> cmpID, 
-                            wbentry.vcla, wbentry.pcla, _blockSize,
-                            request -> currentCycle);
-	   INCREMENT(agg_writebacks);
-           writeback -> icount = request -> icount;
-           writeback -> ip = request -> ip;
-           SendToNextComponent(writeback);
-           _dbi[cleanRow].dirtyBits.reset(i);
-           }
-
-        }
-
-     //  if row is not clean and its dbientry doesn't exist, it means that row has been evicted and its dirty blocks cleaned
-        else if((!cleanFlag)&&(!_dbi.lookup(cleanRow))){
-	  // We don't count a DBI miss for this part because a dbi miss doesn't harm us
-          cleanFlag = true;
-          request -> serviced = true;
-        }
-      
-       return _tagStoreLatency;			// Don't know what latency to return
-      
-    }
+    INITIALIZE_COUNTER(agg_writebacks, "Aggressive Writebacks");
+    INITIALIZE_COUNTER(clean_requests, "Clean Requests");
+    INITIALIZE_COUNTER(drains, "Completed Row Drains");
+    INITIALIZE_COUNTER(drain_writebacks, "Row Drain Writebacks");
+    INITIALIZE_COUNTER(drain_rowhits, "Row Drain Row Buffer Hits");
+    INITIALIZE_HISTOGRAM(_drainHits, "drain-rowhits", "Row drains by row buffer hits");
   }
 
+  void StartHooks() {
 
-  // -------------------------------------------------------------------------
-  // Function to process the return of a request. Return value indicates
-  // number of busy cycles for the component.
-  // -------------------------------------------------------------------------
-    
-  cycles_t ProcessReturn(MemoryRequest *request) { 
-
-    // if its a writeback or clean from this component, delete it
-    if (request -> iniType == MemoryRequest::COMPONENT &&
-        request -> iniPtr == this) {
-      request -> destroy = true;
-      return 0;
-    }
-
-    // get the cache block tag
-    addr_t ctag = VADDR(request) / _blockSize;
-
-    // if the block is already present, return
-    if (_tags.lookup(ctag))
-      return 0;
-
-    INSERT_BLOCK(ctag, false, request);
+    Base::StartHooks();
 
-    return 0;
+    uint32 buckets = 1;
+    while ((1U << (buckets - 1)) <= _blocksPerRow) buckets ++;
+    _drainHits.resize(buckets, 0);
   }
 
+  void EndWarmUp() {
+    Base::EndWarmUp();
+    fill(_drainHits.begin(), _drainHits.end(), 0);
+  }
 
-  // -------------------------------------------------------------------------
-  // Function to insert a block into the cache
-  // Should check for DBI evictions also
-  // -------------------------------------------------------------------------
-
-  void INSERT_BLOCK(addr_t ctag, bool dirty, MemoryRequest *request) {
+  // generate a CLEAN request if no clean requests for previous rows are
+  // pending and the row of the evicted block still has dirty blocks
+  bool IsDirty(MemoryRequest *request, TagTableEntry &victim) {
 
-    table_t <addr_t, TagEntry>::entry tagentry;
-    table_t <addr_t, DBIEntry>::entry dbientry;
-    
-    bool DBIevictedEntry;			// indicates if dbientry is evicted or was already present, true if evicted
+    if (!Base::IsDirty(request, victim))
+      return false;
 
-    addr_t logicalRow = ctag / BLOCKS_PER_ROW;	
+    if (cleanFlag && _dbi.lookup(victim.key / _blocksPerRow)) {
+      cleanFlag = false;
+      cleanRow = victim.key / _blocksPerRow;
+      INCREMENT(clean_requests);
+      AddRequest(NewRequest(MemoryRequest::CLEAN, request,
+                            victim.value.vcla, victim.value.pcla));
+    }
+    return true;
+  }
 
-    DBIevictedEntry = !(_dbi.lookup(logicalRow));
+  // drain the row in one pass if its dbientry still exists. If it doesn't,
+  // the row has been evicted and its dirty blocks cleaned already. DBI
+  // hits and misses are not counted, as misses do not hurt here
+  cycles_t OtherRequest(MemoryRequest *request, addr_t ctag,
+                        cycles_t busyCycles) {
 
-/*
-The following FSM has been implemented :
-1. First insert into _dbi.
-2. If returned dbientry was valid and evicted, generate writebacks for all the entries corresponding to dirty bits in the 
-   evicted dbientry. (nothing to be done when dbientry is valid and already present) Also, delete the tagstore entries 
-   corresponding to these dirty bits. 
-3. Now insert into _tags.
-4. If returned tagentry is valid and dirty (evicted or already present), then generate writeback. 
-*/
+    if (request -> type != MemoryRequest::CLEAN)
+      return Base::OtherRequest(request, ctag, busyCycles);
 
-// if returned entry is due to free list in table, then bool valid will be false
-
-// How to differentiate between evicted and already present, use evictedEntry and lookup
-
-if(dirty)	HANDLE_DBI_INSERTION(ctag, request, dbientry, DBIevictedEntry);
-    
-// 3. and 4.
-
-tagentry = _tags.insert(ctag, TagEntry(), _pval);
-// this has to be an eviction always
-
-    _tags[ctag].vcla = BLOCK_ADDRESS(VADDR(request), _blockSize);
-    _tags[ctag].pcla = BLOCK_ADDRESS(PADDR(request), _blockSize);
-    _tags[ctag].appID = request -> cpuID;
-    //_dbi.read(logicalRow).value.dirtyBits[ctag % BLOCKS_PER_ROW] = dirty;
-       
-    if (tagentry.valid) {
-
-    // this will let in entries that were evicted or already present
-
-      INCREMENT(evictions);		
-
-bool specialCase = false;
-     if(dirty)	specialCase = (((dbientry.key == (tagentry.key) / BLOCKS_PER_ROW)&&(dbientry.value.dirtyBits[(tagentry.key) % BLOCKS_PER_ROW])))?true:false;
-
-
-// specialCase is that when the evicted dbientry contains the dirty bit info for the evicted tagstore entry(which happens to be 
-// dirty) as well
-
-    if (((_dbi.lookup((tagentry.key) / BLOCKS_PER_ROW))&&(_dbi[(tagentry.key) / BLOCKS_PER_ROW].dirtyBits[(tagentry.key) % BLOCKS_PER_ROW])) || specialCase){
-// this checks if evicted tagentry has entry in dbi			
-// dbientry is generated only in case of dirty = true 
-// check if evicted tagentry still has its dirty info in dbi OR
-// in the evicted dbientry
-// and then, if corresponding dirty bits are set
- 
-        INCREMENT(dirty_evictions);
-
-        // We should check if the dbientry is still present in the DBI, only then clean the corresponding bit
-	if(_dbi.lookup((tagentry.key) / BLOCKS_PER_ROW))	
-        //_dbi.read(logicalRow).value.dirtyBits.reset(ctag % BLOCKS_PER_ROW);	// no need for replacement policy here also 
-	_dbi[(tagentry.key) / BLOCKS_PER_ROW].dirtyBits.reset((tagentry.key) % BLOCKS_PER_ROW);
-        // This is a cleaning operation, clean entry in DBI if present
-
-        // ********   also invalidate row if it was the last set bit
-        if(!(_dbi[(tagentry.key) / BLOCKS_PER_ROW].dirtyBits.any()))	_dbi.invalidate((tagentry.key) / BLOCKS_PER_ROW);
-
-        MemoryRequest *writeback =
-          new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                            MemoryRequest::WRITEBACK, request -> cmpID, 
-                            tagentry.value.vcla, tagentry.value.pcla, _blockSize,
-                            request -> currentCycle);
-        // Generating writebacks when entry was already present and dirty, is it necessary (for memory consistency perhaps?)
-        INCREMENT(tagstore_eviction_writebacks);
-        writeback -> icount = request -> icount;
-        writeback -> ip = request -> ip;
-        SendToNextComponent(writeback);
-        // Generate CLEAN request if no clean requests for previous rows pending
-        if(cleanFlag && (_dbi.lookup((tagentry.key) / BLOCKS_PER_ROW))){
-        // we would not want to generate clean request when we have inserted new dbientry, as it will be a clean row
-        MemoryRequest *clean =
-          new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                            MemoryRequest::CLEAN, request -> cmpID, 
-                            tagentry.value.vcla, tagentry.value.pcla, _blockSize,
-                            request -> currentCycle);
-        clean -> icount = request -> icount;
-        clean -> ip = request -> ip;
-        cleanFlag = false;
-        cleanRow = (tagentry.key) / BLOCKS_PER_ROW;
-        INCREMENT(clean_requests);
-        AddRequest(clean);
-        }
-       
-     }
+    if (!cleanFlag && _dbi.lookup(cleanRow))
+      DRAIN_ROW(cleanRow, request);
 
-    }
+    cleanFlag = true;
+    request -> serviced = true;
+    return busyCycles;
   }
 
-void HANDLE_DBI_INSERTION(addr_t ctag, MemoryRequest *request, table_t <addr_t, DBIEntry>::entry &dbientry, bool DBIevictedEntry){
- 
-    addr_t logicalRow = ctag / BLOCKS_PER_ROW;	
-
-// 1.
-    dbientry = _dbi.insert(logicalRow, DBIEntry(), _dbipval);
-    _dbi[logicalRow].dirtyBits.set(ctag % BLOCKS_PER_ROW);
-
-    INCREMENT(dbi_misses);
-  
-// 2. 
-    if(DBIevictedEntry && dbientry.valid){
-    INCREMENT(dbievictions);
-        
-    // generate writebacks for all dirty blocks in the row
-      for(uint64 i=0;i<BLOCKS_PER_ROW;i++){
-           
-          if(dbientry.value.dirtyBits[i]){ 
-          addr_t discardtag = (dbientry.key * BLOCKS_PER_ROW) + i;
-	          
-	  // now check if the corresponding block is present in the tagstore
-	  // if not, no need to generate writebacks
-	  if(_tags.lookup(discardtag)){
-          
-	  // we have to generate writebacks and remove tagstore entries too
-	  // if we do not remove the tagstore entries, we may have cases where tagentry is there but dbientry is not
-          
-	  table_t <addr_t, TagEntry>::entry discardentry;
-	  discardentry = _tags.invalidate(discardtag);
-          
-          MemoryRequest *writeback =
-          new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                            MemoryRequest::WRITEBACK, request -> cmpID, 
-                            discardentry.value.vcla, discardentry.value.pcla, _blockSize,
-                            request -> currentCycle);
-          
-          INCREMENT(dbi_eviction_writebacks);
-          writeback -> icount = request -> icount;
-          writeback -> ip = request -> ip;
-          SendToNextComponent(writeback);
-          }
-        }
-      }
-    }
+  void OnOwnReturn(MemoryRequest *request) {
+    Base::OnOwnReturn(request);
+    if (request -> drain)
+      DRAIN_RETURN(request -> drain);
   }
+};
+
 
+// -----------------------------------------------------------------------------
+// Class: CmpLLCwAWB
+// Description:
+//    Baseline lastlevel cache with DBI and implementing aggressive writeback.
+// -----------------------------------------------------------------------------
 
+class CmpLLCwAWB :
+  public LLCAggressiveWriteback <LLCDirtyBlockIndex <
+    CmpLLCEngine <CmpLLCwAWB> > > {
 };
 
-#endif // __CMP_LLC_DBI_H__
+#endif // __CMP_LLC_AWB_H__
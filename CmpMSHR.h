@@ -1,6 +1,10 @@
 // -----------------------------------------------------------------------------
 // File: CmpMSHR.h
 // Description:
+//    Miss status holding registers. Outstanding misses are kept in an open
+//    addressed table sized by the number of MSHRs. Requests waiting on a miss
+//    (and requests waiting for a free MSHR) are chained through the requests
+//    themselves, so a miss does not allocate anything except the miss request.
 // -----------------------------------------------------------------------------
 
 #ifndef __CMP_MSHR_H__
@@ -17,14 +21,17 @@
 // Standard includes
 // -----------------------------------------------------------------------------
 
-#include <map>
-#include <list>
+#include <vector>
 
 #define MSHR_STALL_PENALTY 10
 
+// number of occupancy histogram buckets for an unbounded MSHR
+#define MSHR_HISTOGRAM_SIZE 64
+
 // -----------------------------------------------------------------------------
 // Class: CmpMSHR
 // Description:
+//    MSHR with miss merging. A count of 0 indicates unlimited MSHRs.
 // -----------------------------------------------------------------------------
 
 class CmpMSHR : public MemoryComponent {
@@ -42,10 +49,47 @@ class CmpMSHR : public MemoryComponent {
     // Private members
     // -------------------------------------------------------------------------
 
-    map <addr_t, list <MemoryRequest *> > _missed;
-    list <MemoryRequest *> _waitQ;
-    map <addr_t, MemoryRequest *> _outstanding;
-    map <MemoryRequest *, MemoryRequest *> _handler;
+    // an outstanding miss
+    struct MSHREntry {
+      bool valid;
+      addr_t blockAddr;
+      // request sent to the next level
+      MemoryRequest *miss;
+      // requests waiting for the miss
+      MemoryRequest *head;
+      MemoryRequest *tail;
+    };
+
+    // open addressed (linear probing) table of misses
+    vector <MSHREntry> _table;
+    uint32 _mask;
+    uint32 _occupancy;
+
+    // requests waiting for a free MSHR
+    MemoryRequest *_waitHead;
+    MemoryRequest *_waitTail;
+
+    // occupancy tracking
+    cycles_t _lastUpdate;
+    vector <uint64> _occupancyHistogram;
+    vector <uint32> _procOccupancy;
+    vector <cycles_t> _procLastUpdate;
+    vector <uint64> _procOccupancyCycles;
+    vector <uint64> _procBusyCycles;
+    vector <uint64> _procMisses;
+
+    // -------------------------------------------------------------------------
+    // Declare counters
+    // -------------------------------------------------------------------------
+
+    NEW_COUNTER(accesses);
+    NEW_COUNTER(misses);
+    NEW_COUNTER(merged_misses);
+    NEW_COUNTER(merged_writes);
+    NEW_COUNTER(full_stalls);
+    NEW_COUNTER(full_stall_cycles);
+    NEW_COUNTER(occupancy_cycles);
+    NEW_COUNTER(busy_cycles);
 
 
   public:
@@ -69,6 +113,19 @@ class CmpMSHR : public MemoryComponent {
     // -------------------------------------------------------------------------
 
     void InitializeStatistics() {
+      INITIALIZE_COUNTER(accesses, "Total Accesses")
+      INITIALIZE_COUNTER(misses, "MSHRs allocated")
+      INITIALIZE_COUNTER(merged_misses, "Misses merged with an outstanding miss")
+      INITIALIZE_COUNTER(merged_writes, "Writes to an outstanding miss")
+      INITIALIZE_COUNTER(full_stalls, "Requests stalled on full MSHRs")
+      INITIALIZE_COUNTER(full_stall_cycles, "Cycles stalled on full MSHRs")
+      INITIALIZE_COUNTER(occupancy_cycles, "Sum of occupancy over cycles")
+      INITIALIZE_COUNTER(busy_cycles, "Cycles with an outstanding miss")
+      INITIALIZE_HISTOGRAM(_occupancyHistogram, "occupancy",
+          "Cycles spent at each occupancy")
+      INITIALIZE_VECTOR_COUNTER(_procMisses, "misses", "Misses of each cpu")
+      INITIALIZE_VECTOR_COUNTER(_procBusyCycles, "busy_cycles",
+          "Cycles with an outstanding miss of each cpu")
     }
 
 
@@ -77,7 +134,7 @@ class CmpMSHR : public MemoryComponent {
     // -------------------------------------------------------------------------
 
     void AddParameter(string pname, string pvalue) {
-      
+
       CMP_PARAMETER_BEGIN
 
       // Add the list of parameters to the component here
@@ -92,10 +149,22 @@ class CmpMSHR : public MemoryComponent {
     // -------------------------------------------------------------------------
 
     void StartSimulation() {
-      // nothing much to do
-      _missed.clear();
-      _outstanding.clear();
-      _handler.clear();
+      // size the table to at most half full
+      uint32 size = 64;
+      while (size < 2 * _count) size <<= 1;
+      ResizeTable(size);
+
+      _waitHead = NULL;
+      _waitTail = NULL;
+
+      _lastUpdate = 0;
+      _occupancyHistogram.resize((_count != 0 ? _count :
+            MSHR_HISTOGRAM_SIZE) + 1, 0);
+      _procOccupancy.resize(_numCPUs, 0);
+      _procLastUpdate.resize(_numCPUs, 0);
+      _procOccupancyCycles.resize(_numCPUs, 0);
+      _procBusyCycles.resize(_numCPUs, 0);
+      _procMisses.resize(_numCPUs, 0);
     }
 
 
@@ -108,8 +177,165 @@ class CmpMSHR : public MemoryComponent {
     }
 
 
+    // -------------------------------------------------------------------------
+    // Prefetch filter queries
+    // -------------------------------------------------------------------------
+
+    bool IsMSHR() {
+      return true;
+    }
+
+    bool HasOutstandingMiss(addr_t paddr) {
+      return _table[Find((paddr / _blockSize) * _blockSize)].valid;
+    }
+
+    uint32 OutstandingMisses() {
+      return _occupancy;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function called when warmup ends
+    // -------------------------------------------------------------------------
+
+    void EndWarmUp() {
+      MemoryComponent::EndWarmUp();
+      fill(_occupancyHistogram.begin(), _occupancyHistogram.end(), 0);
+    }
+
+    void EndProcWarmUp(uint32 cpuID) {
+      _procOccupancyCycles[cpuID] = 0;
+      _procBusyCycles[cpuID] = 0;
+      _procMisses[cpuID] = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function called when simulation ends
+    // -------------------------------------------------------------------------
+
+    void EndSimulation() {
+      DUMP_STATISTICS;
+
+      // memory level parallelism of each cpu: average number of outstanding
+      // misses when there is at least one
+      for (uint32 i = 0; i < _numCPUs; i ++)
+        CMP_LOG("mlp-%u = %.3lf", i, _procBusyCycles[i] == 0 ? 0.0 :
+            (double)_procOccupancyCycles[i] / _procBusyCycles[i]);
+
+      CLOSE_ALL_LOGS;
+    }
+
+
   protected:
 
+    // -------------------------------------------------------------------------
+    // Function to compute the home slot of a block
+    // -------------------------------------------------------------------------
+
+    uint32 Slot(addr_t blockAddr) {
+      uint64 key = (blockAddr / _blockSize) * 0x9E3779B97F4A7C15ULL;
+      return (uint32)(key >> 32) & _mask;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to find the slot of a block. Returns an invalid slot if the
+    // block has no outstanding miss.
+    // -------------------------------------------------------------------------
+
+    uint32 Find(addr_t blockAddr) {
+      uint32 slot = Slot(blockAddr);
+      while (_table[slot].valid && _table[slot].blockAddr != blockAddr)
+        slot = (slot + 1) & _mask;
+      return slot;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to remove an entry. Later entries of the probe sequence are
+    // moved back so that lookups do not need tombstones.
+    // -------------------------------------------------------------------------
+
+    void Erase(uint32 slot) {
+      _table[slot].valid = false;
+      uint32 next = (slot + 1) & _mask;
+      while (_table[next].valid) {
+        uint32 home = Slot(_table[next].blockAddr);
+        // move the entry if its home is not in (slot, next]
+        if (((next - home) & _mask) >= ((next - slot) & _mask)) {
+          _table[slot] = _table[next];
+          _table[next].valid = false;
+          slot = next;
+        }
+        next = (next + 1) & _mask;
+      }
+      _occupancy --;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to resize the table. Only an unlimited MSHR grows.
+    // -------------------------------------------------------------------------
+
+    void ResizeTable(uint32 size) {
+      vector <MSHREntry> old;
+      old.swap(_table);
+      MSHREntry empty;
+      empty.valid = false;
+      _table.resize(size, empty);
+      _mask = size - 1;
+      _occupancy = 0;
+      for (uint32 i = 0; i < old.size(); i ++) {
+        if (old[i].valid) {
+          _table[Find(old[i].blockAddr)] = old[i];
+          _occupancy ++;
+        }
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to append a request to a wait list
+    // -------------------------------------------------------------------------
+
+    void Enqueue(MemoryRequest *&head, MemoryRequest *&tail,
+        MemoryRequest *request) {
+      request -> waitNext = NULL;
+      if (tail == NULL) head = request;
+      else tail -> waitNext = request;
+      tail = request;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to account for the occupancy till the given cycle and then
+    // change the occupancy of a cpu by delta
+    // -------------------------------------------------------------------------
+
+    void UpdateOccupancy(uint32 cpuID, cycles_t now, int32 delta) {
+      if (now > _lastUpdate) {
+        cycles_t elapsed = now - _lastUpdate;
+        uint32 bucket = min(_occupancy,
+            (uint32)_occupancyHistogram.size() - 1);
+        _occupancyHistogram[bucket] += elapsed;
+        ADD_TO_COUNTER(occupancy_cycles, _occupancy * elapsed);
+        if (_occupancy > 0) ADD_TO_COUNTER(busy_cycles, elapsed);
+        _lastUpdate = now;
+      }
+
+      if (now > _procLastUpdate[cpuID]) {
+        if (!_done.test(cpuID) && _procOccupancy[cpuID] > 0) {
+          cycles_t elapsed = now - _procLastUpdate[cpuID];
+          _procOccupancyCycles[cpuID] += _procOccupancy[cpuID] * elapsed;
+          _procBusyCycles[cpuID] += elapsed;
+        }
+        _procLastUpdate[cpuID] = now;
+      }
+      _procOccupancy[cpuID] += delta;
+    }
+
+
     // -------------------------------------------------------------------------
     // Function to process a request. Return value indicates number of busy
     // cycles for the component.
@@ -121,60 +347,84 @@ class CmpMSHR : public MemoryComponent {
       if (request -> type == MemoryRequest::WRITEBACK)
         return 0;
 
+      // a request released from the wait for a free MSHR is counted only
+      // when it first arrives
+      bool retry = request -> mshrRetry;
+      request -> mshrRetry = false;
+      if (!retry) INCREMENT(accesses);
+
       // get the block address of the request
       addr_t blockAddr = ((request -> physicalAddress)/_blockSize)*_blockSize;
-
+      uint32 slot = Find(blockAddr);
 
       // if there is already a miss for the block, then insert it at the end of
       // that block's request list
-      if (_missed.find(blockAddr) != _missed.end()) {
+      if (_table[slot].valid) {
         // write requests don't stall the processor
         if (request -> type == MemoryRequest::WRITE) {
+          INCREMENT(merged_writes);
           request -> serviced = true;
           return 0;
         }
 
         if (request -> type == MemoryRequest::READ)
-          _outstanding[blockAddr] -> type = MemoryRequest::READ;
+          _table[slot].miss -> type = MemoryRequest::READ;
 
+        INCREMENT(merged_misses);
         request -> stalling = true;
-        _missed[blockAddr].push_back(request);
+        Enqueue(_table[slot].head, _table[slot].tail, request);
         return 0;
       }
 
       // if there are no free MSHRs, stall the request
       if (_count != 0) {
-        if (_missed.size() == _count) {
+        if (_occupancy == _count) {
+          if (!retry) INCREMENT(full_stalls);
           request -> stalling = true;
-          _waitQ.push_back(request);
+          Enqueue(_waitHead, _waitTail, request);
           return 0;
         }
       }
 
-      // assign a new MSHR to the request      
-      _missed[blockAddr] = list <MemoryRequest *> ();
+      // an unlimited MSHR grows to keep the table at most half full
+      else if (2 * (_occupancy + 1) > _table.size()) {
+        ResizeTable(2 * _table.size());
+        slot = Find(blockAddr);
+      }
+
+      // assign a new MSHR to the request
+      INCREMENT(misses);
+      if (!_done.test(request -> cpuID)) _procMisses[request -> cpuID] ++;
+      UpdateOccupancy(request -> cpuID, request -> currentCycle, 1);
 
       MemoryRequest *miss = new MemoryRequest(MemoryRequest::COMPONENT,
           request -> cpuID, this, MemoryRequest::READ, request -> cmpID,
-          request -> virtualAddress, blockAddr, _blockSize, 
+          request -> virtualAddress, blockAddr, _blockSize,
           request -> currentCycle);
 
       miss -> type = request -> type;
       if (request -> type == MemoryRequest::WRITE)
         miss -> type = MemoryRequest::READ_FOR_WRITE;
-      
-      // set icount
+
+      // set icount, ip and trace id
       miss -> icount = request -> icount;
-      
-      _outstanding[blockAddr] = miss;
+      miss -> ip = request -> ip;
+      miss -> traceID = request -> traceID;
 
+      MSHREntry &entry = _table[slot];
+      entry.valid = true;
+      entry.blockAddr = blockAddr;
+      entry.miss = miss;
+      entry.head = NULL;
+      entry.tail = NULL;
+      _occupancy ++;
 
       if (request -> type == MemoryRequest::WRITE) {
         request -> serviced = true;
       }
       else {
         request -> stalling = true;
-        _missed[blockAddr].push_back(request);
+        Enqueue(entry.head, entry.tail, request);
       }
 
       SendToNextComponent(miss);
@@ -186,7 +436,7 @@ class CmpMSHR : public MemoryComponent {
     // Function to process the return of a request. Return value indicates
     // number of busy cycles for the component.
     // -------------------------------------------------------------------------
-    
+
     cycles_t ProcessReturn(MemoryRequest *request) {
 
       // if the request is not generated by this component,
@@ -197,33 +447,49 @@ class CmpMSHR : public MemoryComponent {
 
       // else mark all the requests waiting for this miss as serviced
       addr_t blockAddr = request -> physicalAddress;
-
-      assert(_missed.find(blockAddr) != _missed.end());
-      list <MemoryRequest *>::iterator it;
-      for (it = _missed[blockAddr].begin(); it != _missed[blockAddr].end();
-          it ++) {
-        (*it) -> stalling = false;
-        (*it) -> serviced = true;
-        (*it) -> currentCycle = request -> currentCycle;
-        if (request -> dirtyReply) 
-          (*it) -> dirtyReply = true;
-        AddRequest((*it));
+      uint32 slot = Find(blockAddr);
+      assert(_table[slot].valid);
+
+      MemoryRequest *waiter = _table[slot].head;
+
+      // account for the occupancy till now and remove the entry for the miss
+      UpdateOccupancy(request -> cpuID, request -> currentCycle, -1);
+      Erase(slot);
+
+      while (waiter != NULL) {
+        MemoryRequest *next = waiter -> waitNext;
+        waiter -> waitNext = NULL;
+        waiter -> stalling = false;
+        waiter -> serviced = true;
+        waiter -> currentCycle = request -> currentCycle;
+        waiter -> serviceLevel = request -> serviceLevel;
+        waiter -> mshrStallCycles += request -> mshrStallCycles;
+        if (request -> dirtyReply)
+          waiter -> dirtyReply = true;
+        AddRequest(waiter);
+        waiter = next;
       }
 
-      // remove the entry for the miss
-      _missed.erase(blockAddr);
-      _outstanding.erase(blockAddr);
-      if (!_waitQ.empty()) {
-        MemoryRequest *front = _waitQ.front();
-        _waitQ.pop_front();
+      if (_waitHead != NULL) {
+        MemoryRequest *front = _waitHead;
+        _waitHead = front -> waitNext;
+        if (_waitHead == NULL) _waitTail = NULL;
+        front -> waitNext = NULL;
         front -> stalling = false;
+        front -> mshrRetry = true;
+        if (request -> currentCycle > front -> currentCycle) {
+          ADD_TO_COUNTER(full_stall_cycles,
+              request -> currentCycle - front -> currentCycle);
+          front -> mshrStallCycles +=
+            request -> currentCycle - front -> currentCycle;
+        }
         AddRequest(front);
       }
 
       // destroy the request
       request -> destroy = true;
-     
-      return 0; 
+
+      return 0;
     }
 
 
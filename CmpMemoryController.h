@@ -1,8 +1,8 @@
 // -----------------------------------------------------------------------------
 // File: CmpMemoryController.h
 // Description:
-//    Defines a memory controller which controls DRAM memory. For now, it
-//    contains a simple model.
+//    Defines a memory controller which controls DRAM memory. It contains a
+//    simple latency based model of one or more channels.
 // -----------------------------------------------------------------------------
 
 #ifndef __CMP_MEMORY_CONTROLLER_H__
@@ -13,18 +13,25 @@
 // -----------------------------------------------------------------------------
 
 #include "MemoryComponent.h"
+#include "MemoryRequestQueue.h"
+#include "DRAMAddressMapping.h"
 #include "Types.h"
 
 // -----------------------------------------------------------------------------
 // Standard includes
 // -----------------------------------------------------------------------------
 
+#include <vector>
+
 
 // -----------------------------------------------------------------------------
 // Class: CmpMemoryController
 // Description:
-//    Simple DRAM memory controller model. For now, single channel, single rank.
-//    Implements FCFS with drain-when-full.
+//    Simple DRAM memory controller model with multiple channels and ranks.
+//    Each channel has its own bus, request queues and scheduler state.
+//    Implements FCFS, FR-FCFS and their drain-when-full variants
+//    (scheduling-algo: fcfs, fcfs-drain, frfcfs, frfcfs-drain). See
+//    DRAMAddressMapping.h for the address-mapping schemes.
 // -----------------------------------------------------------------------------
 
 class CmpMemoryController : public MemoryComponent {
@@ -35,15 +42,22 @@ protected:
   // Parameters
   // -------------------------------------------------------------------------
 
+  uint32 _numChannels;
+  uint32 _numRanks;
   uint32 _numBanks;
   uint32 _rowSize;
+  uint32 _lineSize;
+  string _addressMapping;
+  bool _usePhysicalAddress;
 
   string _schedAlgo;
+  bool _dbiAwareWrites;
 
   uint32 _rowHitLatency;
   uint32 _rowConflictLatency;
   uint32 _readToWriteLatency;
   uint32 _writeToReadLatency;
+  uint32 _rankToRankLatency;
 
   uint32 _numWriteBufferEntries;
   uint32 _channelDelay;
@@ -55,23 +69,32 @@ protected:
   // Private members
   // -------------------------------------------------------------------------
 
-  // memory request queue
-  list <MemoryRequest *> _readQ;
-  list <MemoryRequest *> _writeQ;
-
-  // last operation type
-  MemoryRequest::Type _lastOp;
-
-  // open row in each bank
-  vector <addr_t> _openRow;
+  // state of a channel
+  struct Channel {
+    // per-bank read and write queues. also tracks the open row of each
+    // bank. banks of rank r are at r * _numBanks onwards
+    MemoryRequestQueue requests;
+    // for scheduling algorithms
+    bool drain;
+    // was the last operation a write
+    bool lastWrite;
+    // rank of the last operation
+    uint32 lastRank;
+    // cycle at which the channel can schedule the next request
+    cycles_t currentCycle;
+  };
+
+  vector <Channel> _channels;
+
+  // per channel statistics
+  vector <uint64> _channelAccesses;
+  vector <uint64> _channelBusyCycles;
+
+  DRAMAddressMapping _mapping;
 
   // scheduling algorithm
-  MemoryRequest * (CmpMemoryController::*NextRequest)();
-
-  // for scheduling algorithms
-  bool _drain;
-  list <MemoryRequest *> _writeRowHits;
-  list <MemoryRequest *> _readRowHits;
+  MemoryRequest * (CmpMemoryController::*NextRequest)(MemoryRequestQueue &,
+      bool &);
 
 
   // -------------------------------------------------------------------------
@@ -85,6 +108,10 @@ protected:
   NEW_COUNTER(rowconflicts);
   NEW_COUNTER(readtowrites);
   NEW_COUNTER(writetoreads);
+  NEW_COUNTER(ranktoranks);
+  NEW_COUNTER(write_rowhits);
+  NEW_COUNTER(dbi_queries);
+  NEW_COUNTER(dbi_pulled_writebacks);
 
 public:
 
@@ -94,16 +121,23 @@ public:
 
   CmpMemoryController() {
 
+    _numChannels = 1;
+    _numRanks = 1;
     _numBanks = 8;
     _rowSize = 8192;
+    _lineSize = 64;
+    _addressMapping = "row-rank-bank-channel-column";
+    _usePhysicalAddress = false;
     _rowHitLatency = 14;
     _rowConflictLatency = 34;
     _readToWriteLatency = 2;
     _writeToReadLatency = 6;
+    _rankToRankLatency = 1;
     _numWriteBufferEntries = 64;
     _channelDelay = 4;
     _busProcessorRatio = 8;
-    _schedAlgo = "fcfs";
+    _schedAlgo = "frfcfs-drain";
+    _dbiAwareWrites = false;
   }
 
 
@@ -120,14 +154,21 @@ public:
     CMP_PARAMETER_BEGIN
 
       // Add the list of parameters to the component here
+      CMP_PARAMETER_UINT("num-channels", _numChannels)
+      CMP_PARAMETER_UINT("num-ranks", _numRanks)
       CMP_PARAMETER_UINT("num-banks", _numBanks)
       CMP_PARAMETER_UINT("row-size", _rowSize)
+      CMP_PARAMETER_UINT("line-size", _lineSize)
+      CMP_PARAMETER_STRING("address-mapping", _addressMapping)
+      CMP_PARAMETER_BOOLEAN("physical-address", _usePhysicalAddress)
       CMP_PARAMETER_UINT("num-write-buffer-entries", _numWriteBufferEntries)
       CMP_PARAMETER_STRING("scheduling-algo", _schedAlgo)
+      CMP_PARAMETER_BOOLEAN("dbi-aware-writes", _dbiAwareWrites)
       CMP_PARAMETER_UINT("row-hit-latency", _rowHitLatency)
       CMP_PARAMETER_UINT("row-conflict-latency", _rowConflictLatency)
       CMP_PARAMETER_UINT("read-to-write-latency", _readToWriteLatency)
-      CMP_PARAMETER_UINT("write-to-read-latency", _readToWriteLatency)
+      CMP_PARAMETER_UINT("write-to-read-latency", _writeToReadLatency)
+      CMP_PARAMETER_UINT("rank-to-rank-latency", _rankToRankLatency)
         
       CMP_PARAMETER_UINT("channel-delay", _channelDelay)
       CMP_PARAMETER_UINT("bus-processor-ratio", _busProcessorRatio)
@@ -152,6 +193,14 @@ public:
     INITIALIZE_COUNTER(rowconflicts, "Row Buffer Conflicts");
     INITIALIZE_COUNTER(readtowrites, "Read to Write Switches");
     INITIALIZE_COUNTER(writetoreads, "Write to Read Switches");
+    INITIALIZE_COUNTER(ranktoranks, "Rank to Rank Switches");
+    INITIALIZE_COUNTER(write_rowhits, "Write Row Buffer Hits");
+    INITIALIZE_COUNTER(dbi_queries, "DBI Dirty Row Queries");
+    INITIALIZE_COUNTER(dbi_pulled_writebacks, "Writebacks Pulled from the DBI");
+    INITIALIZE_VECTOR_COUNTER(_channelAccesses, "channel-accesses",
+        "Accesses of each channel")
+    INITIALIZE_VECTOR_COUNTER(_channelBusyCycles, "channel-busy_cycles",
+        "Busy cycles of each channel")
   }
 
 
@@ -160,15 +209,26 @@ public:
   // -------------------------------------------------------------------------
 
   void StartSimulation() {
-    _openRow.resize(_numBanks, 0);
+    _mapping.Initialize(_addressMapping, _numChannels, _numRanks, _numBanks,
+        _rowSize, _lineSize);
     NextRequest = GetSchedulingAlgorithmFunction(_schedAlgo);
-    _drain = false;
-    _lastOp = MemoryRequest::READ;
+
+    _channels.resize(_numChannels);
+    for (uint32 i = 0; i < _numChannels; i ++) {
+      _channels[i].requests.SetNumBanks(_numRanks * _numBanks);
+      _channels[i].drain = false;
+      _channels[i].lastWrite = false;
+      _channels[i].lastRank = 0;
+      _channels[i].currentCycle = _currentCycle;
+    }
+    _channelAccesses.assign(_numChannels, 0);
+    _channelBusyCycles.assign(_numChannels, 0);
 
     _rowHitLatency *= _busProcessorRatio;
     _rowConflictLatency *= _busProcessorRatio;
     _readToWriteLatency *= _busProcessorRatio;
     _writeToReadLatency *= _busProcessorRatio;
+    _rankToRankLatency *= _busProcessorRatio;
     _channelDelay *= _busProcessorRatio;
   }
 
@@ -182,12 +242,51 @@ public:
   }
 
 
+  // -------------------------------------------------------------------------
+  // Function called when warmup ends
+  // -------------------------------------------------------------------------
+
+  void EndWarmUp() {
+    MemoryComponent::EndWarmUp();
+    fill(_channelAccesses.begin(), _channelAccesses.end(), 0);
+    fill(_channelBusyCycles.begin(), _channelBusyCycles.end(), 0);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation ends
+  // -------------------------------------------------------------------------
+
   void EndSimulation() {
     DUMP_STATISTICS;
+    CMP_LOG("write-rowhit-rate = %.4lf", writes == 0 ? 0.0 :
+        (double)write_rowhits / writes);
     CLOSE_ALL_LOGS;
   }
 
 
+  // -------------------------------------------------------------------------
+  // Function to get the earliest cycle at which the component has work to
+  // do. A busy channel with queued requests schedules again when it is free.
+  // Requests that the scheduler holds on a free channel (writes below the
+  // drain threshold) wait for an arrival and are not an event.
+  // -------------------------------------------------------------------------
+
+  bool NextEvent(cycles_t &cycle) {
+    bool valid = MemoryComponent::NextEvent(cycle);
+    for (uint32 i = 0; i < _channels.size(); i ++) {
+      Channel &channel = _channels[i];
+      if (channel.requests.Empty() ||
+          channel.currentCycle <= (*_simulatorCycle))
+        continue;
+      if (!valid || channel.currentCycle < cycle)
+        cycle = channel.currentCycle;
+      valid = true;
+    }
+    return valid;
+  }
+
+
 protected:
 
   // -------------------------------------------------------------------------
@@ -195,8 +294,29 @@ protected:
   // -------------------------------------------------------------------------
 
   MemoryRequest * (CmpMemoryController::*GetSchedulingAlgorithmFunction(
-                                                                        string algo)) () {
-    if (algo.compare("fcfs")) return &CmpMemoryController::FCFS;
+        string algo)) (MemoryRequestQueue &, bool &) {
+    if (algo.compare("fcfs") == 0) return &CmpMemoryController::FCFS;
+    if (algo.compare("fcfs-drain") == 0)
+      return &CmpMemoryController::FCFSDrainWhenFull;
+    if (algo.compare("frfcfs") == 0) return &CmpMemoryController::FRFCFS;
+    if (algo.compare("frfcfs-drain") == 0)
+      return &CmpMemoryController::FRFCFSDrainWhenFull;
+    fprintf(stderr, "Error: Unknown scheduling algorithm `%s' for `%s'\n",
+        algo.c_str(), _name.c_str());
+    exit(-1);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the location of a request. The bank index is the index
+  // of the bank within the channel.
+  // -------------------------------------------------------------------------
+
+  void GetLocation(MemoryRequest *request, DRAMAddress &location,
+      uint32 &bankIndex) {
+    _mapping.Map(_usePhysicalAddress ? PADDR(request) : VADDR(request),
+        location);
+    bankIndex = location.rank * _numBanks + location.bank;
   }
 
 
@@ -212,25 +332,32 @@ protected:
     cycles_t latency = 0;
     cycles_t turnAround = 0;
 
+    DRAMAddress location;
+    uint32 bankIndex;
+    GetLocation(request, location, bankIndex);
+    Channel &channel = _channels[location.channel];
+
     // determine if there is a switch penalty
     switch (request -> type) {
 
     case MemoryRequest::READ: case MemoryRequest::READ_FOR_WRITE: case MemoryRequest::PREFETCH:
       INCREMENT(reads);
-      if (_lastOp == MemoryRequest::WRITEBACK) {
+      if (channel.lastWrite) {
         INCREMENT(writetoreads);
         latency += _writeToReadLatency;
         turnAround = _writeToReadLatency;
       }
+      channel.lastWrite = false;
       break;
 
     case MemoryRequest::WRITEBACK:
       INCREMENT(writes);
-      if (_lastOp == MemoryRequest::READ) {
+      if (!channel.lastWrite) {
         INCREMENT(readtowrites);
         latency += _readToWriteLatency;
         turnAround = _readToWriteLatency;
       }
+      channel.lastWrite = true;
       break;
 
     case MemoryRequest::WRITE:
@@ -239,28 +366,38 @@ protected:
       exit(0);          
     }
 
-    _lastOp = request -> type;
-
-      
-    // Get the row address of the request
-    addr_t logicalRow = (request -> virtualAddress) / _rowSize;
-    uint32 bankIndex = logicalRow % _numBanks;
-    uint32 rowID = logicalRow / _numBanks;
+    // switching ranks needs a bus turnaround
+    if (location.rank != channel.lastRank) {
+      INCREMENT(ranktoranks);
+      latency += _rankToRankLatency;
+      turnAround += _rankToRankLatency;
+      channel.lastRank = location.rank;
+    }
 
     // check if the access is a row hit or conflict
-    if (_openRow[bankIndex] == rowID) {
+    if (channel.requests.IsOpen(bankIndex, location.row)) {
       INCREMENT(rowhits);
+      if (request -> type == MemoryRequest::WRITEBACK)
+        INCREMENT(write_rowhits);
+      if (request -> drain)
+        request -> drain -> rowHits ++;
       latency += _rowHitLatency;
     }
 
     else {
       INCREMENT(rowconflicts);
       latency += _rowConflictLatency;
-      _openRow[bankIndex] = rowID;
+      channel.requests.SetOpenRow(bankIndex, location.row);
+
+      // pull the other dirty blocks of the row while it is open
+      if (_dbiAwareWrites && request -> type == MemoryRequest::WRITEBACK)
+        PullDirtyRow(request, location, bankIndex);
     }
 
     request -> AddLatency(latency);
     request -> serviced = true;
+    _channelAccesses[location.channel] ++;
+    _channelBusyCycles[location.channel] += _channelDelay + turnAround;
     return _channelDelay + turnAround;
   }
 
@@ -287,8 +424,7 @@ protected:
     _processing = true;
 
     // if the request queue is empty return
-    if (_queue.empty() && _readQ.empty() && _writeQ.empty() 
-        && _readRowHits.empty() && _writeRowHits.empty()) {
+    if (_queue.empty() && RequestQueuesEmpty()) {
       _processing = false;
       return;
     }
@@ -314,13 +450,18 @@ protected:
         // else add the request to the corresponding queue 
         else {
 
+          DRAMAddress location;
+          uint32 bankIndex;
+          GetLocation(request, location, bankIndex);
+          MemoryRequestQueue &requests = _channels[location.channel].requests;
+
           switch (request -> type) {
           case MemoryRequest::READ: case MemoryRequest::READ_FOR_WRITE: case MemoryRequest::PREFETCH: 
-            _readQ.push_back(request);
+            requests.Insert(request, READ_QUEUE, bankIndex, location.row);
             break;
 
           case MemoryRequest::WRITEBACK:
-            _writeQ.push_back(request);
+            requests.Insert(request, WRITE_QUEUE, bankIndex, location.row);
             break;
 
           case MemoryRequest::WRITE:
@@ -337,24 +478,28 @@ protected:
       }
     }
 
-    // process requests until there are none or the component time 
-    // exceeds simulator time
-    while (_currentCycle <= (*_simulatorCycle)) {
+    // process requests on each channel until there are none or the channel
+    // time exceeds simulator time
+    for (uint32 i = 0; i < _channels.size(); i ++) {
 
-      // get the next request to schedule
-      // TODO: request = (*this.*NextRequest)();
-      request = FRFCFSDrainWhenFull();
+      Channel &channel = _channels[i];
 
-      if (request == NULL)
-        break;
+      while (channel.currentCycle <= (*_simulatorCycle)) {
 
-      // process the request
-      cycles_t now = max(request -> currentCycle, _currentCycle);
-      _currentCycle = now;
-      request -> currentCycle = now;
-      cycles_t busyCycles = ProcessRequest(request);
-      _currentCycle += busyCycles;
-      SendToNextComponent(request);
+        // get the next request to schedule
+        request = (this ->* NextRequest)(channel.requests, channel.drain);
+
+        if (request == NULL)
+          break;
+
+        // process the request
+        cycles_t now = max(request -> currentCycle, channel.currentCycle);
+        channel.currentCycle = now;
+        request -> currentCycle = now;
+        cycles_t busyCycles = ProcessRequest(request);
+        channel.currentCycle += busyCycles;
+        SendToNextComponent(request);
+      }
     }
 
     _processing = false;
@@ -362,18 +507,55 @@ protected:
 
 
   // -------------------------------------------------------------------------
-  // Function to check if a request is a row buffer hit
+  // Function to pull the dirty blocks of a row that is opened for a write
+  // from the DBI above. They are added to the write queue of the bank, where
+  // the scheduler finds them as row hits.
+  // -------------------------------------------------------------------------
+
+  void PullDirtyRow(MemoryRequest *request, DRAMAddress &location,
+      uint32 bankIndex) {
+
+    MemoryComponent *dbi = DirtyRowSource(request);
+    if (dbi == NULL)
+      return;
+
+    INCREMENT(dbi_queries);
+    vector <addr_t> vblocks, pblocks;
+    dbi -> DirtyRowBlocks(request, vblocks, pblocks);
+
+    for (uint32 i = 0; i < vblocks.size(); i ++) {
+
+      DRAMAddress block;
+      _mapping.Map(_usePhysicalAddress ? pblocks[i] : vblocks[i], block);
+      if (block.channel != location.channel || block.rank != location.rank ||
+          block.bank != location.bank || block.row != location.row)
+        continue;
+
+      MemoryRequest *writeback = dbi -> CleanBlock(vblocks[i], pblocks[i],
+          request);
+      if (writeback == NULL)
+        continue;
+
+      INCREMENT(dbi_pulled_writebacks);
+      writeback -> cmpID = request -> cmpID;
+      _channels[location.channel].requests.Insert(writeback, WRITE_QUEUE,
+          bankIndex, location.row);
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to check if all channel request queues are empty
   // -------------------------------------------------------------------------
 
-  bool IsRowBufferHit(MemoryRequest *request) {
-    addr_t logicalRow = (request -> virtualAddress) / _rowSize;
-    uint32 bankIndex = logicalRow % _numBanks;
-    addr_t rowID = logicalRow / _numBanks;
-    if (_openRow[bankIndex] == rowID)
-      return true;
-    return false;
+  bool RequestQueuesEmpty() {
+    for (uint32 i = 0; i < _channels.size(); i ++)
+      if (!_channels[i].requests.Empty())
+        return false;
+    return true;
   }
 
+
 #include "MemorySchedulers.h"
 
 };
@@ -11,7 +11,7 @@
 // Module includes
 // -----------------------------------------------------------------------------
 
-#include "MemoryComponent.h"
+#include "Prefetcher.h"
 #include "Types.h"
 
 // -----------------------------------------------------------------------------
@@ -26,7 +26,7 @@
 // of lines to prefetch can be configured
 // -----------------------------------------------------------------------------
 
-class CmpNextLinePrefetcher : public MemoryComponent {
+class CmpNextLinePrefetcher : public Prefetcher {
 
 protected:
 
@@ -80,6 +80,7 @@ public:
       CMP_PARAMETER_UINT("degree", _degree)
       CMP_PARAMETER_UINT("block-size", _blockSize)
       CMP_PARAMETER_BOOLEAN("prefetch-on-write", _prefetchOnWrite)
+      else if (AddQueueParameter(pname, pvalue)) {}
 
     CMP_PARAMETER_END
  }
@@ -90,6 +91,7 @@ public:
   // -------------------------------------------------------------------------
 
   void InitializeStatistics() {
+    InitializeQueueStatistics();
   }
 
 
@@ -98,6 +100,7 @@ public:
   // -------------------------------------------------------------------------
 
   void StartSimulation() {
+    StartQueue();
   }
 
 
@@ -141,13 +144,7 @@ protected:
     for (int i = 0; i < _degree; i ++) {
       vcla += _blockSize;
       pcla += _blockSize;
-      MemoryRequest *prefetch =
-        new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                          MemoryRequest::PREFETCH, request -> cmpID, 
-                          vcla, pcla, _blockSize, request -> currentCycle);
-      prefetch -> icount = request -> icount;
-      prefetch -> ip = request -> ip;
-      SendToNextComponent(prefetch);
+      IssuePrefetch(request, vcla, pcla, _blockSize, 0);
     }
     
     return 0; 
@@ -161,9 +158,10 @@ protected:
     
   cycles_t ProcessReturn(MemoryRequest *request) {
 
-    // if its a prefetch from this component, delete it
+    // if its a prefetch from this component, delete it unless it goes on to
+    // fill the levels above
     if (request -> iniType == MemoryRequest::COMPONENT &&
-        request -> iniPtr == this) {
+        request -> iniPtr == this && !FillsAbove(request)) {
       request -> destroy = true;
     }
     
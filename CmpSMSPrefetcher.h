@@ -0,0 +1,343 @@
+// -----------------------------------------------------------------------------
+// File: CmpSMSPrefetcher.h
+// Description:
+//    Implements a spatial memory streaming (SMS) prefetcher
+// -----------------------------------------------------------------------------
+
+#ifndef __CMP_SMS_PREFETCHER_H__
+#define __CMP_SMS_PREFETCHER_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "Prefetcher.h"
+#include "GenericTable.h"
+#include "GenericTagStore.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <cstdlib>
+
+
+// -----------------------------------------------------------------------------
+// Class: CmpSMSPrefetcher
+// Description:
+//    Spatial memory streaming (Somogyi et al., ISCA 2006). Memory is divided
+//    into regions. A generation of a region starts with a trigger access and
+//    records the bit pattern of the blocks accessed in the region. The
+//    pattern is learned in the pattern history table (PHT) under the
+//    signature of the trigger, (IP, offset of the trigger in the region). The
+//    next trigger with the same signature prefetches the blocks of the
+//    pattern.
+//
+//    A region with a single access is held in the filter table and moves to
+//    the accumulation table on its second distinct block. The prefetcher does
+//    not see evictions from the cache above it, so a generation ends when
+//    its accumulation table entry is evicted.
+//
+//    Demands to blocks the current generation predicted are tagged with
+//    d_prefetched, and d_prefID and the prefetches carry the signature
+//    modulo num-ids, so num-ids must not exceed the accuracy table of a
+//    prefetch-aware LLC below.
+// -----------------------------------------------------------------------------
+
+class CmpSMSPrefetcher : public Prefetcher {
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  uint32 _blockSize;
+  uint32 _regionSize;
+  bool _prefetchOnWrite;
+
+  uint32 _filterTableSize;
+  uint32 _accumulationTableSize;
+  string _tablePolicy;
+  uint32 _phtSets;
+  uint32 _phtWays;
+  string _phtPolicy;
+  uint32 _numIDs;
+
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  struct Generation {
+    // signature and region offset of the trigger access
+    uint64 signature;
+    uint32 triggerOffset;
+
+    // blocks accessed in the generation
+    uint64 pattern;
+
+    // blocks prefetched at the trigger and their prefetcher id
+    uint64 predicted;
+    uint32 prefID;
+  };
+
+  uint32 _regionBlocks;
+
+  generic_table_t <addr_t, Generation> _filterTable;
+  generic_table_t <addr_t, Generation> _accumulationTable;
+  generic_tagstore_t <uint64, uint64> _pht;
+
+
+  // -------------------------------------------------------------------------
+  // Declare Counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(num_prefetches);
+  NEW_COUNTER(triggers);
+  NEW_COUNTER(pattern_hits);
+  NEW_COUNTER(generations);
+  NEW_COUNTER(predicted_demands);
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor. It cannot take any arguments
+  // -------------------------------------------------------------------------
+
+  CmpSMSPrefetcher() {
+    _blockSize = 64;
+    _regionSize = 2048;
+    _prefetchOnWrite = false;
+
+    _filterTableSize = 32;
+    _accumulationTableSize = 64;
+    _tablePolicy = "lru";
+    _phtSets = 256;
+    _phtWays = 8;
+    _phtPolicy = "lru";
+    _numIDs = 128;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Virtual functions to be implemented by the components
+  // -------------------------------------------------------------------------
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter to the component
+  // -------------------------------------------------------------------------
+
+  void AddParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      // Add the list of parameters to the component here
+      CMP_PARAMETER_UINT("block-size", _blockSize)
+      CMP_PARAMETER_UINT("region-size", _regionSize)
+      CMP_PARAMETER_BOOLEAN("prefetch-on-write", _prefetchOnWrite)
+
+      CMP_PARAMETER_UINT("filter-table-size", _filterTableSize)
+      CMP_PARAMETER_UINT("accumulation-table-size", _accumulationTableSize)
+      CMP_PARAMETER_STRING("table-policy", _tablePolicy)
+      CMP_PARAMETER_UINT("pht-sets", _phtSets)
+      CMP_PARAMETER_UINT("pht-ways", _phtWays)
+      CMP_PARAMETER_STRING("pht-policy", _phtPolicy)
+      CMP_PARAMETER_UINT("num-ids", _numIDs)
+      else if (AddQueueParameter(pname, pvalue)) {}
+
+    CMP_PARAMETER_END
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to initialize statistics
+  // -------------------------------------------------------------------------
+
+  void InitializeStatistics() {
+    INITIALIZE_COUNTER(num_prefetches, "Number of prefetches issued")
+    INITIALIZE_COUNTER(triggers, "Generation trigger accesses")
+    INITIALIZE_COUNTER(pattern_hits, "Triggers with a pattern in the PHT")
+    INITIALIZE_COUNTER(generations, "Generations recorded in the PHT")
+    INITIALIZE_COUNTER(predicted_demands, "Demands to predicted blocks")
+    InitializeQueueStatistics();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation starts
+  // -------------------------------------------------------------------------
+
+  void StartSimulation() {
+    _regionBlocks = _regionSize / _blockSize;
+    if (_regionSize % _blockSize != 0 || _regionBlocks == 0 ||
+        _regionBlocks > 64) {
+      fprintf(stderr, "Error: `%s' needs regions of 1 to 64 blocks\n",
+              _name.c_str());
+      exit(-1);
+    }
+
+    _filterTable.SetTableParameters(_filterTableSize, _tablePolicy);
+    _accumulationTable.SetTableParameters(_accumulationTableSize,
+                                          _tablePolicy);
+    _pht.SetTagStoreParameters(_phtSets, _phtWays, _phtPolicy);
+    StartQueue();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called at a heart beat. Argument indicates cycles elapsed after
+  // previous heartbeat
+  // -------------------------------------------------------------------------
+
+  void HeartBeat(cycles_t hbCount) {
+  }
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to process a request. Return value indicates number of busy
+  // cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessRequest(MemoryRequest *request) {
+
+    if (request -> type == MemoryRequest::WRITE ||
+        request -> type == MemoryRequest::WRITEBACK ||
+        request -> type == MemoryRequest::PREFETCH) {
+      // do nothing
+      return 0;
+    }
+
+    if (!_prefetchOnWrite &&
+        (request -> type == MemoryRequest::READ_FOR_WRITE)) {
+      // do nothing
+      return 0;
+    }
+
+    addr_t vcla = VBLOCK_ADDRESS(request, _blockSize);
+    addr_t pcla = PBLOCK_ADDRESS(request, _blockSize);
+    uint32 offset = (vcla % _regionSize) / _blockSize;
+    uint64 bit = (uint64)1 << offset;
+
+    // regions of different cpus are kept apart
+    addr_t key = (vcla / _regionSize) * _numCPUs + request -> cpuID;
+
+    // region in the accumulation table. record the access
+    if (_accumulationTable.lookup(key)) {
+      _accumulationTable.read(key);
+      Generation &gen = _accumulationTable[key];
+      gen.pattern |= bit;
+      TagPredicted(request, gen, bit);
+      return 0;
+    }
+
+    // region in the filter table. a second block moves the region to the
+    // accumulation table
+    if (_filterTable.lookup(key)) {
+      Generation gen = _filterTable[key];
+      TagPredicted(request, gen, bit);
+      if (gen.pattern & bit)
+        return 0;
+
+      gen.pattern |= bit;
+      _filterTable.invalidate(key);
+      table_t <addr_t, Generation>::entry evicted =
+        _accumulationTable.insert(key, gen);
+      if (evicted.valid)
+        EndGeneration(evicted.value);
+      return 0;
+    }
+
+    // trigger access. start a generation and prefetch the pattern of its
+    // signature
+    INCREMENT(triggers);
+
+    Generation gen;
+    gen.signature = Signature(request -> ip, offset);
+    gen.triggerOffset = offset;
+    gen.pattern = bit;
+    gen.predicted = 0;
+    gen.prefID = gen.signature % _numIDs;
+
+    if (_pht.lookup(gen.signature)) {
+      INCREMENT(pattern_hits);
+      _pht.read(gen.signature);
+      gen.predicted = _pht[gen.signature] & ~bit;
+
+      addr_t vregion = vcla - offset * _blockSize;
+      addr_t pregion = pcla - offset * _blockSize;
+      for (uint32 i = 0; i < _regionBlocks; i ++) {
+        if (!(gen.predicted & ((uint64)1 << i))) continue;
+        IssuePrefetch(request, vregion + i * _blockSize,
+                      pregion + i * _blockSize, _blockSize, gen.prefID);
+        INCREMENT(num_prefetches);
+      }
+    }
+
+    // a filter table entry that is evicted saw a single access and has
+    // nothing to learn
+    _filterTable.insert(key, gen);
+
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process the return of a request. Return value indicates
+  // number of busy cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessReturn(MemoryRequest *request) {
+
+    // if its a prefetch from this component, delete it unless it goes on to
+    // fill the levels above
+    if (request -> iniType == MemoryRequest::COMPONENT &&
+        request -> iniPtr == this && !FillsAbove(request)) {
+      request -> destroy = true;
+    }
+
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to compute the signature of a trigger access
+  // -------------------------------------------------------------------------
+
+  uint64 Signature(addr_t ip, uint32 offset) {
+    return ip * _regionBlocks + offset;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to tag a demand to a block that the generation predicted
+  // -------------------------------------------------------------------------
+
+  void TagPredicted(MemoryRequest *request, Generation &gen, uint64 bit) {
+    if (gen.predicted & bit) {
+      request -> d_prefetched = true;
+      request -> d_prefID = gen.prefID;
+      INCREMENT(predicted_demands);
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to record the pattern of a generation that ended
+  // -------------------------------------------------------------------------
+
+  void EndGeneration(Generation &gen) {
+    INCREMENT(generations);
+    if (_pht.lookup(gen.signature)) {
+      _pht.read(gen.signature);
+      _pht[gen.signature] = gen.pattern;
+    }
+    else
+      _pht.insert(gen.signature, gen.pattern);
+  }
+};
+
+#endif // __CMP_SMS_PREFETCHER_H__
@@ -11,7 +11,7 @@
 // Module includes
 // -----------------------------------------------------------------------------
 
-#include "MemoryComponent.h"
+#include "Prefetcher.h"
 #include "GenericTable.h"
 #include "Types.h"
 
@@ -20,6 +20,7 @@
 // -----------------------------------------------------------------------------
 
 #include <cstdlib>
+#include <vector>
 
 // -----------------------------------------------------------------------------
 // Class: CmpStreamPrefetcher
@@ -29,7 +30,7 @@
 // prefetcher in scarab/ringo
 // -----------------------------------------------------------------------------
 
-class CmpStreamPrefetcher : public MemoryComponent {
+class CmpStreamPrefetcher : public Prefetcher {
 
 protected:
 
@@ -104,6 +105,33 @@ protected:
   addr_t _trainAddrDistance;
   addr_t _prefetchAddrDistance;
 
+  // Index of the stream table by address region. A valid slot is listed
+  // in the bucket of every region its match window (training window or
+  // [sp, ep]) overlaps, and in the buckets of the regions of its sp and ep
+  // for the redundancy check. Windows wider than MAX_WINDOW_REGIONS are kept
+  // in a short list that every lookup checks. Regions are hashed into a
+  // fixed number of buckets whose lists are reused, so the index does not
+  // allocate once warm. The index only narrows the candidates, the match
+  // tests are the ones of the full scan, and among matches the lowest slot
+  // wins as in the scan.
+  enum { MAX_WINDOW_REGIONS = 4, MAX_POINT_REGIONS = 16 };
+
+  struct IndexedSlot {
+    bool indexed;
+    bool wide;
+    // registered match window. lo > hi if the window is empty
+    addr_t lo, hi;
+    // registered start and end pointers
+    addr_t sp, ep;
+  };
+
+  vector <IndexedSlot> _slots;
+  vector <vector <uint32> > _windowIndex;
+  vector <vector <uint32> > _pointIndex;
+  vector <uint32> _wideSlots;
+  uint32 _regionBits;
+  addr_t _bucketMask;
+
   
   // -------------------------------------------------------------------------
   // Declare Counters
@@ -156,6 +184,7 @@ public:
       CMP_PARAMETER_UINT("distance", _distance)
       CMP_PARAMETER_UINT("degree", _degree)
       CMP_PARAMETER_UINT("max-fake-counter", _maxFakeCounter)
+      else if (AddQueueParameter(pname, pvalue)) {}
 
     CMP_PARAMETER_END
  }
@@ -167,6 +196,7 @@ public:
 
   void InitializeStatistics() {
     INITIALIZE_COUNTER(num_prefetches, "Number of prefetches issued")
+    InitializeQueueStatistics();
   }
 
 
@@ -176,12 +206,30 @@ public:
 
   void StartSimulation() {
     _streamTable.SetTableParameters(_tableSize, _tablePolicy);
+    StartQueue();
     _runningIndex = 0;
 
     _appCounter.resize(_numCPUs, 0);
 
     _trainAddrDistance = _trainDistance * _blockSize;
     _prefetchAddrDistance = _distance * _blockSize;
+
+    // regions are at least as large as a training window or a prefetch
+    // distance, so most windows overlap two regions
+    addr_t region = max(max(_trainAddrDistance, _prefetchAddrDistance),
+                        (addr_t)_blockSize);
+    _regionBits = 0;
+    while (((addr_t)1 << _regionBits) < region) _regionBits ++;
+
+    IndexedSlot slot;
+    slot.indexed = false;
+    _slots.assign(_tableSize, slot);
+
+    addr_t buckets = 1;
+    while (buckets < 4 * (addr_t)_tableSize) buckets <<= 1;
+    _bucketMask = buckets - 1;
+    _windowIndex.assign(buckets, vector <uint32> ());
+    _pointIndex.assign(buckets, vector <uint32> ());
   }
 
 
@@ -223,40 +271,13 @@ protected:
     
     table_t <uint32, StreamEntry>::entry row;
 
-    bool hit = false;
-    uint32 key;
-    
     // Check if there is a stream entry matching the address
-    for (uint32 i = 0; i < _tableSize; i ++) {
-
-      // get row i from the stream table
-      row = _streamTable.entry_at_index(i);
-
-      // if row is invalid, continue
-      if (!row.valid) continue;
-
-      // get the stream entry information
-      StreamEntry entry = row.value;
-
-      // if entry is in the training phase
-      if (!row.value.trained) {
-        if (llabs(entry.allocMissAddress - vcla) < _trainAddrDistance) {
-          // HIT! entry within training scope
-          hit = true;
-          key = row.key;
-          break;
-        }
-      }
-
-      // not training phase
-      else {
-        if (entry.sp <= vcla && entry.ep >= vcla) {
-          // HIT! entry within monitor scope
-          hit = true;
-          key = row.key;
-          break;
-        }
-      }
+    uint32 index = FindStream(vcla);
+    bool hit = (index != _tableSize);
+    uint32 key;
+    if (hit) {
+      row = _streamTable.entry_at_index(index);
+      key = row.key;
     }
 
 
@@ -351,15 +372,7 @@ protected:
         for (int32 i = 0; i < numPrefetches; i ++) {
           entry.ep += (entry.direction * _blockSize);
           entry.pep += (entry.direction * _blockSize);
-          MemoryRequest *prefetch =
-            new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                              MemoryRequest::PREFETCH, request -> cmpID, 
-                              entry.ep, entry.pep, _blockSize,
-                              request -> currentCycle);
-          prefetch -> icount = request -> icount;
-          prefetch -> ip = request -> ip;
-          prefetch -> prefetcherID = row.index;
-          SendToNextComponent(prefetch);
+          IssuePrefetch(request, entry.ep, entry.pep, _blockSize, row.index);
         }
 
         ADD_TO_COUNTER(num_prefetches, numPrefetches);
@@ -433,21 +446,10 @@ protected:
         }
       }
 
+      IndexSlot(index, entry);
+
       // Remove redundant stream entry
-      for (uint32 i = 0; i < _tableSize; i ++) {
-        row = _streamTable.entry_at_index(i);
-        if (!row.valid) continue;
-        if (row.key == key) continue;
-
-        if (((entry.direction == FORWARD) &&
-             ((row.value.sp <= entry.ep && row.value.sp >= entry.sp) ||
-              (row.value.ep <= entry.ep && row.value.ep >= entry.sp))) ||
-            ((entry.direction == BACKWARD) &&
-             ((row.value.sp <= entry.sp && row.value.sp >= entry.ep) ||
-              (row.value.ep <= entry.sp && row.value.ep >= entry.ep)))) {
-          _streamTable.invalidate(row.key);
-        }
-      }
+      RemoveRedundantStreams(key, entry);
     }
     
     // If there is no stream entry, allocate a new stream entry
@@ -473,6 +475,11 @@ protected:
       entry.direction = NONE;
       evicted = _streamTable.insert(_runningIndex, entry);
       _runningIndex ++;
+      IndexSlot(evicted.index, entry);
+
+      // fakes of an evicted stream are tagged with the last slot of the
+      // table, which is where the full scan used to stop
+      row = _streamTable.entry_at_index(_tableSize - 1);
       
       if (_fake && evicted.valid && evicted.value.trained) {
         // issue fake reads
@@ -531,15 +538,185 @@ protected:
     
   cycles_t ProcessReturn(MemoryRequest *request) {
 
-    // if its a prefetch/fake from this component, delete it
+    // if its a prefetch/fake from this component, delete it unless it goes
+    // on to fill the levels above
     if (request -> iniType == MemoryRequest::COMPONENT &&
-        request -> iniPtr == this) {
+        request -> iniPtr == this && !FillsAbove(request)) {
       request -> destroy = true;
     }
     
     return 0; 
   }
 
+
+  // -------------------------------------------------------------------------
+  // Function to get the first slot whose stream matches an address. Returns
+  // the table size if there is none.
+  // -------------------------------------------------------------------------
+
+  uint32 FindStream(addr_t vcla) {
+
+    uint32 best = _tableSize;
+
+    vector <uint32> &slots = Bucket(_windowIndex, vcla >> _regionBits);
+    for (uint32 i = 0; i < slots.size(); i ++)
+      if (slots[i] < best && Matches(slots[i], vcla))
+        best = slots[i];
+
+    for (uint32 i = 0; i < _wideSlots.size(); i ++)
+      if (_wideSlots[i] < best && Matches(_wideSlots[i], vcla))
+        best = _wideSlots[i];
+
+    return best;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to test if the stream in a slot matches an address
+  // -------------------------------------------------------------------------
+
+  bool Matches(uint32 index, addr_t vcla) {
+
+    table_t <uint32, StreamEntry>::entry row =
+      _streamTable.entry_at_index(index);
+    if (!row.valid) return false;
+
+    // training phase
+    if (!row.value.trained)
+      return llabs(row.value.allocMissAddress - vcla) < _trainAddrDistance;
+
+    // not training phase
+    return row.value.sp <= vcla && row.value.ep >= vcla;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to invalidate the streams whose start or end pointer falls in
+  // the range of the given stream. Slots are invalidated in increasing order
+  // as the free list of the table depends on it.
+  // -------------------------------------------------------------------------
+
+  void RemoveRedundantStreams(uint32 key, StreamEntry &entry) {
+
+    addr_t lo, hi;
+    if (entry.direction == FORWARD) {
+      lo = entry.sp;
+      hi = entry.ep;
+    }
+    else if (entry.direction == BACKWARD) {
+      lo = entry.ep;
+      hi = entry.sp;
+    }
+    else
+      return;
+    if (lo > hi) return;
+
+    vector <uint32> candidates;
+    if ((hi >> _regionBits) - (lo >> _regionBits) >= MAX_POINT_REGIONS) {
+      for (uint32 i = 0; i < _tableSize; i ++)
+        candidates.push_back(i);
+    }
+    else {
+      for (addr_t r = lo >> _regionBits; r <= (hi >> _regionBits); r ++) {
+        vector <uint32> &slots = Bucket(_pointIndex, r);
+        candidates.insert(candidates.end(), slots.begin(), slots.end());
+      }
+      sort(candidates.begin(), candidates.end());
+      candidates.erase(unique(candidates.begin(), candidates.end()),
+                       candidates.end());
+    }
+
+    for (uint32 i = 0; i < candidates.size(); i ++) {
+      table_t <uint32, StreamEntry>::entry row =
+        _streamTable.entry_at_index(candidates[i]);
+      if (!row.valid) continue;
+      if (row.key == key) continue;
+
+      if ((row.value.sp >= lo && row.value.sp <= hi) ||
+          (row.value.ep >= lo && row.value.ep <= hi)) {
+        _streamTable.invalidate(row.key);
+        UnindexSlot(candidates[i]);
+      }
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Functions to add and remove a slot from the region index
+  // -------------------------------------------------------------------------
+
+  void IndexSlot(uint32 index, StreamEntry &entry) {
+
+    UnindexSlot(index);
+
+    IndexedSlot &slot = _slots[index];
+    slot.indexed = true;
+    slot.sp = entry.sp;
+    slot.ep = entry.ep;
+
+    if (!entry.trained) {
+      // |allocMissAddress - vcla| < train distance
+      addr_t reach = _trainAddrDistance;
+      if (reach == 0) {
+        slot.lo = 1;
+        slot.hi = 0;
+      }
+      else {
+        slot.lo = (entry.allocMissAddress < reach ? 0 :
+                   entry.allocMissAddress - reach + 1);
+        slot.hi = entry.allocMissAddress + reach - 1;
+      }
+    }
+    else {
+      slot.lo = entry.sp;
+      slot.hi = entry.ep;
+    }
+
+    slot.wide = (slot.lo <= slot.hi &&
+                 (slot.hi >> _regionBits) - (slot.lo >> _regionBits) >=
+                 MAX_WINDOW_REGIONS);
+    if (slot.wide)
+      _wideSlots.push_back(index);
+    else if (slot.lo <= slot.hi)
+      for (addr_t r = slot.lo >> _regionBits; r <= (slot.hi >> _regionBits); r ++)
+        Bucket(_windowIndex, r).push_back(index);
+
+    Bucket(_pointIndex, slot.sp >> _regionBits).push_back(index);
+    if ((slot.ep >> _regionBits) != (slot.sp >> _regionBits))
+      Bucket(_pointIndex, slot.ep >> _regionBits).push_back(index);
+  }
+
+  void UnindexSlot(uint32 index) {
+
+    IndexedSlot &slot = _slots[index];
+    if (!slot.indexed) return;
+    slot.indexed = false;
+
+    if (slot.wide)
+      RemoveFromList(_wideSlots, index);
+    else if (slot.lo <= slot.hi)
+      for (addr_t r = slot.lo >> _regionBits; r <= (slot.hi >> _regionBits); r ++)
+        RemoveFromList(Bucket(_windowIndex, r), index);
+
+    RemoveFromList(Bucket(_pointIndex, slot.sp >> _regionBits), index);
+    if ((slot.ep >> _regionBits) != (slot.sp >> _regionBits))
+      RemoveFromList(Bucket(_pointIndex, slot.ep >> _regionBits), index);
+  }
+
+  vector <uint32> &Bucket(vector <vector <uint32> > &index, addr_t region) {
+    return index[(region ^ (region >> 17)) & _bucketMask];
+  }
+
+  void RemoveFromList(vector <uint32> &list, uint32 index) {
+    for (uint32 i = 0; i < list.size(); i ++) {
+      if (list[i] == index) {
+        list[i] = list.back();
+        list.pop_back();
+        return;
+      }
+    }
+  }
+
 };
 
 #endif // __CMP_STREAM_PREFETCHER_H__
@@ -11,7 +11,7 @@
 // Module includes
 // -----------------------------------------------------------------------------
 
-#include "MemoryComponent.h"
+#include "Prefetcher.h"
 #include "Types.h"
 #include "GenericTable.h"
 
@@ -20,6 +20,7 @@
 // Standard includes
 // -----------------------------------------------------------------------------
 
+#include <vector>
 
 // -----------------------------------------------------------------------------
 // Class: CmpStridePrefetcher
@@ -29,7 +30,7 @@
 // -----------------------------------------------------------------------------
 
 
-class CmpStridePrefetcher : public MemoryComponent {
+class CmpStridePrefetcher : public Prefetcher {
 
 protected:
 
@@ -43,6 +44,8 @@ protected:
 
   uint32 _tableSize;
   string _tablePolicy;
+  uint32 _associativity;
+  uint32 _tagBits;
   uint32 _numTrains;
   uint32 _trainDistance;
   uint32 _distance;
@@ -78,6 +81,21 @@ protected:
 
   generic_table_t <addr_t, StrideEntry> _strideTable;
 
+  // Set-associative IP table, used when associativity is not 0. Ways hold
+  // a partial tag of the hashed IP (tag-bits wide, 0 for the full hash) and
+  // are replaced LRU by the stamp of their last access.
+  struct StrideWay {
+    bool valid;
+    addr_t tag;
+    uint64 stamp;
+    StrideEntry entry;
+  };
+
+  vector <StrideWay> _ways;
+  uint32 _numSets;
+  addr_t _tagMask;
+  uint64 _stamp;
+
 
   // -------------------------------------------------------------------------
   // Declare Counters
@@ -99,6 +117,8 @@ public:
 		
     _tableSize = 16;
     _tablePolicy = "lru";
+    _associativity = 0;
+    _tagBits = 16;
 
     _numTrains = 2;
     _distance = 24;
@@ -124,9 +144,12 @@ public:
       CMP_PARAMETER_BOOLEAN("prefetch-on-write", _prefetchOnWrite)	  
       CMP_PARAMETER_UINT("table-size", _tableSize)
       CMP_PARAMETER_STRING("table-policy", _tablePolicy)
+      CMP_PARAMETER_UINT("associativity", _associativity)
+      CMP_PARAMETER_UINT("tag-bits", _tagBits)
       CMP_PARAMETER_UINT("train-distance", _trainDistance)
       CMP_PARAMETER_UINT("num-trains", _numTrains)
       CMP_PARAMETER_UINT("distance", _distance)
+      else if (AddQueueParameter(pname, pvalue)) {}
 
     CMP_PARAMETER_END
   }
@@ -138,6 +161,7 @@ public:
 
   void InitializeStatistics() {
     INITIALIZE_COUNTER(num_prefetches, "Number of prefetches issued")
+    InitializeQueueStatistics();
   }
 
 
@@ -146,7 +170,23 @@ public:
   // -------------------------------------------------------------------------
 
   void StartSimulation() {
-    _strideTable.SetTableParameters(_tableSize, _tablePolicy);
+    if (_associativity == 0)
+      _strideTable.SetTableParameters(_tableSize, _tablePolicy);
+    else {
+      if (_tableSize % _associativity != 0 || _tableSize == 0) {
+        fprintf(stderr, "Error: `%s' needs a table size that is a multiple "
+                "of the associativity\n", _name.c_str());
+        exit(-1);
+      }
+      _numSets = _tableSize / _associativity;
+      _tagMask = (_tagBits == 0 || _tagBits >= 64) ?
+        ~(addr_t)0 : ((addr_t)1 << _tagBits) - 1;
+      StrideWay way;
+      way.valid = false;
+      _ways.assign(_tableSize, way);
+      _stamp = 0;
+    }
+    StartQueue();
   }
 
 
@@ -185,12 +225,10 @@ protected:
     addr_t pcla = PBLOCK_ADDRESS(request, _blockSize);
     addr_t ip = request -> ip;
 
-    table_t <addr_t, StrideEntry>::entry row;
+    StrideEntry *found = FindEntry(ip);
 
-    row = _strideTable.read(ip);
-    
     // if no IP entry found, add new entry.
-    if (!row.valid) {
+    if (found == NULL) {
       StrideEntry entry;
       entry.vaddr = VBLOCK_ADDRESS(request, _blockSize); 
       entry.paddr = PBLOCK_ADDRESS(request, _blockSize);
@@ -199,14 +237,14 @@ protected:
       entry.stride = 0;
       
       // insert the new entry into the table
-      _strideTable.insert(request->ip, entry);
+      InsertEntry(ip, entry);
       
       return 0;
     }
 		
 
     // Stride table hit. Actual read entry
-    StrideEntry &entry = _strideTable[ip];
+    StrideEntry &entry = *found;
 		
     // compute stride
     int vstride = vcla - entry.vaddr;
@@ -253,17 +291,8 @@ protected:
         entry.vpref += _blockSize * entry.stride;
         entry.ppref += _blockSize * entry.stride;
 
-        // generate memory request
-        MemoryRequest *prefetch =
-          new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
-                            MemoryRequest::PREFETCH, request -> cmpID, 
-                            entry.vpref, entry.ppref, _blockSize,
-                            request -> currentCycle);
-        prefetch -> icount = request -> icount;
-        prefetch -> ip = request -> ip;
-
         // send the prefetch request downstream
-        SendToNextComponent(prefetch);
+        IssuePrefetch(request, entry.vpref, entry.ppref, _blockSize, 0);
       }
 		
       ADD_TO_COUNTER(num_prefetches, numPrefetches);
@@ -280,15 +309,77 @@ protected:
     
   cycles_t ProcessReturn(MemoryRequest *request) {
 
-    // if its a prefetch from this component, delete it
+    // if its a prefetch from this component, delete it unless it goes on to
+    // fill the levels above
     if (request -> iniType == MemoryRequest::COMPONENT &&
-        request -> iniPtr == this) {
+        request -> iniPtr == this && !FillsAbove(request)) {
       request -> destroy = true;
     }
     
     return 0; 
   }
 
+
+  // -------------------------------------------------------------------------
+  // Function to find the entry of an IP and update its replacement state.
+  // Returns NULL if there is none.
+  // -------------------------------------------------------------------------
+
+  StrideEntry *FindEntry(addr_t ip) {
+
+    if (_associativity == 0) {
+      if (!_strideTable.read(ip).valid)
+        return NULL;
+      return &_strideTable[ip];
+    }
+
+    addr_t hash = Hash(ip);
+    StrideWay *set = &_ways[(hash % _numSets) * _associativity];
+    addr_t tag = (hash / _numSets) & _tagMask;
+    for (uint32 i = 0; i < _associativity; i ++) {
+      if (set[i].valid && set[i].tag == tag) {
+        set[i].stamp = ++ _stamp;
+        return &set[i].entry;
+      }
+    }
+    return NULL;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to insert the entry of an IP
+  // -------------------------------------------------------------------------
+
+  void InsertEntry(addr_t ip, StrideEntry &entry) {
+
+    if (_associativity == 0) {
+      _strideTable.insert(ip, entry);
+      return;
+    }
+
+    addr_t hash = Hash(ip);
+    StrideWay *set = &_ways[(hash % _numSets) * _associativity];
+    StrideWay *victim = set;
+    for (uint32 i = 1; i < _associativity && victim -> valid; i ++) {
+      if (!set[i].valid || set[i].stamp < victim -> stamp)
+        victim = &set[i];
+    }
+    victim -> valid = true;
+    victim -> tag = (hash / _numSets) & _tagMask;
+    victim -> stamp = ++ _stamp;
+    victim -> entry = entry;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to hash an IP for the set-associative table
+  // -------------------------------------------------------------------------
+
+  addr_t Hash(addr_t ip) {
+    addr_t hash = ip * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 32);
+  }
+
 };
 
 #endif // __CMP_STRIDE_PREFETCHER_H__
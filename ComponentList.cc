@@ -7,6 +7,8 @@
 #include "CmpCache.h"
 #include "CmpStall.h"
 #include "CmpMemoryController.h"
+#include "CmpDDR.h"
+#include "CmpAnalyticMemory.h"
 #include "CmpUCP.h"
 
 // EAF work
@@ -26,6 +28,9 @@
 #include "CmpNextLinePrefetcher.h"
 #include "CmpStreamPrefetcher.h"
 #include "CmpStridePrefetcher.h"
+#include "CmpSMSPrefetcher.h"
+#include "CmpBestOffsetPrefetcher.h"
+#include "CmpGHBPrefetcher.h"
 
 // DCP
 #include "CmpDCP.h"
@@ -36,9 +41,15 @@
 // DBI
 #include "CmpLLCDBI.h"
 #include "CmpLLCwAWB.h"
+#include "CmpDCPDBI.h"
+
+// On-chip network
+#include "CmpInterconnect.h"
 
 // DRAMSim
+#ifdef DRAMSIM
 #include "CmpDRAMSim.h"
+#endif
 
 // -----------------------------------------------------------------------------
 // Function to create a new component
@@ -58,6 +69,8 @@ MemoryComponent *CreateComponent(string type) {
     COMPONENT("cache", CmpCache)
     COMPONENT("stall", CmpStall)
     COMPONENT("simple-mc", CmpMemoryController)
+    COMPONENT("ddr", CmpDDR)
+    COMPONENT("analytic-mc", CmpAnalyticMemory)
     COMPONENT("ucp", CmpUCP)
     COMPONENT("dynamic-llc", CmpDynamicLLC)
     COMPONENT("baseline-llc", CmpLLC)
@@ -75,6 +88,9 @@ MemoryComponent *CreateComponent(string type) {
     COMPONENT("next-line-prefetcher", CmpNextLinePrefetcher)
     COMPONENT("stream-prefetcher", CmpStreamPrefetcher)
     COMPONENT("stride-prefetcher", CmpStridePrefetcher)
+    COMPONENT("sms-prefetcher", CmpSMSPrefetcher)
+    COMPONENT("best-offset-prefetcher", CmpBestOffsetPrefetcher)
+    COMPONENT("ghb-prefetcher", CmpGHBPrefetcher)
 
     // DCP
     COMPONENT("dcp", CmpDCP)
@@ -85,9 +101,15 @@ MemoryComponent *CreateComponent(string type) {
     // DBI
     COMPONENT("llc-dbi", CmpLLCDBI)
     COMPONENT("llc-awb", CmpLLCwAWB)
+    COMPONENT("dcp-dbi", CmpDCPDBI)
+
+    // On-chip network
+    COMPONENT("interconnect", CmpInterconnect)
 
     // DRAMSim
+#ifdef DRAMSIM
     COMPONENT("dramsim", CmpDRAMSim)
+#endif
     
   COMPONENT_LIST_END
 }
@@ -0,0 +1,185 @@
+// -----------------------------------------------------------------------------
+// File: DRAMAddressMapping.h
+// Description:
+//    Defines the mapping of memory addresses to DRAM channels, ranks, banks,
+//    rows and columns. Supported schemes (address-mapping parameter):
+//
+//    row-rank-bank-channel-column : a row sized chunk of consecutive
+//                                   addresses maps to one row. consecutive
+//                                   chunks go to different channels, then
+//                                   banks, then ranks
+//    cache-line                   : consecutive cache lines go to different
+//                                   channels, then fill a row
+//    xor                          : row-rank-bank-channel-column, with the
+//                                   bank index XORed with the low order row
+//                                   bits (permutation based interleaving)
+// -----------------------------------------------------------------------------
+
+#ifndef __DRAM_ADDRESS_MAPPING_H__
+#define __DRAM_ADDRESS_MAPPING_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+
+// -----------------------------------------------------------------------------
+// Structure: DRAMAddress
+// Description:
+//    Location of an address in the DRAM system
+// -----------------------------------------------------------------------------
+
+struct DRAMAddress {
+  uint32 channel;
+  uint32 rank;
+  uint32 bank;
+  addr_t row;
+  uint32 column;
+};
+
+
+// -----------------------------------------------------------------------------
+// Class: DRAMAddressMapping
+// Description:
+//    Maps addresses to DRAM locations according to a scheme
+// -----------------------------------------------------------------------------
+
+class DRAMAddressMapping {
+
+  protected:
+
+    enum Scheme {
+      ROW_RANK_BANK_CHANNEL_COLUMN,
+      CACHE_LINE,
+      XOR
+    };
+
+    Scheme _scheme;
+    uint32 _numChannels;
+    uint32 _numRanks;
+    uint32 _numBanks;
+    uint32 _rowSize;
+    uint32 _lineSize;
+
+  public:
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+
+    DRAMAddressMapping() {
+      _scheme = ROW_RANK_BANK_CHANNEL_COLUMN;
+      _numChannels = 1;
+      _numRanks = 1;
+      _numBanks = 8;
+      _rowSize = 8192;
+      _lineSize = 64;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to set up the mapping. Exits on an unknown scheme.
+    // -------------------------------------------------------------------------
+
+    void Initialize(string scheme, uint32 numChannels, uint32 numRanks,
+        uint32 numBanks, uint32 rowSize, uint32 lineSize) {
+
+      _numChannels = numChannels;
+      _numRanks = numRanks;
+      _numBanks = numBanks;
+      _rowSize = rowSize;
+      _lineSize = lineSize;
+
+      if (scheme.compare("row-rank-bank-channel-column") == 0)
+        _scheme = ROW_RANK_BANK_CHANNEL_COLUMN;
+      else if (scheme.compare("cache-line") == 0)
+        _scheme = CACHE_LINE;
+      else if (scheme.compare("xor") == 0)
+        _scheme = XOR;
+      else {
+        fprintf(stderr, "Error: Unknown address mapping `%s'\n",
+            scheme.c_str());
+        exit(-1);
+      }
+
+      if (_scheme == XOR && (_numBanks & (_numBanks - 1)) != 0) {
+        fprintf(stderr, "Error: xor address mapping needs a power of two "
+            "number of banks\n");
+        exit(-1);
+      }
+      if (_scheme == CACHE_LINE && _rowSize % _lineSize != 0) {
+        fprintf(stderr, "Error: row size must be a multiple of the line "
+            "size\n");
+        exit(-1);
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Accessors
+    // -------------------------------------------------------------------------
+
+    uint32 NumChannels() { return _numChannels; }
+    uint32 NumRanks() { return _numRanks; }
+    uint32 NumBanks() { return _numBanks; }
+    uint32 RowSize() { return _rowSize; }
+
+
+    // -------------------------------------------------------------------------
+    // Function to map an address
+    // -------------------------------------------------------------------------
+
+    void Map(addr_t address, DRAMAddress &location) {
+
+      addr_t rest;
+
+      switch (_scheme) {
+
+        case ROW_RANK_BANK_CHANNEL_COLUMN:
+        case XOR:
+          location.column = address % _rowSize;
+          rest = address / _rowSize;
+          location.channel = rest % _numChannels;
+          rest /= _numChannels;
+          location.bank = rest % _numBanks;
+          rest /= _numBanks;
+          location.rank = rest % _numRanks;
+          location.row = rest / _numRanks;
+          if (_scheme == XOR)
+            location.bank ^= (location.row & (_numBanks - 1));
+          break;
+
+        case CACHE_LINE:
+          rest = address / _lineSize;
+          location.channel = rest % _numChannels;
+          rest /= _numChannels;
+          location.column = (rest % (_rowSize / _lineSize)) * _lineSize +
+            address % _lineSize;
+          rest /= (_rowSize / _lineSize);
+          location.bank = rest % _numBanks;
+          rest /= _numBanks;
+          location.rank = rest % _numRanks;
+          location.row = rest / _numRanks;
+          break;
+
+        default:
+          fprintf(stderr, "Error: Unknown address mapping scheme %d\n",
+              _scheme);
+          exit(-1);
+      }
+    }
+};
+
+#endif // __DRAM_ADDRESS_MAPPING_H__
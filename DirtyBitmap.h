@@ -0,0 +1,132 @@
+// -----------------------------------------------------------------------------
+// File: DirtyBitmap.h
+// Description:
+//    This file defines a bitmap whose size is chosen at run time. It is used
+//    to track the dirty blocks of a row in a DBI entry. Scans work on 64-bit
+//    words with count-trailing-zeros and popcount.
+// -----------------------------------------------------------------------------
+
+#ifndef __DIRTY_BITMAP_H__
+#define __DIRTY_BITMAP_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+
+using namespace std;
+
+// -----------------------------------------------------------------------------
+// Class: dirty_bitmap_t
+// Description:
+//    A bitmap of run time size with word-level scans. first() and next()
+//    return size() when there are no more set bits.
+// -----------------------------------------------------------------------------
+
+class dirty_bitmap_t {
+
+protected:
+
+  vector <uint64> _words;
+  uint32 _size;
+
+public:
+
+  // ---------------------------------------------------------------------------
+  // Constructor
+  // ---------------------------------------------------------------------------
+
+  dirty_bitmap_t(uint32 size = 0) {
+    resize(size);
+  }
+
+
+  // ---------------------------------------------------------------------------
+  // Function to set the number of bits. Clears the bitmap
+  // ---------------------------------------------------------------------------
+
+  void resize(uint32 size) {
+    _size = size;
+    _words.assign((size + 63) / 64, 0);
+  }
+
+  uint32 size() const { return _size; }
+
+
+  // ---------------------------------------------------------------------------
+  // Single bit operations
+  // ---------------------------------------------------------------------------
+
+  void set(uint32 i) { _words[i >> 6] |= (1ULL << (i & 63)); }
+  void reset(uint32 i) { _words[i >> 6] &= ~(1ULL << (i & 63)); }
+  bool test(uint32 i) const { return (_words[i >> 6] >> (i & 63)) & 1; }
+  bool operator[] (uint32 i) const { return test(i); }
+
+
+  // ---------------------------------------------------------------------------
+  // Whole bitmap operations
+  // ---------------------------------------------------------------------------
+
+  void reset() {
+    for (uint32 w = 0; w < _words.size(); w ++)
+      _words[w] = 0;
+  }
+
+  bool any() const {
+    for (uint32 w = 0; w < _words.size(); w ++)
+      if (_words[w]) return true;
+    return false;
+  }
+
+  uint32 count() const {
+    uint32 n = 0;
+    for (uint32 w = 0; w < _words.size(); w ++)
+      n += __builtin_popcountll(_words[w]);
+    return n;
+  }
+
+
+  // ---------------------------------------------------------------------------
+  // Function to get the first set bit
+  // ---------------------------------------------------------------------------
+
+  uint32 first() const {
+    if (_words.empty()) return _size;
+    return scan(0, _words[0]);
+  }
+
+
+  // ---------------------------------------------------------------------------
+  // Function to get the first set bit after bit i
+  // ---------------------------------------------------------------------------
+
+  uint32 next(uint32 i) const {
+    i ++;
+    if (i >= _size) return _size;
+    return scan(i >> 6, _words[i >> 6] & (~0ULL << (i & 63)));
+  }
+
+protected:
+
+  // ---------------------------------------------------------------------------
+  // Function to find the first set bit, starting with the remaining bits of
+  // word w and continuing with the words after it
+  // ---------------------------------------------------------------------------
+
+  uint32 scan(uint32 w, uint64 bits) const {
+    while (bits == 0) {
+      if (++ w >= _words.size()) return _size;
+      bits = _words[w];
+    }
+    return (w << 6) + __builtin_ctzll(bits);
+  }
+};
+
+#endif // __DIRTY_BITMAP_H__
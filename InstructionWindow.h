@@ -0,0 +1,227 @@
+// -----------------------------------------------------------------------------
+// File: InstructionWindow.h
+// Description:
+//    Defines the per-core parameters of the trace front ends and a fixed
+//    capacity ring buffer that holds the memory requests currently in the
+//    instruction window of a core.
+// -----------------------------------------------------------------------------
+
+#ifndef __INSTRUCTION_WINDOW_H__
+#define __INSTRUCTION_WINDOW_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "MemoryRequest.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+using namespace std;
+
+
+// -----------------------------------------------------------------------------
+// Structure: CoreParameters
+// Description:
+//    Parameters of a single core. A load queue or store buffer size of 0
+//    means that the structure does not limit the window.
+// -----------------------------------------------------------------------------
+
+struct CoreParameters {
+
+  // size of the reorder buffer in instructions
+  uint32 robSize;
+  // instructions issued/retired per cycle
+  uint32 width;
+  // maximum number of loads in the window
+  uint32 loadQueueSize;
+  // maximum number of stores in the window
+  uint32 storeBufferSize;
+  // branch mispredictions per kilo instruction (interval model)
+  double branchMPKI;
+  // cycles lost per branch misprediction (interval model)
+  uint32 branchPenalty;
+
+  CoreParameters() {
+    robSize = 1;
+    width = 1;
+    loadQueueSize = 0;
+    storeBufferSize = 0;
+    branchMPKI = 0;
+    branchPenalty = 15;
+  }
+};
+
+
+// -----------------------------------------------------------------------------
+// Function to parse a comma separated list of per-core values. A single value
+// applies to all cores.
+// -----------------------------------------------------------------------------
+
+template <class T>
+void ParseCoreValues(string str, vector <T> &values) {
+  string::size_type index = 0;
+  string::size_type next = str.find_first_of(",", index);
+  values.clear();
+  while (next != string::npos) {
+    values.push_back((T)atof(str.substr(index, next - index).c_str()));
+    index = next + 1;
+    next = str.find_first_of(",", index);
+  }
+  values.push_back((T)atof(str.substr(index).c_str()));
+}
+
+
+// -----------------------------------------------------------------------------
+// Function to get the value for a core from a parsed list
+// -----------------------------------------------------------------------------
+
+template <class T>
+T CoreValue(const vector <T> &values, uint32 cpuID, double def) {
+  if (values.size() == 0) return (T)def;
+  if (cpuID < values.size()) return values[cpuID];
+  return values.back();
+}
+
+
+// -----------------------------------------------------------------------------
+// Class: RequestWindow
+// Description:
+//    Fixed capacity ring buffer of memory requests in program order. Also
+//    tracks the number of loads and stores that have been issued to the
+//    memory simulator.
+// -----------------------------------------------------------------------------
+
+class RequestWindow {
+
+  protected:
+
+    vector <MemoryRequest *> _entries;
+    uint32 _head;
+    uint32 _count;
+
+    // issued loads and stores in the window
+    uint32 _loads;
+    uint32 _stores;
+
+  public:
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+
+    RequestWindow() {
+      _head = 0;
+      _count = 0;
+      _loads = 0;
+      _stores = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to set the capacity of the window. Must be called when the
+    // window is empty.
+    // -------------------------------------------------------------------------
+
+    void SetCapacity(uint32 capacity) {
+      assert(_count == 0);
+      _entries.resize(capacity, NULL);
+      _head = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Accessors
+    // -------------------------------------------------------------------------
+
+    uint32 size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    bool full() const { return _count == _entries.size(); }
+    uint32 loads() const { return _loads; }
+    uint32 stores() const { return _stores; }
+
+    MemoryRequest *front() const {
+      assert(_count > 0);
+      return _entries[_head];
+    }
+
+    MemoryRequest *back() const {
+      assert(_count > 0);
+      uint32 tail = _head + _count - 1;
+      if (tail >= _entries.size()) tail -= _entries.size();
+      return _entries[tail];
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to append a request to the window
+    // -------------------------------------------------------------------------
+
+    void push_back(MemoryRequest *request) {
+      assert(!full());
+      uint32 tail = _head + _count;
+      if (tail >= _entries.size()) tail -= _entries.size();
+      _entries[tail] = request;
+      _count ++;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to remove the oldest request from the window
+    // -------------------------------------------------------------------------
+
+    void pop_front() {
+      assert(_count > 0);
+      MemoryRequest *request = _entries[_head];
+      if (request -> issued) {
+        if (IsStore(request)) _stores --;
+        else _loads --;
+      }
+      _entries[_head] = NULL;
+      _head ++;
+      if (_head == _entries.size()) _head = 0;
+      _count --;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to account for a request in the window being issued
+    // -------------------------------------------------------------------------
+
+    void MarkIssued(MemoryRequest *request) {
+      if (IsStore(request)) _stores ++;
+      else _loads ++;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to check if the load queue or store buffer prevents the
+    // request from being issued
+    // -------------------------------------------------------------------------
+
+    bool CanIssue(MemoryRequest *request, const CoreParameters &params) const {
+      if (IsStore(request))
+        return (params.storeBufferSize == 0 ||
+            _stores < params.storeBufferSize);
+      return (params.loadQueueSize == 0 || _loads < params.loadQueueSize);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to check if a request occupies the store buffer
+    // -------------------------------------------------------------------------
+
+    static bool IsStore(MemoryRequest *request) {
+      return (request -> type == MemoryRequest::WRITE ||
+          request -> type == MemoryRequest::PARTIALWRITE);
+    }
+};
+
+#endif // __INSTRUCTION_WINDOW_H__
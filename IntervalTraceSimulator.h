@@ -0,0 +1,472 @@
+// -----------------------------------------------------------------------------
+// File: IntervalTraceSimulator.h
+// Description:
+//    Defines a trace simulator that uses interval analysis to model the core.
+//    Between miss events, the core dispatches instructions at its width,
+//    reduced by an analytic branch misprediction penalty. Loads stall the
+//    core only once the reorder buffer fills behind them, so misses that
+//    are issued within the same window overlap. Stores retire into the store
+//    buffer and stall the core only when it is full. The memory simulator is
+//    consulted only for memory requests. The cpi stack splits the cycles
+//    between dispatches into base and branch cycles, and charges stalls to
+//    the causes of the OoO model.
+// -----------------------------------------------------------------------------
+
+
+#ifndef __INTERVAL_TRACE_SIMULATOR_H__
+#define __INTERVAL_TRACE_SIMULATOR_H__
+
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "OoOTraceSimulator.h"
+#include "InstructionWindow.h"
+#include "Types.h"
+
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+#include <string>
+#include <bitset>
+#include <cstdio>
+
+using namespace std;
+
+
+// -----------------------------------------------------------------------------
+// Class: IntervalTraceSimulator
+// Description:
+//    Interval model front end. The event queue holds at most one request per
+//    processor: either the next request to be dispatched (not yet issued) or
+//    the oldest request the processor is stalled on.
+// -----------------------------------------------------------------------------
+
+class IntervalTraceSimulator : public OoOTraceSimulator {
+
+  protected:
+
+    // -------------------------------------------------------------------------
+    // Private members
+    // -------------------------------------------------------------------------
+
+    // interval state for each processor. the load window is the outstanding
+    // window of ProcInfo
+    struct IntervalInfo {
+      // dispatch time of the instruction at ProcInfo::currentIcount
+      double time;
+      // cycles per instruction in the absence of miss events, and the part
+      // of it lost to branch mispredictions
+      double baseCPI;
+      double branchCPI;
+      // next request to be dispatched
+      MemoryRequest *next;
+      // stores that are yet to complete
+      RequestWindow stores;
+      // cycles lost to memory stalls
+      double memoryCycles;
+      double checkpointMemoryCycles;
+      // next icount to report progress
+      uint64 progress;
+      // icount of the last dispatch, stall cycles since then, branch cycles
+      // yet to be charged and the branch cause of the cpi stack
+      uint64 dispatchIcount;
+      cycles_t stallCycles;
+      double branchCycles;
+      uint32 branchCause;
+    };
+
+    vector <IntervalInfo> _intervals;
+
+    bitset <128> _finished;
+    bitset <128> _warmedUp;
+
+    // interval breakdown file
+    FILE *_intervalFile;
+
+
+    // -------------------------------------------------------------------------
+    // Function to compute the dispatch time of an instruction assuming no
+    // further miss events. Instructions older than the current one were
+    // dispatched before it.
+    // -------------------------------------------------------------------------
+
+    double DispatchTime(uint32 cpuID, uint64 icount) {
+      int64 ahead = (int64)icount - (int64)_procs[cpuID].currentIcount;
+      return _intervals[cpuID].time + (double)ahead *
+        _intervals[cpuID].baseCPI;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to stall the processor until a request completes. The stall
+    // starts when the processor reaches the given instruction.
+    // -------------------------------------------------------------------------
+
+    void Stall(uint32 cpuID, MemoryRequest *request, uint64 icount) {
+      IntervalInfo &iv = _intervals[cpuID];
+      double start = DispatchTime(cpuID, icount);
+      if ((double)(request -> currentCycle) > start) {
+        cycles_t stall = request -> currentCycle - (cycles_t)start;
+        AccountStall(_procs[cpuID], request, stall);
+        iv.stallCycles += stall;
+        iv.memoryCycles += request -> currentCycle - start;
+        iv.time = request -> currentCycle;
+        _procs[cpuID].currentIcount = icount;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to charge the cycles since the last dispatch that were not
+    // stalls to the base and branch causes of the cpi stack. Stalls start no
+    // earlier than the last dispatch and end no later than this one.
+    // -------------------------------------------------------------------------
+
+    void AccountDispatch(uint32 cpuID, uint64 icount, cycles_t cycle) {
+      ProcInfo &proc = _procs[cpuID];
+      IntervalInfo &iv = _intervals[cpuID];
+      cycles_t elapsed = cycle - proc.currentCycle;
+      cycles_t busy = elapsed - min(iv.stallCycles, elapsed);
+      if (iv.branchCPI > 0) {
+        iv.branchCycles += (double)(icount - iv.dispatchIcount) *
+          iv.branchCPI;
+        cycles_t branch = min((cycles_t)iv.branchCycles, busy);
+        iv.branchCycles -= branch;
+        proc.cpiStack[iv.branchCause] += branch;
+        busy -= branch;
+      }
+      proc.cpiStack[CPI_BASE] += busy;
+      iv.stallCycles = 0;
+      iv.dispatchIcount = icount;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to issue a heart beat if one is due
+    // -------------------------------------------------------------------------
+
+    void CheckHeartBeat() {
+      if (_hbCount > 0 && _simulator.CurrentCycle() > _nextHeartBeatCycle) {
+        _simulator.HeartBeat(_hbCount);
+        CPIHeartBeat();
+        _nextHeartBeatCycle += _hbCount;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to get the next request of a processor
+    // -------------------------------------------------------------------------
+
+    MemoryRequest *FetchRequest(uint32 cpuID) {
+      MemoryRequest *request;
+      if (_synthetic)
+        request = _procs[cpuID].sreader -> NextRequest();
+      else
+        request = _procs[cpuID].reader -> NextRequest();
+      if (request == NULL) {
+        fprintf(stderr, "No requests from processor %u\n", cpuID);
+        exit(1);
+      }
+      return request;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to run a processor until it has to wait for a request or for
+    // the rest of the system to catch up
+    // -------------------------------------------------------------------------
+
+    void Step(uint32 cpuID) {
+
+      ProcInfo &proc = _procs[cpuID];
+      IntervalInfo &iv = _intervals[cpuID];
+
+      while (true) {
+
+        MemoryRequest *next = iv.next;
+        bool isStore = RequestWindow::IsStore(next);
+
+        // retire loads from the head of the window. a load stalls the
+        // processor only when the window fills behind it
+        while (!proc.outstanding.empty()) {
+          MemoryRequest *head = proc.outstanding.front();
+          uint64 fill = head -> icount + proc.params.robSize;
+          bool blocking = (fill <= next -> icount);
+          if (!isStore && (proc.outstanding.full() ||
+                !proc.outstanding.CanIssue(next, proc.params))) {
+            blocking = true;
+            fill = min(fill, next -> icount);
+          }
+
+          if (!head -> finished) {
+            if (!blocking) break;
+            _queue.push(head);
+            return;
+          }
+
+          // a stall that is yet to happen cannot be accounted for now. a
+          // load that completed before its stall point does not stall
+          if (!blocking) {
+            if ((double)(head -> currentCycle) > DispatchTime(cpuID, fill))
+              break;
+          }
+          else
+            Stall(cpuID, head, fill);
+          proc.outstanding.pop_front();
+          delete head;
+        }
+
+        // retire completed stores and wait if the store buffer is full
+        while (!iv.stores.empty()) {
+          MemoryRequest *head = iv.stores.front();
+          bool blocking = isStore && (iv.stores.full() ||
+              !iv.stores.CanIssue(next, proc.params));
+
+          if (!head -> finished) {
+            if (!blocking) break;
+            _queue.push(head);
+            return;
+          }
+
+          if (blocking)
+            Stall(cpuID, head, next -> icount);
+          iv.stores.pop_front();
+          delete head;
+        }
+
+        // wait for the rest of the system to reach the dispatch time, unless
+        // the dispatch is the earliest event. then the request is issued
+        // ahead of the memory simulator, which advances to it, as in the OoO
+        // model. this saves a pass over the components for each request
+        double dispatch = DispatchTime(cpuID, next -> icount);
+        cycles_t cycle = (cycles_t)dispatch;
+        if (cycle > _simulator.CurrentCycle()) {
+          next -> currentCycle = cycle;
+          if ((_finished.test(cpuID) && _finished.count() == _numCPUs) ||
+              (!_queue.empty() && _queue.top() -> currentCycle <= cycle)) {
+            _queue.push(next);
+            return;
+          }
+          CheckHeartBeat();
+        }
+
+        // dispatch the request
+        AccountDispatch(cpuID, next -> icount, cycle);
+        iv.time = dispatch;
+        proc.currentIcount = next -> icount;
+        proc.currentCycle = cycle;
+        next -> issueCycle = next -> currentCycle = cycle;
+        _simulator.ProcessMemoryRequest(next);
+        if (isStore) {
+          iv.stores.push_back(next);
+          iv.stores.MarkIssued(next);
+        }
+        else {
+          proc.outstanding.push_back(next);
+          proc.outstanding.MarkIssued(next);
+        }
+        iv.next = FetchRequest(cpuID);
+
+        if (proc.currentIcount > iv.progress) {
+          fprintf(_progress, "P%u, %llu\n", cpuID, iv.progress/PROGRESS_LEAP);
+          fflush(_progress);
+          iv.progress += PROGRESS_LEAP;
+        }
+
+        // check if the processor has reached a milestone
+        while (!_finished.test(cpuID) &&
+            proc.currentIcount > _milestones[_mIndex[cpuID]].first) {
+
+          switch (_milestones[_mIndex[cpuID]].second) {
+
+            case WARM_UP:
+              proc.checkpointIcount = proc.currentIcount;
+              proc.checkpointCycle = proc.currentCycle;
+              proc.cpiCheckpoint = proc.cpiStack;
+              iv.checkpointMemoryCycles = iv.memoryCycles;
+              _mIndex[cpuID] ++;
+              _warmedUp.set(cpuID);
+              _simulator.EndProcWarmUp(cpuID);
+              if (_warmedUp.count() == _numCPUs)
+                _simulator.EndWarmUp();
+              break;
+
+            case END_SIMULATION:
+              proc.finishIcount = proc.currentIcount;
+              proc.finishCycle = proc.currentCycle;
+              _finished.set(cpuID);
+              _simulator.EndProcSimulation(cpuID);
+              EndProcessor(cpuID);
+              break;
+          }
+        }
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to record the results of a processor
+    // -------------------------------------------------------------------------
+
+    void EndProcessor(uint32 cpuID) {
+      ProcInfo &proc = _procs[cpuID];
+      IntervalInfo &iv = _intervals[cpuID];
+      uint64 instructions = proc.finishIcount - proc.checkpointIcount;
+      cycles_t cycles = proc.finishCycle - proc.checkpointCycle;
+
+      fprintf(_ipcFile, "%u %llu %llu\n", cpuID, instructions, cycles);
+      fflush(_ipcFile);
+
+      // cpu, instructions, cycles, base, branch and memory components
+      double branch = instructions * proc.params.branchMPKI *
+        proc.params.branchPenalty / 1000.0;
+      double memory = iv.memoryCycles - iv.checkpointMemoryCycles;
+      fprintf(_intervalFile, "%u %llu %llu %.0lf %.0lf %.0lf\n", cpuID,
+          instructions, cycles, (double)instructions / proc.params.width,
+          branch, memory);
+      fflush(_intervalFile);
+
+      WriteCPIStack(_cpiFile, "", cpuID, proc.cpiCheckpoint, instructions);
+      fflush(_cpiFile);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Simulate Function
+    // -------------------------------------------------------------------------
+
+    void Simulate() {
+
+      MemoryRequest *request;
+
+      // until all processors have finished
+      while (_finished.count() < _numCPUs) {
+
+        if (_queue.empty()) {
+          fprintf(stderr, "Error: No events in the interval simulator\n");
+          return;
+        }
+
+        CheckHeartBeat();
+
+        request = _queue.top();
+        _queue.pop();
+
+        // the processor is waiting to dispatch the request
+        if (!request -> issued) {
+          _simulator.AdvanceSimulation(request -> currentCycle);
+          Step(request -> cpuID);
+          continue;
+        }
+
+        // the processor is stalled on the request
+        if (!request -> stalling)
+          _simulator.AdvanceSimulation(request -> currentCycle);
+        else
+          _simulator.AutoAdvance();
+
+        if (!(request -> finished))
+          _queue.push(request);
+        else
+          Step(request -> cpuID);
+      }
+    }
+
+  public:
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+
+    IntervalTraceSimulator(uint32 numCPUs, string simulatorDefinition,
+        string simulatorConfiguration, const vector <CoreParameters> &cores,
+        const vector <string> &traceFiles, string simulationFolder,
+        bool synthetic, uint32 workingSetSize, uint32 memGap) :
+      OoOTraceSimulator(numCPUs, simulatorDefinition, simulatorConfiguration,
+          cores, traceFiles, simulationFolder, synthetic, workingSetSize,
+          memGap) {
+
+      _intervals.resize(_numCPUs);
+      for (uint32 i = 0; i < _numCPUs; i ++) {
+        CoreParameters &params = _procs[i].params;
+        _intervals[i].time = 0;
+        _intervals[i].branchCPI = params.branchMPKI * params.branchPenalty /
+          1000.0;
+        _intervals[i].baseCPI = 1.0 / params.width + _intervals[i].branchCPI;
+        _intervals[i].next = NULL;
+        // without a store buffer limit, stores are bounded by the window
+        _intervals[i].stores.SetCapacity(params.storeBufferSize > 0 ?
+            params.storeBufferSize : params.robSize + 1);
+        _intervals[i].memoryCycles = 0;
+        _intervals[i].checkpointMemoryCycles = 0;
+        _intervals[i].progress = 0;
+        _intervals[i].dispatchIcount = 0;
+        _intervals[i].stallCycles = 0;
+        _intervals[i].branchCycles = 0;
+      }
+      _finished.reset();
+      _warmedUp.reset();
+
+      string intervalFilename = _simulationFolder + "/sim.interval";
+      _intervalFile = fopen(intervalFilename.c_str(), "w");
+      if (_intervalFile == NULL)
+        _intervalFile = stdout;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to start the simulation
+    // -------------------------------------------------------------------------
+
+    void StartSimulation() {
+
+      // start the simulator
+      _simulator.SetStartCycle(0);
+      _simulator.StartSimulation();
+
+      // the interval model adds a branch cause to the cpi stack
+      StartCPIStacks();
+      for (uint32 i = 0; i < _numCPUs; i ++) {
+        _intervals[i].branchCause = _cpiNames[i].size();
+        _cpiNames[i].push_back("branch");
+        _procs[i].cpiStack.assign(_cpiNames[i].size(), 0);
+        _procs[i].cpiCheckpoint = _procs[i].cpiStack;
+        _procs[i].cpiHeartBeat = _procs[i].cpiStack;
+      }
+
+      // open the trace readers
+      for (uint32 i = 0; i < _numCPUs; i ++) {
+        if (!_synthetic)
+          _procs[i].reader = new TraceReader(_traceFiles[i], i, true);
+        else
+          _procs[i].sreader = new SyntheticTrace(_workingSetSize, _memGap, i);
+      }
+
+      // queue the first request of each processor for dispatch
+      for (uint32 i = 0; i < _numCPUs; i ++) {
+        _procs[i].currentIcount = 0;
+        _procs[i].currentCycle = 0;
+        _intervals[i].next = FetchRequest(i);
+        _intervals[i].next -> currentCycle = 0;
+        _queue.push(_intervals[i].next);
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to run the simulation
+    // -------------------------------------------------------------------------
+
+    void RunSimulation(uint64 warmUp, uint64 mainRun, uint64 hbCount) {
+      OoOTraceSimulator::RunSimulation(warmUp, mainRun, hbCount);
+      fclose(_intervalFile);
+    }
+};
+
+#endif // __INTERVAL_TRACE_SIMULATOR_H__
@@ -0,0 +1,644 @@
+// -----------------------------------------------------------------------------
+// File: LLCEngine.h
+// Description:
+//    Defines the core of a last-level cache that LLC components share. The
+//    read, writeback and insertion paths call hooks that the component, or
+//    a stack of hook modules, overrides. Hooks are resolved at compile time
+//    through the Derived type, so the default hooks cost nothing.
+//
+//    The cache can be split into slices, each with its own tag port, so that
+//    accesses to different slices proceed in parallel. A slice is selected by
+//    a hash of the block address. Cores and slices sit on the tiles of a
+//    mesh, and an access pays the hop latency to its slice and back.
+// -----------------------------------------------------------------------------
+
+#ifndef __LLC_ENGINE_H__
+#define __LLC_ENGINE_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "MemoryComponent.h"
+#include "Types.h"
+#include "GenericTagStore.h"
+#include "PrefetchAccounting.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Structure: LLCTagEntry
+// Description:
+//    Fields of a tag entry that the engine uses. Hook modules that keep per
+//    block state extend it.
+// -----------------------------------------------------------------------------
+
+struct LLCTagEntry {
+  bool dirty;
+  addr_t vcla;
+  addr_t pcla;
+  uint32 appID;
+  PrefetchTag prefetch;
+  LLCTagEntry() { dirty = false; }
+};
+
+
+// -----------------------------------------------------------------------------
+// Class: CmpLLCEngine
+// Description:
+//    Last-level cache core. Derived is the final component class and Entry
+//    its tag entry type. Hook points:
+//
+//    AddHookParameter, InitializeHookStatistics, StartHooks,
+//    LogHookStatistics - component plumbing for hook modules
+//    BlockTag        - tag of a block from its virtual and physical address
+//    OnAccess        - every read or prefetch, before the lookup
+//    SkipLookup      - send a read below without a tag lookup
+//    LookupAndPromote - tag lookup. updates the replacement state on a hit
+//    OnHit, OnMiss   - outcome of the lookup
+//    Drop            - service a missing read without sending it below
+//    OtherRequest    - requests other than reads and writebacks
+//    MarkDirty       - writeback to a present block (dirty tracking)
+//    IsDirty         - whether an evicted block needs a writeback. Modules
+//                      that track dirty blocks clear the block's state here
+//    Bypass          - skip inserting a returning block
+//    SelectVictim    - choose the victim of an insert, or skip the insert
+//    InsertionPriority - replacement priority of an inserted block
+//    OnInsert        - fill in a new tag entry before it is inserted
+//    OnEvict         - a tag entry that leaves the cache
+//    OnOwnReturn     - return of a request that the component created
+// -----------------------------------------------------------------------------
+
+template <class Derived, class Entry = LLCTagEntry>
+class CmpLLCEngine : public MemoryComponent {
+
+protected:
+
+  typedef Entry TagEntry;
+  typedef typename table_t <addr_t, TagEntry>::entry TagTableEntry;
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  uint32 _size;
+  uint32 _blockSize;
+  uint32 _associativity;
+  string _policy;
+  uint32 _policyVal;
+
+  uint32 _tagStoreLatency;
+  uint32 _dataStoreLatency;
+
+  uint32 _numSlices;
+  string _sliceHash;
+  uint32 _meshWidth;
+  uint32 _hopLatency;
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  // tag store
+  uint32 _numSets;
+  generic_tagstore_t <addr_t, TagEntry> _tags;
+  policy_value_t _pval;
+
+  // state of a slice
+  struct Slice {
+    // cycle at which the tag port is free
+    cycles_t busyUntil;
+  };
+
+  vector <Slice> _slices;
+  vector <uint64> _sliceAccesses;
+  uint32 _sliceBits;
+
+  // hops from each core to each slice
+  vector <vector <uint32> > _hops;
+
+  // prefetch accounting
+  PrefetchAccounting _prefAccounting;
+
+  // -------------------------------------------------------------------------
+  // Declare Counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(accesses);
+  NEW_COUNTER(reads);
+  NEW_COUNTER(writebacks);
+  NEW_COUNTER(misses);
+  NEW_COUNTER(evictions);
+  NEW_COUNTER(dirty_evictions);
+  NEW_COUNTER(slice_conflicts);
+  NEW_COUNTER(slice_wait_cycles);
+  NEW_COUNTER(nuca_cycles);
+
+  Derived *Self() { return static_cast <Derived *> (this); }
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor. It cannot take any arguments
+  // -------------------------------------------------------------------------
+
+  CmpLLCEngine() {
+    _size = 1024;
+    _blockSize = 64;
+    _associativity = 16;
+    _tagStoreLatency = 6;
+    _dataStoreLatency = 15;
+    _policy = "lru";
+    _policyVal = 0;
+    _numSlices = 1;
+    _sliceHash = "mod";
+    _meshWidth = 0;
+    _hopLatency = 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Virtual functions to be implemented by the components
+  // -------------------------------------------------------------------------
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter to the component
+  // -------------------------------------------------------------------------
+
+  void AddParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      // Add the list of parameters to the component here
+      CMP_PARAMETER_UINT("size", _size)
+      CMP_PARAMETER_UINT("block-size", _blockSize)
+      CMP_PARAMETER_UINT("associativity", _associativity)
+      CMP_PARAMETER_STRING("policy", _policy)
+      CMP_PARAMETER_UINT("policy-value", _policyVal)
+      CMP_PARAMETER_UINT("tag-store-latency", _tagStoreLatency)
+      CMP_PARAMETER_UINT("data-store-latency", _dataStoreLatency)
+      CMP_PARAMETER_UINT("slices", _numSlices)
+      CMP_PARAMETER_STRING("slice-hash", _sliceHash)
+      CMP_PARAMETER_UINT("mesh-width", _meshWidth)
+      CMP_PARAMETER_UINT("hop-latency", _hopLatency)
+      else if (_prefAccounting.AddParameter(pname, pvalue)) {}
+      else if (Self() -> AddHookParameter(pname, pvalue)) {}
+
+    CMP_PARAMETER_END
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to initialize statistics
+  // -------------------------------------------------------------------------
+
+  void InitializeStatistics() {
+
+    INITIALIZE_COUNTER(accesses, "Total Accesses")
+    INITIALIZE_COUNTER(reads, "Read Accesses")
+    INITIALIZE_COUNTER(writebacks, "Writeback Accesses")
+    INITIALIZE_COUNTER(misses, "Total Misses")
+    INITIALIZE_COUNTER(evictions, "Evictions")
+    INITIALIZE_COUNTER(dirty_evictions, "Dirty Evictions")
+    INITIALIZE_COUNTER(slice_conflicts, "Accesses that waited for a slice")
+    INITIALIZE_COUNTER(slice_wait_cycles, "Cycles spent waiting for a slice")
+    INITIALIZE_COUNTER(nuca_cycles, "Cycles spent crossing to a slice")
+    if (_numSlices > 1)
+      INITIALIZE_VECTOR_COUNTER(_sliceAccesses, "slice_accesses",
+                                "Accesses of each slice")
+
+    Self() -> InitializeHookStatistics();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation starts
+  // -------------------------------------------------------------------------
+
+  void StartSimulation() {
+
+    // compute number of sets
+    _numSets = (_size * 1024) / (_blockSize * _associativity);
+    _tags.SetTagStoreParameters(_numSets, _associativity, _policy);
+
+    switch (_policyVal) {
+    case 0: _pval = POLICY_HIGH; break;
+    case 1: _pval = POLICY_BIMODAL; break;
+    case 2: _pval = POLICY_LOW; break;
+    default:
+      fprintf(stderr, "Error: Unknown policy value %u for `%s'\n",
+              _policyVal, _name.c_str());
+      exit(-1);
+    }
+
+    StartSlices();
+    _prefAccounting.Start(_numCPUs, _numSets, _associativity);
+
+    Self() -> StartHooks();
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called at a heart beat. Argument indicates cycles elapsed after
+  // previous heartbeat
+  // -------------------------------------------------------------------------
+
+  void HeartBeat(cycles_t hbCount) {
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Prefetch filter queries
+  // -------------------------------------------------------------------------
+
+  bool IsCache() {
+    return true;
+  }
+
+  bool HoldsBlock(addr_t vaddr, addr_t paddr) {
+    return _tags.lookup(Self() -> BlockTag(vaddr, paddr));
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the address the cache indexes a block by
+  // -------------------------------------------------------------------------
+
+  addr_t IndexAddress(addr_t vaddr, addr_t paddr) {
+    return Self() -> BlockTag(vaddr, paddr) * _blockSize;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when warm up ends
+  // -------------------------------------------------------------------------
+
+  void EndWarmUp() {
+    MemoryComponent::EndWarmUp();
+    fill(_sliceAccesses.begin(), _sliceAccesses.end(), 0);
+    _prefAccounting.Reset(*_simulatorCycle);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when simulation ends
+  // -------------------------------------------------------------------------
+
+  void EndSimulation() {
+    DUMP_STATISTICS;
+    Self() -> LogHookStatistics();
+    _prefAccounting.Write(_simulationFolderName + "/" + _name +
+                          ".prefetch-accounting");
+    CLOSE_ALL_LOGS;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Default hooks
+  // -------------------------------------------------------------------------
+
+  bool AddHookParameter(string pname, string pvalue) { return false; }
+  void InitializeHookStatistics() {}
+  void StartHooks() {}
+  void LogHookStatistics() {}
+
+  addr_t BlockTag(addr_t vaddr, addr_t paddr) {
+    return vaddr / _blockSize;
+  }
+
+  void OnAccess(MemoryRequest *request) {
+    INCREMENT(reads);
+  }
+
+  bool SkipLookup(MemoryRequest *request, addr_t ctag, cycles_t &busyCycles) {
+    return false;
+  }
+
+  bool LookupAndPromote(MemoryRequest *request, addr_t ctag) {
+    return _tags.read(ctag).valid;
+  }
+
+  void OnHit(MemoryRequest *request, addr_t ctag) {}
+
+  void OnMiss(MemoryRequest *request, addr_t ctag) {
+    INCREMENT(misses);
+  }
+
+  bool Drop(MemoryRequest *request, addr_t ctag) { return false; }
+
+  cycles_t OtherRequest(MemoryRequest *request, addr_t ctag,
+                        cycles_t busyCycles) {
+    return 0;
+  }
+
+  void MarkDirty(MemoryRequest *request, addr_t ctag) {
+    _tags[ctag].dirty = true;
+  }
+
+  bool IsDirty(MemoryRequest *request, TagTableEntry &victim) {
+    return victim.value.dirty;
+  }
+
+  bool Bypass(MemoryRequest *request, addr_t ctag) { return false; }
+
+  // a module that evicts a block itself invalidates it and returns it in
+  // victim. returning false skips the insert
+  bool SelectVictim(MemoryRequest *request, addr_t ctag,
+                    TagTableEntry &victim) {
+    return true;
+  }
+
+  policy_value_t InsertionPriority(MemoryRequest *request, addr_t ctag) {
+    return _pval;
+  }
+
+  void OnInsert(MemoryRequest *request, addr_t ctag, TagEntry &entry,
+                policy_value_t priority) {}
+  void OnEvict(MemoryRequest *request, TagTableEntry &victim) {}
+  void OnOwnReturn(MemoryRequest *request) {}
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to process a request. Return value indicates number of busy
+  // cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessRequest(MemoryRequest *request) {
+
+    // update stats
+    INCREMENT(accesses);
+
+    // NO WRITES (Complete or partial)
+    if (request -> type == MemoryRequest::WRITE ||
+        request -> type == MemoryRequest::PARTIALWRITE) {
+      fprintf(stderr, "LLC cannot handle direct writes (yet)\n");
+      exit(0);
+    }
+
+    // compute the cache block tag
+    addr_t ctag = Self() -> BlockTag(VADDR(request), PADDR(request));
+
+    // get the tag port
+    cycles_t busyCycles = ReserveSlice(request, ctag);
+    bool hit;
+
+    // check if its a read or write back
+    switch (request -> type) {
+
+    // READ request
+    case MemoryRequest::READ:
+    case MemoryRequest::READ_FOR_WRITE:
+    case MemoryRequest::PREFETCH:
+
+      Self() -> OnAccess(request);
+
+      if (Self() -> SkipLookup(request, ctag, busyCycles))
+        hit = false;
+      else if ((hit = Self() -> LookupAndPromote(request, ctag))) {
+        request -> serviced = true;
+        request -> AddLatency(_tagStoreLatency + _dataStoreLatency);
+        Self() -> OnHit(request, ctag);
+      }
+      else if (Self() -> Drop(request, ctag)) {
+        request -> serviced = true;
+        return busyCycles;
+      }
+      else {
+        request -> AddLatency(_tagStoreLatency);
+        Self() -> OnMiss(request, ctag);
+      }
+
+      if (_prefAccounting.Enabled() &&
+          request -> type != MemoryRequest::PREFETCH)
+        _prefAccounting.Demand(request, ctag,
+                               hit ? &_tags[ctag].prefetch : NULL);
+
+      return busyCycles;
+
+    // WRITEBACK request
+    case MemoryRequest::WRITEBACK:
+
+      INCREMENT(writebacks);
+
+      // a writeback that is not inserted goes below
+      if (_tags.lookup(ctag))
+        Self() -> MarkDirty(request, ctag);
+      else if (!INSERT_BLOCK(ctag, true, request))
+        return busyCycles;
+
+      request -> serviced = true;
+      return busyCycles;
+
+    default:
+      return Self() -> OtherRequest(request, ctag, busyCycles);
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to process the return of a request. Return value indicates
+  // number of busy cycles for the component.
+  // -------------------------------------------------------------------------
+
+  cycles_t ProcessReturn(MemoryRequest *request) {
+
+    // if its a writeback from this component, delete it
+    if (request -> iniType == MemoryRequest::COMPONENT &&
+        request -> iniPtr == this) {
+      Self() -> OnOwnReturn(request);
+      request -> destroy = true;
+      return 0;
+    }
+
+    // get the cache block tag
+    addr_t ctag = Self() -> BlockTag(VADDR(request), PADDR(request));
+
+    // if the block is already present, return
+    if (_tags.lookup(ctag)) {
+      if (_prefAccounting.Enabled())
+        _prefAccounting.Return(request, _tags[ctag].prefetch);
+      return 0;
+    }
+
+    if (Self() -> Bypass(request, ctag))
+      return 0;
+
+    INSERT_BLOCK(ctag, false, request);
+
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to set up the slices and the hop counts of the mesh. Core c
+  // sits on the tile of slice c % slices.
+  // -------------------------------------------------------------------------
+
+  void StartSlices() {
+
+    if (_numSlices == 0 || (_numSlices & (_numSlices - 1)) != 0) {
+      fprintf(stderr, "Error: `%s' needs a power of two slices\n",
+              _name.c_str());
+      exit(-1);
+    }
+    if (_sliceHash.compare("mod") != 0 && _sliceHash.compare("xor") != 0) {
+      fprintf(stderr, "Error: Unknown slice hash `%s' for `%s'\n",
+              _sliceHash.c_str(), _name.c_str());
+      exit(-1);
+    }
+
+    _sliceBits = 0;
+    while ((1U << _sliceBits) < _numSlices) _sliceBits ++;
+
+    Slice slice;
+    slice.busyUntil = 0;
+    _slices.assign(_numSlices, slice);
+    _sliceAccesses.assign(_numSlices, 0);
+
+    uint32 width = _meshWidth;
+    if (width == 0)
+      while (width * width < _numSlices) width ++;
+
+    _hops.assign(_numCPUs, vector <uint32> (_numSlices, 0));
+    for (uint32 c = 0; c < _numCPUs; c ++) {
+      uint32 tile = c % _numSlices;
+      for (uint32 s = 0; s < _numSlices; s ++) {
+        int32 dx = (int32)(tile % width) - (int32)(s % width);
+        int32 dy = (int32)(tile / width) - (int32)(s / width);
+        _hops[c][s] = abs(dx) + abs(dy);
+      }
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the slice of a block
+  // -------------------------------------------------------------------------
+
+  uint32 SliceIndex(addr_t ctag) {
+    if (_sliceHash.compare("mod") == 0)
+      return ctag & (_numSlices - 1);
+
+    // fold all the tag bits into the slice index
+    addr_t index = 0;
+    for (; ctag != 0; ctag >>= _sliceBits)
+      index ^= ctag & (_numSlices - 1);
+    return index;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to reserve the tag port for a request. Returns the busy cycles
+  // of the component. With one slice the component is the port. Otherwise
+  // the request travels to its slice, waits for the port and travels back,
+  // and the component is free for requests to other slices.
+  // -------------------------------------------------------------------------
+
+  cycles_t ReserveSlice(MemoryRequest *request, addr_t ctag) {
+
+    if (_numSlices == 1)
+      return _tagStoreLatency;
+
+    uint32 index = SliceIndex(ctag);
+    Slice &slice = _slices[index];
+    _sliceAccesses[index] ++;
+
+    cycles_t now = request -> currentCycle;
+    cycles_t travel = _hops[request -> cpuID][index] * _hopLatency;
+    cycles_t arrival = now + travel;
+    cycles_t start = max(arrival, slice.busyUntil);
+    slice.busyUntil = start + _tagStoreLatency;
+
+    if (start > arrival) {
+      INCREMENT(slice_conflicts);
+      ADD_TO_COUNTER(slice_wait_cycles, start - arrival);
+    }
+    ADD_TO_COUNTER(nuca_cycles, 2 * travel);
+
+    request -> AddLatency(start - now + travel);
+    return 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to create a request of this component on behalf of a request
+  // -------------------------------------------------------------------------
+
+  MemoryRequest *NewRequest(MemoryRequest::Type type, MemoryRequest *request,
+                            addr_t vcla, addr_t pcla) {
+    MemoryRequest *created =
+      new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
+                        type, request -> cmpID, vcla, pcla, _blockSize,
+                        request -> currentCycle);
+    created -> icount = request -> icount;
+    created -> ip = request -> ip;
+    return created;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to remove a present block other than through a replacement.
+  // It is not counted as an eviction, and the caller writes it back if
+  // needed
+  // -------------------------------------------------------------------------
+
+  TagTableEntry InvalidateBlock(MemoryRequest *request, addr_t ctag) {
+    TagTableEntry tagentry = _tags.invalidate(ctag);
+    if (_prefAccounting.Enabled())
+      _prefAccounting.Evict(tagentry.key, tagentry.value.prefetch, request);
+    Self() -> OnEvict(request, tagentry);
+    return tagentry;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to insert a block into the cache. The entry is filled in before
+  // the insert so that the tag store is searched once. Returns false if the
+  // block is not inserted
+  // -------------------------------------------------------------------------
+
+  bool INSERT_BLOCK(addr_t ctag, bool dirty, MemoryRequest *request) {
+
+    TagTableEntry victim;
+    if (!Self() -> SelectVictim(request, ctag, victim))
+      return false;
+
+    TagEntry entry;
+    entry.vcla = BLOCK_ADDRESS(VADDR(request), _blockSize);
+    entry.pcla = BLOCK_ADDRESS(PADDR(request), _blockSize);
+    entry.dirty = dirty;
+    entry.appID = request -> cpuID;
+    if (_prefAccounting.Enabled())
+      _prefAccounting.Fill(request, entry.prefetch);
+    policy_value_t priority = Self() -> InsertionPriority(request, ctag);
+    Self() -> OnInsert(request, ctag, entry, priority);
+
+    // insert the block into the cache
+    TagTableEntry tagentry = _tags.insert(ctag, entry, priority);
+    if (!tagentry.valid)
+      tagentry = victim;
+
+    // if the evicted tag entry is valid
+    if (tagentry.valid) {
+      INCREMENT(evictions);
+      if (_prefAccounting.Enabled())
+        _prefAccounting.Evict(tagentry.key, tagentry.value.prefetch, request);
+      Self() -> OnEvict(request, tagentry);
+
+      if (Self() -> IsDirty(request, tagentry)) {
+        INCREMENT(dirty_evictions);
+        SendToNextComponent(NewRequest(MemoryRequest::WRITEBACK, request,
+                                       tagentry.value.vcla,
+                                       tagentry.value.pcla));
+      }
+    }
+    return true;
+  }
+};
+
+#endif // __LLC_ENGINE_H__
@@ -0,0 +1,369 @@
+// -----------------------------------------------------------------------------
+// File: LLCHooks.h
+// Description:
+//    Hook modules for the LLC engine (LLCEngine.h). A module is a class
+//    template over the layer below it. It overrides some hooks and forwards
+//    to Base for the rest, so modules stack:
+//
+//      class CmpX : public ModuleA <ModuleB <CmpLLCEngine <CmpX, Entry> > >
+//
+//    Entry must provide the fields that each module in the stack uses. The
+//    modules shared by several components are here. A module of a single
+//    mechanism is in the file of its component.
+// -----------------------------------------------------------------------------
+
+#ifndef __LLC_HOOKS_H__
+#define __LLC_HOOKS_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "LLCEngine.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+
+// -----------------------------------------------------------------------------
+// Members of the engine and the component that modules use. Names in a
+// dependent base are not visible in a template without these.
+// -----------------------------------------------------------------------------
+
+#define LLC_HOOK_MODULE_MEMBERS(Base) \
+  typedef typename Base::TagEntry TagEntry;\
+  typedef typename Base::TagTableEntry TagTableEntry;\
+  typedef typename Base::Stats Stats;\
+  using Base::_tags;\
+  using Base::_numSets;\
+  using Base::_blockSize;\
+  using Base::_associativity;\
+  using Base::_policy;\
+  using Base::_pval;\
+  using Base::_tagStoreLatency;\
+  using Base::_numSlices;\
+  using Base::_numCPUs;\
+  using Base::_done;\
+  using Base::_stats;\
+  using Base::_statsRegistry;\
+  using Base::_simulationLog;\
+  using Base::_simulationFolderName;\
+  using Base::_logs;\
+  using Base::_name;\
+  using Base::_currentCycle;\
+  using Base::accesses;\
+  using Base::reads;\
+  using Base::misses;\
+  using Base::evictions;\
+  using Base::Self;\
+  using Base::NewRequest;\
+  using Base::InvalidateBlock;\
+  using Base::SendToNextComponent;\
+  using Base::AddRequest;
+
+
+// -----------------------------------------------------------------------------
+// Class: LLCPhysicalTags
+// Description:
+//    Tags blocks by their physical address
+// -----------------------------------------------------------------------------
+
+template <class Base>
+class LLCPhysicalTags : public Base {
+
+protected:
+
+  LLC_HOOK_MODULE_MEMBERS(Base)
+
+public:
+
+  addr_t BlockTag(addr_t vaddr, addr_t paddr) {
+    return paddr / _blockSize;
+  }
+};
+
+
+// -----------------------------------------------------------------------------
+// Structure: LLCAppTagEntry
+// Description:
+//    Tag entry for the occupancy monitor and the ip-based predictors. ip is
+//    the instruction that inserted the block
+// -----------------------------------------------------------------------------
+
+struct LLCAppTagEntry : public LLCTagEntry {
+  addr_t ip;
+  bool reused;
+  LLCAppTagEntry() { reused = false; }
+};
+
+
+// -----------------------------------------------------------------------------
+// Class: LLCOccupancyMonitor
+// Description:
+//    Counts the blocks of each application in the cache. With more than one
+//    application, the counts are written to the occupancy log at each heart
+//    beat.
+// -----------------------------------------------------------------------------
+
+template <class Base>
+class LLCOccupancyMonitor : public Base {
+
+protected:
+
+  LLC_HOOK_MODULE_MEMBERS(Base)
+
+  vector <uint32> _occupancy;
+
+public:
+
+  void StartHooks() {
+    Base::StartHooks();
+    _occupancy.resize(_numCPUs, 0);
+
+    // create the occupancy log file
+    NEW_LOG_FILE("occupancy", "occupancy");
+  }
+
+  void HeartBeat(cycles_t hbCount) {
+    Base::HeartBeat(hbCount);
+
+    // if there are more than one apps, then print occupancy
+    if (_numCPUs > 1) {
+      LOG("occupancy", "%llu ", _currentCycle);
+      for (uint32 i = 0; i < _numCPUs; i ++)
+        LOG("occupancy", "%u ", _occupancy[i]);
+      LOG("occupancy", "\n");
+    }
+  }
+
+  void OnInsert(MemoryRequest *request, addr_t ctag, TagEntry &entry,
+                policy_value_t priority) {
+    Base::OnInsert(request, ctag, entry, priority);
+    _occupancy[request -> cpuID] ++;
+  }
+
+  void OnEvict(MemoryRequest *request, TagTableEntry &victim) {
+    Base::OnEvict(request, victim);
+    _occupancy[victim.value.appID] --;
+  }
+};
+
+
+// -----------------------------------------------------------------------------
+// Structure: LLCPrefetchTagEntry
+// Description:
+//    Tag entry for the prefetch monitor. Modules that insert prefetches at
+//    low priority mark them in lowPriority
+// -----------------------------------------------------------------------------
+
+struct LLCPrefetchTagEntry : public LLCTagEntry {
+
+  enum PrefetchState {
+    NOT_PREFETCHED,
+    PREFETCHED_UNUSED,
+    PREFETCHED_USED,
+    PREFETCHED_REUSED,
+  };
+
+  // prefetch related info
+  PrefetchState prefState;
+  uint32 prefID;
+  bool lowPriority;
+
+  // miss counter information
+  uint32 prefetchMiss;
+  uint32 useMiss;
+
+  // cycle information
+  cycles_t prefetchCycle;
+  cycles_t useCycle;
+
+  LLCPrefetchTagEntry() {
+    prefState = NOT_PREFETCHED;
+    lowPriority = false;
+  }
+};
+
+
+// -----------------------------------------------------------------------------
+// Class: LLCPrefetchMonitor
+// Description:
+//    Counts prefetches apart from demand reads and tracks whether prefetched
+//    blocks are used, and how long after the prefetch (in cycles and in
+//    misses to the set). Also counts demand misses per processor. With
+//    EvictionMisses, a miss to the set is counted when a block that was not
+//    inserted at low priority is evicted, instead of at each miss.
+// -----------------------------------------------------------------------------
+
+template <class Base, bool EvictionMisses = false>
+class LLCPrefetchMonitor : public Base {
+
+protected:
+
+  LLC_HOOK_MODULE_MEMBERS(Base)
+
+  typedef LLCPrefetchTagEntry P;
+
+  vector <uint32> _missCounter;
+  vector <uint64> _procMisses;
+
+  // -------------------------------------------------------------------------
+  // Declare Counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(prefetches);
+  NEW_COUNTER(prefetch_misses);
+
+  NEW_COUNTER(unused_prefetches);
+  NEW_COUNTER(used_prefetches);
+  NEW_COUNTER(unreused_prefetches);
+  NEW_COUNTER(reused_prefetches);
+
+  NEW_COUNTER(prefetch_use_cycle);
+  NEW_COUNTER(prefetch_use_miss);
+
+  NEW_COUNTER(prefetch_lifetime_cycle);
+  NEW_COUNTER(prefetch_lifetime_miss);
+
+public:
+
+  void InitializeHookStatistics() {
+
+    Base::InitializeHookStatistics();
+
+    INITIALIZE_COUNTER(prefetches, "Total prefetches")
+    INITIALIZE_COUNTER(prefetch_misses, "Prefetch misses")
+
+    INITIALIZE_COUNTER(unused_prefetches, "Unused prefetches")
+    INITIALIZE_COUNTER(used_prefetches, "Used prefetches")
+    INITIALIZE_COUNTER(unreused_prefetches, "Unreused prefetches")
+    INITIALIZE_COUNTER(reused_prefetches, "Reused prefetches")
+
+    INITIALIZE_COUNTER(prefetch_use_cycle, "Prefetch-to-use Cycles")
+    INITIALIZE_COUNTER(prefetch_use_miss, "Prefetch-to-use Misses")
+
+    INITIALIZE_COUNTER(prefetch_lifetime_cycle, "Prefetch-lifetime Cycles")
+    INITIALIZE_COUNTER(prefetch_lifetime_miss, "Prefetch-lifetime Misses")
+    INITIALIZE_VECTOR_COUNTER(_procMisses, "misses", "Misses of each cpu")
+  }
+
+  void StartHooks() {
+    Base::StartHooks();
+    _missCounter.resize(_numSets, 0);
+    _procMisses.resize(_numCPUs, 0);
+  }
+
+  void EndProcWarmUp(uint32 cpuID) {
+    Base::EndProcWarmUp(cpuID);
+    _procMisses[cpuID] = 0;
+  }
+
+  void OnAccess(MemoryRequest *request) {
+    if (request -> type == MemoryRequest::PREFETCH) {
+      INCREMENT(prefetches);
+    }
+    else
+      Base::OnAccess(request);
+  }
+
+  void OnHit(MemoryRequest *request, addr_t ctag) {
+
+    Base::OnHit(request, ctag);
+    if (request -> type == MemoryRequest::PREFETCH)
+      return;
+
+    TagEntry &tagentry = _tags[ctag];
+
+    // check the prefetched state
+    switch (tagentry.prefState) {
+    case P::PREFETCHED_UNUSED:
+      // update state
+      tagentry.prefState = P::PREFETCHED_USED;
+      tagentry.useMiss = _missCounter[_tags.index(ctag)];
+      tagentry.useCycle = request -> currentCycle;
+
+      // update counters
+      INCREMENT(used_prefetches);
+      ADD_TO_COUNTER(prefetch_use_cycle,
+                     tagentry.useCycle - tagentry.prefetchCycle);
+      ADD_TO_COUNTER(prefetch_use_miss,
+                     tagentry.useMiss - tagentry.prefetchMiss);
+      break;
+
+    case P::PREFETCHED_USED:
+      tagentry.prefState = P::PREFETCHED_REUSED;
+      INCREMENT(reused_prefetches);
+      break;
+
+    case P::NOT_PREFETCHED:
+    case P::PREFETCHED_REUSED:
+      // do nothing
+      break;
+    }
+  }
+
+  void OnMiss(MemoryRequest *request, addr_t ctag) {
+    if (!EvictionMisses)
+      _missCounter[_tags.index(ctag)] ++;
+    if (request -> type == MemoryRequest::PREFETCH) {
+      INCREMENT(prefetch_misses);
+      return;
+    }
+    Base::OnMiss(request, ctag);
+    if (!_done.test(request -> cpuID)) _procMisses[request -> cpuID] ++;
+  }
+
+  void OnInsert(MemoryRequest *request, addr_t ctag, TagEntry &entry,
+                policy_value_t priority) {
+    Base::OnInsert(request, ctag, entry, priority);
+    entry.prefState = P::NOT_PREFETCHED;
+    if (request -> type == MemoryRequest::PREFETCH) {
+      entry.prefState = P::PREFETCHED_UNUSED;
+      entry.prefID = request -> prefetcherID;
+      entry.prefetchCycle = request -> currentCycle;
+      entry.prefetchMiss = _missCounter[_tags.index(ctag)];
+    }
+  }
+
+  void OnEvict(MemoryRequest *request, TagTableEntry &victim) {
+
+    Base::OnEvict(request, victim);
+    uint32 index = _tags.index(victim.key);
+
+    // check prefetched state
+    switch (victim.value.prefState) {
+    case P::PREFETCHED_UNUSED:
+      INCREMENT(unused_prefetches);
+      ADD_TO_COUNTER(prefetch_lifetime_cycle,
+                     request -> currentCycle - victim.value.prefetchCycle);
+      ADD_TO_COUNTER(prefetch_lifetime_miss,
+                     _missCounter[index] - victim.value.prefetchMiss);
+      break;
+
+    case P::PREFETCHED_USED:
+      INCREMENT(unreused_prefetches);
+      ADD_TO_COUNTER(prefetch_lifetime_cycle,
+                     request -> currentCycle - victim.value.prefetchCycle);
+      ADD_TO_COUNTER(prefetch_lifetime_miss,
+                     _missCounter[index] - victim.value.prefetchMiss);
+      break;
+
+    case P::PREFETCHED_REUSED:
+      ADD_TO_COUNTER(prefetch_lifetime_cycle,
+                     victim.value.useCycle - victim.value.prefetchCycle);
+      ADD_TO_COUNTER(prefetch_lifetime_miss,
+                     victim.value.useMiss - victim.value.prefetchMiss);
+      break;
+
+    case P::NOT_PREFETCHED:
+      // do nothing
+      break;
+    }
+
+    if (EvictionMisses && !victim.value.lowPriority)
+      _missCounter[index] ++;
+  }
+};
+
+#endif // __LLC_HOOKS_H__
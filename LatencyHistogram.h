@@ -0,0 +1,168 @@
+// -----------------------------------------------------------------------------
+// File: LatencyHistogram.h
+// Description:
+//    Defines a log-linear latency histogram
+// -----------------------------------------------------------------------------
+
+#ifndef __LATENCY_HISTOGRAM_H__
+#define __LATENCY_HISTOGRAM_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+
+// -----------------------------------------------------------------------------
+// Class: LatencyHistogram
+// Description:
+//    HDR-style log-linear histogram. Values below 2^SUB_BITS get a bucket
+//    each. Above that, each power of two is split into 2^(SUB_BITS-1)
+//    buckets, so a bucket is at most 1/32 of its values wide. Values of
+//    2^MAX_BITS or more go to the last bucket. The count, sum and maximum
+//    are exact.
+// -----------------------------------------------------------------------------
+
+class LatencyHistogram {
+
+  public:
+
+    static const uint32 SUB_BITS = 6;
+    static const uint32 MAX_BITS = 24;
+    static const uint32 NUM_BUCKETS =
+      (1 << SUB_BITS) + (MAX_BITS - SUB_BITS) * (1 << (SUB_BITS - 1));
+
+  protected:
+
+    vector <uint64> _buckets;
+    uint64 _count;
+    uint64 _sum;
+    uint64 _max;
+
+  public:
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+
+    LatencyHistogram() {
+      _buckets.resize(NUM_BUCKETS, 0);
+      _count = 0;
+      _sum = 0;
+      _max = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to record a value
+    // -------------------------------------------------------------------------
+
+    void Record(uint64 value) {
+      _buckets[Bucket(value)] ++;
+      _count ++;
+      _sum += value;
+      if (value > _max) _max = value;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to add the values of another histogram
+    // -------------------------------------------------------------------------
+
+    void Merge(const LatencyHistogram &other) {
+      for (uint32 i = 0; i < NUM_BUCKETS; i ++)
+        _buckets[i] += other._buckets[i];
+      _count += other._count;
+      _sum += other._sum;
+      if (other._max > _max) _max = other._max;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to clear the histogram
+    // -------------------------------------------------------------------------
+
+    void Reset() {
+      fill(_buckets.begin(), _buckets.end(), 0);
+      _count = 0;
+      _sum = 0;
+      _max = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Accessors
+    // -------------------------------------------------------------------------
+
+    uint64 Count() const { return _count; }
+    uint64 Max() const { return _max; }
+    uint64 BucketCount(uint32 bucket) const { return _buckets[bucket]; }
+
+    double Mean() const {
+      return (_count == 0 ? 0.0 : (double)_sum / _count);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to get a percentile (0 to 100). Returns the highest value of
+    // the bucket that holds it, capped at the maximum
+    // -------------------------------------------------------------------------
+
+    uint64 Percentile(double percentile) const {
+      if (_count == 0) return 0;
+      uint64 rank = (uint64)(percentile / 100.0 * _count + 0.5);
+      if (rank == 0) rank = 1;
+      if (rank > _count) rank = _count;
+
+      uint64 seen = 0;
+      for (uint32 i = 0; i < NUM_BUCKETS; i ++) {
+        seen += _buckets[i];
+        if (seen >= rank)
+          return min(BucketHigh(i), _max);
+      }
+      return _max;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Functions to get the bucket of a value and the range of a bucket
+    // -------------------------------------------------------------------------
+
+    static uint32 Bucket(uint64 value) {
+      if (value < (1ULL << SUB_BITS))
+        return value;
+      if (value >= (1ULL << MAX_BITS))
+        return NUM_BUCKETS - 1;
+      uint32 msb = 63 - __builtin_clzll(value);
+      uint32 shift = msb - SUB_BITS + 1;
+      return (1 << SUB_BITS) + (shift - 1) * (1 << (SUB_BITS - 1)) +
+        (uint32)(value >> shift) - (1 << (SUB_BITS - 1));
+    }
+
+    static uint64 BucketLow(uint32 bucket) {
+      if (bucket < (1U << SUB_BITS))
+        return bucket;
+      uint32 half = 1 << (SUB_BITS - 1);
+      uint32 shift = (bucket - (1 << SUB_BITS)) / half + 1;
+      uint64 sub = (bucket - (1 << SUB_BITS)) % half + half;
+      return sub << shift;
+    }
+
+    static uint64 BucketHigh(uint32 bucket) {
+      if (bucket == NUM_BUCKETS - 1)
+        return ~0ULL;
+      return BucketLow(bucket + 1) - 1;
+    }
+};
+
+#endif // __LATENCY_HISTOGRAM_H__
@@ -13,6 +13,9 @@
 // -----------------------------------------------------------------------------
 
 #include "MemoryRequest.h"
+#include "LatencyHistogram.h"
+#include "RequestTracer.h"
+#include "StatsRegistry.h"
 #include "Types.h"
 
 // -----------------------------------------------------------------------------
@@ -112,9 +115,28 @@ using namespace std;
 #define NEW_COUNTER(var) uint64 var
 
 #define INITIALIZE_COUNTER(var, lname) {\
-  _statsOrder.push_back(#var);\
-  _stats[#var].ptr = &var;\
-  _stats[#var].longname = (string)lname;\
+  Stats _temp_stat;\
+  _temp_stat.name = #var;\
+  _temp_stat.longname = (string)lname;\
+  _temp_stat.ptr = &var;\
+  _temp_stat.handle = StatsRegistry::INVALID_HANDLE;\
+  if (_statsRegistry != NULL)\
+    _temp_stat.handle = _statsRegistry -> AddScalar(_name, #var, lname, &var);\
+  _stats.push_back(_temp_stat);\
+}
+
+// vectors (one counter per cpu) and histograms are vector <uint64> members.
+// they go to the registry only, under the given name, and components reset
+// them themselves. DUMP_STATISTICS writes them to the simulation log
+
+#define INITIALIZE_VECTOR_COUNTER(var, name, lname) {\
+  if (_statsRegistry != NULL)\
+    _statsRegistry -> AddVector(_name, name, lname, &var);\
+}
+
+#define INITIALIZE_HISTOGRAM(var, name, lname) {\
+  if (_statsRegistry != NULL)\
+    _statsRegistry -> AddHistogram(_name, name, lname, &var);\
 }
 
 #define INCREMENT(var) {\
@@ -130,9 +152,8 @@ using namespace std;
 }
 
 #define RESET_ALL_COUNTERS {\
-  map <string, Stats>::iterator it;\
-  for (it = _stats.begin(); it != _stats.end(); it ++) {\
-    *((*it).second.ptr) = 0;\
+  for (uint32 _temp_i = 0; _temp_i < _stats.size(); _temp_i ++) {\
+    *(_stats[_temp_i].ptr) = 0;\
   }\
 }
 
@@ -153,11 +174,13 @@ using namespace std;
 // -----------------------------------------------------------------------------
 
 #define DUMP_STATISTICS {\
-  list <string>::iterator it;\
-  for (it = _statsOrder.begin(); it != _statsOrder.end(); it ++) {\
-    CMP_LOG("%s = %llu", (*it).c_str(),\
-        *(_stats[(*it)].ptr));\
-  }\
+  if (_statsRegistry != NULL)\
+    _statsRegistry -> WriteLog(_simulationLog, _name);\
+  else\
+    for (uint32 _temp_i = 0; _temp_i < _stats.size(); _temp_i ++) {\
+      CMP_LOG("%s = %llu", _stats[_temp_i].name.c_str(),\
+          *(_stats[_temp_i].ptr));\
+    }\
 }
 
 
@@ -246,17 +269,28 @@ class MemoryComponent {
     // priority queue of requests
     RequestPriorityQueue _queue;
 
-    // statistics
+    // statistics, in the order they were initialized, and the registry of
+    // the simulator
     struct Stats {
+      string name;
       string longname;
       uint64 *ptr;
+      StatsRegistry::handle_t handle;
     };
-    map <string, Stats> _stats;
-    list <string> _statsOrder;
+    vector <Stats> _stats;
+    StatsRegistry *_statsRegistry;
 
     // log files
     map <string, FILE *> _logs;
 
+    // latency histograms, indexed by request type and cpu
+    bool _latencyHistograms;
+    vector <LatencyHistogram> _latency;
+
+    // request tracer and the index of the component in the trace
+    RequestTracer *_tracer;
+    uint32 _traceIndex;
+
 
   public:
 
@@ -271,7 +305,10 @@ class MemoryComponent {
       _processing = false;
       _warmUp = true;
       _stats.clear();
-      _statsOrder.clear();
+      _statsRegistry = NULL;
+      _latencyHistograms = false;
+      _tracer = NULL;
+      _traceIndex = 0;
       _logs.clear();
       _done.reset();
     }
@@ -285,6 +322,10 @@ class MemoryComponent {
       _name = name;
     }
 
+    string GetName() {
+      return _name;
+    }
+
 
     // return size
 
@@ -292,13 +333,6 @@ class MemoryComponent {
 	return _queue.size();
    }
 
-    // update with new value of top
-    void UpdateQueue(){
-	MemoryRequest* request = _queue.top();
-	_queue.pop();
-	(request -> currentCycle) += 15;
-	_queue.push(request);
-    }
 
 
     // -------------------------------------------------------------------------
@@ -335,14 +369,26 @@ class MemoryComponent {
     }
 
 
+    // -------------------------------------------------------------------------
+    // Function to set the request tracer. Only called if tracing is on
+    // -------------------------------------------------------------------------
+
+    void SetTracer(RequestTracer *tracer, uint32 traceIndex) {
+      _tracer = tracer;
+      _traceIndex = traceIndex;
+    }
+
+
     // -------------------------------------------------------------------------
     // Function to set the log details of the request
     // -------------------------------------------------------------------------
 
-    void SetLogDetails(string simulationFolderName, FILE *simulationLog) {
+    void SetLogDetails(string simulationFolderName, FILE *simulationLog,
+        StatsRegistry *statsRegistry = NULL) {
       // initialize members
       _simulationFolderName = simulationFolderName;
       _simulationLog = simulationLog;
+      _statsRegistry = statsRegistry;
     }
 
 
@@ -351,6 +397,10 @@ class MemoryComponent {
     // -------------------------------------------------------------------------
 
     void AddRequest(MemoryRequest *request) {
+      if (_latencyHistograms) MarkArrival(request);
+      if (request -> traceID != 0)
+        Trace(request, request -> serviced ? RequestTracer::RETURN :
+            RequestTracer::ARRIVE);
       _queue.push(request);
       if (!_processing)
         ProcessPendingRequests();
@@ -362,6 +412,10 @@ class MemoryComponent {
     // Function to add request without doing progress
     // ------------------------------------------------------------------------
     void SimpleAddRequest(MemoryRequest *request) {
+      if (_latencyHistograms) MarkArrival(request);
+      if (request -> traceID != 0)
+        Trace(request, request -> serviced ? RequestTracer::RETURN :
+            RequestTracer::ARRIVE);
       _queue.push(request);
       	
     }
@@ -395,6 +449,82 @@ class MemoryComponent {
     }
 
 
+    // -------------------------------------------------------------------------
+    // Function to get the earliest cycle at which the component has work to
+    // do. Returns false if the component has nothing to do. Components that
+    // hold requests outside the queue override this.
+    // -------------------------------------------------------------------------
+
+    virtual bool NextEvent(cycles_t &cycle) {
+      if (_queue.empty())
+        return false;
+      cycle = _queue.top() -> currentCycle;
+      return true;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Dirty row query. A cache that tracks dirty blocks by DRAM row (DBI)
+    // overrides these so that a memory controller can pull the other dirty
+    // blocks of a row while it is open. DirtyRowBlocks appends the virtual
+    // and physical addresses of the dirty blocks in the row of the request,
+    // other than the request's own block. CleanBlock marks a block, given by
+    // both addresses, clean and returns a writeback for it, or NULL if the
+    // block is no longer dirty.
+    // -------------------------------------------------------------------------
+
+    virtual bool TracksDirtyRows() {
+      return false;
+    }
+
+    virtual void DirtyRowBlocks(MemoryRequest *request, vector <addr_t> &vblocks,
+        vector <addr_t> &pblocks) {
+    }
+
+    virtual MemoryRequest *CleanBlock(addr_t vblock, addr_t pblock,
+        MemoryRequest *request) {
+      return NULL;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Prefetch filter queries. Caches and MSHRs override these so that a
+    // prefetcher above them can drop prefetches to blocks that are already
+    // cached or already being fetched.
+    // -------------------------------------------------------------------------
+
+    virtual bool IsCache() {
+      return false;
+    }
+
+    virtual bool HoldsBlock(addr_t vaddr, addr_t paddr) {
+      return false;
+    }
+
+    virtual bool IsMSHR() {
+      return false;
+    }
+
+    virtual bool HasOutstandingMiss(addr_t paddr) {
+      return false;
+    }
+
+    virtual uint32 OutstandingMisses() {
+      return 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to get the address a component indexes a block by. Components
+    // tagged by physical address override this, so that an interconnect above
+    // them sends a block to the slice that holds it.
+    // -------------------------------------------------------------------------
+
+    virtual addr_t IndexAddress(addr_t vaddr, addr_t paddr) {
+      return vaddr;
+    }
+
+
     // -------------------------------------------------------------------------
     // Virtual functions to be implemented by the components
     // -------------------------------------------------------------------------
@@ -457,6 +587,72 @@ class MemoryComponent {
     virtual void HeartBeat(cycles_t hbCount) {}
 
 
+    // -------------------------------------------------------------------------
+    // Latency histograms. The latency of a request at a component runs from
+    // its arrival to when it leaves on its return path (or is deleted by the
+    // component). The simulator starts them after the back pointers are set,
+    // resets them when warm up ends and writes them when simulation ends.
+    // -------------------------------------------------------------------------
+
+    void StartLatencyHistograms() {
+      _latencyHistograms = true;
+      _latency.assign(NUM_LATENCY_TYPES * _numCPUs, LatencyHistogram());
+    }
+
+    void ResetLatencyHistograms() {
+      for (uint32 i = 0; i < _latency.size(); i ++)
+        _latency[i].Reset();
+    }
+
+    void WriteLatencyHistograms() {
+      if (!_latencyHistograms) return;
+
+      string fileName = _simulationFolderName + "/" + _name + ".latency";
+      FILE *summary = fopen(fileName.c_str(), "w");
+      assert(summary != NULL);
+      fileName += "-buckets";
+      FILE *buckets = fopen(fileName.c_str(), "w");
+      assert(buckets != NULL);
+
+      fprintf(summary, "type,cpu,count,mean,p50,p90,p99,p99.9,max\n");
+      fprintf(buckets, "type,cpu,low,high,count\n");
+
+      for (uint32 type = 0; type < NUM_LATENCY_TYPES; type ++) {
+        LatencyHistogram all;
+        for (uint32 cpu = 0; cpu < _numCPUs; cpu ++) {
+          LatencyHistogram &histogram = _latency[type * _numCPUs + cpu];
+          if (histogram.Count() == 0) continue;
+          all.Merge(histogram);
+          fprintf(summary, "%s,%u,", LatencyTypeName(type), cpu);
+          WriteLatencySummary(summary, histogram);
+          for (uint32 b = 0; b < LatencyHistogram::NUM_BUCKETS; b ++) {
+            if (histogram.BucketCount(b) == 0) continue;
+            fprintf(buckets, "%s,%u,%llu,%llu,%llu\n", LatencyTypeName(type),
+                cpu, LatencyHistogram::BucketLow(b),
+                min(LatencyHistogram::BucketHigh(b), histogram.Max()),
+                histogram.BucketCount(b));
+          }
+        }
+        if (all.Count() == 0) continue;
+        fprintf(summary, "%s,all,", LatencyTypeName(type));
+        WriteLatencySummary(summary, all);
+
+        // the distribution over all cpus goes to the simulation log
+        const char *name = LatencyTypeName(type);
+        CMP_LOG("latency-%s-count = %llu", name, all.Count());
+        CMP_LOG("latency-%s-mean = %.2lf", name, all.Mean());
+        CMP_LOG("latency-%s-p50 = %llu", name, all.Percentile(50));
+        CMP_LOG("latency-%s-p90 = %llu", name, all.Percentile(90));
+        CMP_LOG("latency-%s-p99 = %llu", name, all.Percentile(99));
+        CMP_LOG("latency-%s-p999 = %llu", name, all.Percentile(99.9));
+        CMP_LOG("latency-%s-max = %llu", name, all.Max());
+      }
+
+      fclose(summary);
+      fclose(buckets);
+    }
+
+
     // -------------------------------------------------------------------------
     // Function to process pending requests. Different components can choose to
     // override this function. The default implementation processes one request
@@ -512,6 +708,8 @@ Access the request according to age.
 	// request is yet to be serviced
           else {
             request -> currentCycle = now;
+            if (request -> traceID != 0)
+              Trace(request, RequestTracer::PROCESS);
             cycles_t busyCycles = ProcessRequest(request);
             _currentCycle += busyCycles;
             SendToNextComponent(request);
@@ -549,6 +747,87 @@ Access the request according to age.
     virtual cycles_t ProcessReturn(MemoryRequest *request) { return 0; }
 
 
+    // -------------------------------------------------------------------------
+    // Latency histogram helpers. Only READ, WRITEBACK, PREFETCH and
+    // READ_FOR_WRITE requests are recorded
+    // -------------------------------------------------------------------------
+
+    enum { NUM_LATENCY_TYPES = 4 };
+
+    static int32 LatencyType(MemoryRequest::Type type) {
+      switch (type) {
+        case MemoryRequest::READ: return 0;
+        case MemoryRequest::WRITEBACK: return 1;
+        case MemoryRequest::PREFETCH: return 2;
+        case MemoryRequest::READ_FOR_WRITE: return 3;
+        default: return -1;
+      }
+    }
+
+    static const char *LatencyTypeName(uint32 type) {
+      static const char *names[NUM_LATENCY_TYPES] =
+        {"read", "writeback", "prefetch", "read_for_write"};
+      return names[type];
+    }
+
+    void MarkArrival(MemoryRequest *request) {
+      uint32 level = request -> cmpID;
+      if (request -> serviced || level >= MAX_ARRIVAL_LEVELS) return;
+      uint32 bit = 1U << level;
+      if (request -> arrivalMask & bit) return;
+      if (request -> arrivalCycle == NULL)
+        request -> arrivalCycle = new cycles_t[MAX_ARRIVAL_LEVELS];
+      request -> arrivalMask |= bit;
+      request -> arrivalCycle[level] = request -> currentCycle;
+    }
+
+    void RecordLatency(MemoryRequest *request) {
+      uint32 level = request -> cmpID;
+      if (level >= MAX_ARRIVAL_LEVELS) return;
+      uint32 bit = 1U << level;
+      if (!(request -> arrivalMask & bit)) return;
+      request -> arrivalMask &= ~bit;
+      int32 type = LatencyType(request -> type);
+      if (type < 0) return;
+      cycles_t arrival = request -> arrivalCycle[level];
+      _latency[type * _numCPUs + request -> cpuID].Record(
+          request -> currentCycle > arrival ?
+          request -> currentCycle - arrival : 0);
+    }
+
+    void WriteLatencySummary(FILE *file, LatencyHistogram &histogram) {
+      fprintf(file, "%llu,%.2lf,%llu,%llu,%llu,%llu,%llu\n",
+          histogram.Count(), histogram.Mean(), histogram.Percentile(50),
+          histogram.Percentile(90), histogram.Percentile(99),
+          histogram.Percentile(99.9), histogram.Max());
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to find the closest component above this one in the request's
+    // hierarchy that tracks dirty rows. Returns NULL if there is none.
+    // -------------------------------------------------------------------------
+
+    MemoryComponent *DirtyRowSource(MemoryRequest *request) {
+      vector <MemoryComponent *> &hier = (*_hier)[request -> cpuID];
+      for (int32 i = request -> cmpID - 1; i >= 0; i --)
+        if (hier[i] -> TracksDirtyRows())
+          return hier[i];
+      return NULL;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to record an event of a traced request
+    // -------------------------------------------------------------------------
+
+    void Trace(MemoryRequest *request, RequestTracer::Event event) {
+      if (_tracer != NULL)
+        _tracer -> Record(request -> currentCycle, request -> traceID,
+            _traceIndex, request -> cpuID, event, request -> type);
+    }
+
+
     // -------------------------------------------------------------------------
     // Function to send the request to the next component. It uses the serviced
     // flag in the request to determine the direction of the request.
@@ -558,6 +837,9 @@ Access the request according to age.
 
       // if the request should be destroyed, delete it
       if (request -> destroy) {
+        if (_latencyHistograms) RecordLatency(request);
+        if (request -> traceID != 0)
+          Trace(request, RequestTracer::DEPART);
         delete request;
         return;
       }   
@@ -576,6 +858,15 @@ Access the request according to age.
       
       // else if request is serviced, send it to previous component
       if (request -> serviced) {
+        if (_latencyHistograms) RecordLatency(request);
+        if (request -> traceID != 0)
+          Trace(request, RequestTracer::DEPART);
+        // a prefetch that fills the levels above its prefetcher ends at the
+        // last level it fills
+        if (request -> cmpID == request -> fillCmpID) {
+          delete request;
+          return;
+        }
         if (request -> cmpID == 0) {
           request -> finished = true;
           return;
@@ -588,8 +879,12 @@ Access the request according to age.
 	// check if request has reached end of component hierarchy
         if ((uint32)(request -> cmpID + 1) == ((*_hier)[request -> cpuID]).size())
           request -> serviced = true;
-        else
+        else {
+          if (request -> traceID != 0)
+            Trace(request, RequestTracer::FORWARD);
           request -> cmpID ++;
+          request -> serviceLevel = request -> cmpID;
+        }
       }
       ((*_hier)[request -> cpuID])[request -> cmpID] -> AddRequest(request);
     }
@@ -18,6 +18,26 @@
 // Standard includes
 // -----------------------------------------------------------------------------
 
+#include <cstddef>
+
+// levels of the hierarchy for which a request records its arrival cycle
+#define MAX_ARRIVAL_LEVELS 16
+
+// -----------------------------------------------------------------------------
+// Structure: WritebackDrain
+// Description:
+//    Groups the writebacks of one batched row drain. The issuing cache tracks
+//    how many of them are still in flight and the memory controller counts
+//    the row buffer hits they get
+// -----------------------------------------------------------------------------
+
+struct WritebackDrain {
+  uint32 writebacks;
+  uint32 pending;
+  uint32 rowHits;
+  WritebackDrain() { writebacks = 0; pending = 0; rowHits = 0; }
+};
+
 
 // -----------------------------------------------------------------------------
 // Structure: MemoryRequest
@@ -105,6 +125,33 @@ struct MemoryRequest {
   // which they hit. Set to max sets if its a victim set miss
   bool reuseVictim;
   uint32 victimSetID;
+  // next request in an intrusive wait list. used by components to chain
+  // requests that are stalling on the same event (e.g., an MSHR entry)
+  MemoryRequest *waitNext;
+  // set when an MSHR releases the request from its wait for a free MSHR, so
+  // that the retry is not counted as another access
+  bool mshrRetry;
+  // row drain that the writeback belongs to. NULL for all other requests
+  WritebackDrain *drain;
+  // component at which a returning prefetch is deleted, when the prefetch
+  // fills levels above its prefetcher. -1 for all other requests
+  int32 fillCmpID;
+  // cycle at which the request arrived at each level of the hierarchy, for
+  // the latency histograms. a level's cycle is valid if its bit is set in the
+  // mask. the array is allocated at the first arrival, so it is NULL unless
+  // latency histograms are on
+  uint32 arrivalMask;
+  cycles_t *arrivalCycle;
+  // trace id if the request is sampled by the request tracer, 0 otherwise
+  uint32 traceID;
+  // deepest level of the hierarchy that the request, or the miss it waited
+  // on, reached. used by the cpi stack of the front end
+  int32 serviceLevel;
+  // cycles the request, or the miss it waited on, waited for a free MSHR
+  cycles_t mshrStallCycles;
+  // cycles the issue of the request was delayed by a full load queue or
+  // store buffer. set by the front end
+  cycles_t windowStallCycles;
 
   // ---------------------------------------------------------------------------
   // Constructor
@@ -120,6 +167,16 @@ struct MemoryRequest {
     d_prefetched = false;
     d_hit = false;
     s_f_d = false;
+    waitNext = NULL;
+    mshrRetry = false;
+    drain = NULL;
+    fillCmpID = -1;
+    arrivalMask = 0;
+    arrivalCycle = NULL;
+    traceID = 0;
+    serviceLevel = 0;
+    mshrStallCycles = 0;
+    windowStallCycles = 0;
   }
 
   // ---------------------------------------------------------------------------
@@ -146,6 +203,24 @@ struct MemoryRequest {
     d_prefetched = false;
     d_hit = false;
     s_f_d = false;
+    waitNext = NULL;
+    mshrRetry = false;
+    drain = NULL;
+    fillCmpID = -1;
+    arrivalMask = 0;
+    arrivalCycle = NULL;
+    traceID = 0;
+    serviceLevel = 0;
+    mshrStallCycles = 0;
+    windowStallCycles = 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Destructor
+  // ---------------------------------------------------------------------------
+
+  ~MemoryRequest() {
+    delete [] arrivalCycle;
   }
 
   // ---------------------------------------------------------------------------
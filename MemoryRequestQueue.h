@@ -0,0 +1,270 @@
+// -----------------------------------------------------------------------------
+// File: MemoryRequestQueue.h
+// Description:
+//    Defines the request queues of a memory controller. Requests are kept per
+//    bank and split into those that hit the open row of the bank and those
+//    that do not, so that the schedulers can find the oldest row hit by only
+//    looking at the head of each bank's hit list.
+// -----------------------------------------------------------------------------
+
+#ifndef __MEMORY_REQUEST_QUEUE_H__
+#define __MEMORY_REQUEST_QUEUE_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "MemoryRequest.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+#include <deque>
+
+using namespace std;
+
+// queue identifiers
+#define READ_QUEUE 0
+#define WRITE_QUEUE 1
+
+
+// -----------------------------------------------------------------------------
+// Class: MemoryRequestQueue
+// Description:
+//    Per-bank read and write queues with open row tracking. Within each list
+//    requests are in arrival order.
+// -----------------------------------------------------------------------------
+
+class MemoryRequestQueue {
+
+  protected:
+
+    // a queued request
+    struct Entry {
+      MemoryRequest *request;
+      uint64 seq;
+      addr_t row;
+    };
+
+    // queues of a single bank
+    struct Bank {
+      addr_t openRow;
+      // requests to the open row
+      deque <Entry> hits[2];
+      // requests to other rows
+      deque <Entry> others[2];
+    };
+
+    vector <Bank> _banks;
+    uint32 _size[2];
+    uint32 _hits[2];
+    uint64 _seq;
+
+
+    // -------------------------------------------------------------------------
+    // Function to find the bank whose list has the oldest head. Returns the
+    // number of banks if all lists are empty.
+    // -------------------------------------------------------------------------
+
+    uint32 OldestBank(uint32 queue, bool hitsOnly) {
+      uint32 oldest = _banks.size();
+      uint64 seq = 0;
+      for (uint32 i = 0; i < _banks.size(); i ++) {
+        Bank &bank = _banks[i];
+        if (!bank.hits[queue].empty() &&
+            (oldest == _banks.size() || bank.hits[queue].front().seq < seq)) {
+          oldest = i;
+          seq = bank.hits[queue].front().seq;
+        }
+        if (!hitsOnly && !bank.others[queue].empty() &&
+            (oldest == _banks.size() || bank.others[queue].front().seq < seq)) {
+          oldest = i;
+          seq = bank.others[queue].front().seq;
+        }
+      }
+      return oldest;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to remove the oldest request of a bank
+    // -------------------------------------------------------------------------
+
+    MemoryRequest *PopBank(uint32 queue, uint32 index, bool hitsOnly) {
+      Bank &bank = _banks[index];
+      deque <Entry> *list = &(bank.hits[queue]);
+      if (!hitsOnly && (list -> empty() || (!bank.others[queue].empty() &&
+              bank.others[queue].front().seq < list -> front().seq)))
+        list = &(bank.others[queue]);
+      else
+        _hits[queue] --;
+      MemoryRequest *request = list -> front().request;
+      list -> pop_front();
+      _size[queue] --;
+      return request;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to pop the oldest request (or row hit) from either queue
+    // -------------------------------------------------------------------------
+
+    MemoryRequest *PopOldestAny(bool hitsOnly) {
+      uint32 read = OldestBank(READ_QUEUE, hitsOnly);
+      uint32 write = OldestBank(WRITE_QUEUE, hitsOnly);
+      if (read == _banks.size() && write == _banks.size())
+        return NULL;
+      if (write == _banks.size())
+        return PopBank(READ_QUEUE, read, hitsOnly);
+      if (read == _banks.size())
+        return PopBank(WRITE_QUEUE, write, hitsOnly);
+      if (HeadSeq(READ_QUEUE, read, hitsOnly) <
+          HeadSeq(WRITE_QUEUE, write, hitsOnly))
+        return PopBank(READ_QUEUE, read, hitsOnly);
+      return PopBank(WRITE_QUEUE, write, hitsOnly);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to get the arrival number of the oldest request in a bank
+    // -------------------------------------------------------------------------
+
+    uint64 HeadSeq(uint32 queue, uint32 index, bool hitsOnly) {
+      Bank &bank = _banks[index];
+      if (bank.hits[queue].empty())
+        return bank.others[queue].front().seq;
+      if (hitsOnly || bank.others[queue].empty())
+        return bank.hits[queue].front().seq;
+      return min(bank.hits[queue].front().seq,
+          bank.others[queue].front().seq);
+    }
+
+  public:
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+
+    MemoryRequestQueue() {
+      _size[READ_QUEUE] = _size[WRITE_QUEUE] = 0;
+      _hits[READ_QUEUE] = _hits[WRITE_QUEUE] = 0;
+      _seq = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to set the number of banks. All rows start closed at row 0.
+    // -------------------------------------------------------------------------
+
+    void SetNumBanks(uint32 numBanks) {
+      _banks.resize(numBanks);
+      for (uint32 i = 0; i < numBanks; i ++)
+        _banks[i].openRow = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Accessors
+    // -------------------------------------------------------------------------
+
+    uint32 Size(uint32 queue) { return _size[queue]; }
+    bool Empty(uint32 queue) { return _size[queue] == 0; }
+    bool Empty() { return _size[READ_QUEUE] == 0 && _size[WRITE_QUEUE] == 0; }
+    uint32 NumBanks() { return _banks.size(); }
+    addr_t OpenRow(uint32 bank) { return _banks[bank].openRow; }
+    bool IsOpen(uint32 bank, addr_t row) { return _banks[bank].openRow == row; }
+
+
+    // -------------------------------------------------------------------------
+    // Function to add a request to a queue
+    // -------------------------------------------------------------------------
+
+    void Insert(MemoryRequest *request, uint32 queue, uint32 bank, addr_t row) {
+      Entry entry;
+      entry.request = request;
+      entry.seq = _seq ++;
+      entry.row = row;
+      if (_banks[bank].openRow == row) {
+        _banks[bank].hits[queue].push_back(entry);
+        _hits[queue] ++;
+      }
+      else {
+        _banks[bank].others[queue].push_back(entry);
+      }
+      _size[queue] ++;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to open a row in a bank. Requests are moved between the hit
+    // and other lists of the bank, keeping them in arrival order.
+    // -------------------------------------------------------------------------
+
+    void SetOpenRow(uint32 index, addr_t row) {
+      Bank &bank = _banks[index];
+      if (bank.openRow == row) return;
+      bank.openRow = row;
+
+      for (uint32 q = 0; q < 2; q ++) {
+        deque <Entry> &hits = bank.hits[q];
+        deque <Entry> &others = bank.others[q];
+        if (hits.empty() && others.empty()) continue;
+
+        _hits[q] -= hits.size();
+        deque <Entry> newHits, newOthers;
+        // merge the two lists in arrival order and split them by the new row
+        while (!hits.empty() || !others.empty()) {
+          Entry entry;
+          if (others.empty() || (!hits.empty() &&
+                hits.front().seq < others.front().seq)) {
+            entry = hits.front();
+            hits.pop_front();
+          }
+          else {
+            entry = others.front();
+            others.pop_front();
+          }
+          if (entry.row == row) newHits.push_back(entry);
+          else newOthers.push_back(entry);
+        }
+        _hits[q] += newHits.size();
+        hits.swap(newHits);
+        others.swap(newOthers);
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Functions to remove requests. They return NULL if there is no request
+    // to choose.
+    // -------------------------------------------------------------------------
+
+    // oldest request in a queue
+    MemoryRequest *PopOldest(uint32 queue) {
+      uint32 bank = OldestBank(queue, false);
+      if (bank == _banks.size()) return NULL;
+      return PopBank(queue, bank, false);
+    }
+
+    // oldest row hit in a queue
+    MemoryRequest *PopOldestHit(uint32 queue) {
+      if (_hits[queue] == 0) return NULL;
+      return PopBank(queue, OldestBank(queue, true), true);
+    }
+
+    // oldest request in both queues
+    MemoryRequest *PopOldest() {
+      return PopOldestAny(false);
+    }
+
+    // oldest row hit in both queues
+    MemoryRequest *PopOldestHit() {
+      if (_hits[READ_QUEUE] == 0 && _hits[WRITE_QUEUE] == 0) return NULL;
+      return PopOldestAny(true);
+    }
+};
+
+#endif // __MEMORY_REQUEST_QUEUE_H__
@@ -2,7 +2,10 @@
 // File: MemorySchedulers.h
 // Description:
 //    This file contains a list of memory schedulers for the memory controller
-//    component to use.
+//    component to use. Each scheduler picks the next request from a set of
+//    per-bank request queues, using and updating the given drain flag. The
+//    including component provides the write buffer size
+//    (_numWriteBufferEntries).
 // -----------------------------------------------------------------------------
 
 
@@ -10,35 +13,8 @@
 // FCFS scheduler
 // -------------------------------------------------------------------------
 
-MemoryRequest * FCFS() {
-  MemoryRequest *request;
-
-  if (_readQ.empty() && _writeQ.empty())
-    return NULL; 
-
-  if (_readQ.empty()) {
-    request = _writeQ.front();
-    _writeQ.pop_front();
-    return request;
-  }
-
-  if (_writeQ.empty()) {
-    request = _readQ.front();
-    _readQ.pop_front();
-    return request;
-  }
-
-  if (_readQ.front() -> currentCycle <= _writeQ.front() -> currentCycle) {
-    request = _readQ.front();
-    _readQ.pop_front();
-    return request;
-  }
-
-  else {
-    request = _writeQ.front();
-    _writeQ.pop_front();
-    return request;
-  }
+MemoryRequest * FCFS(MemoryRequestQueue &requests, bool &drain) {
+  return requests.PopOldest();
 }
 
 
@@ -46,171 +22,64 @@ MemoryRequest * FCFS() {
 // FCFS with drain-when-full
 // -------------------------------------------------------------------------
 
-MemoryRequest * FCFSDrainWhenFull() {
-  MemoryRequest *request;
+MemoryRequest * FCFSDrainWhenFull(MemoryRequestQueue &requests,
+    bool &drain) {
 
-  if (_readQ.empty() && _writeQ.empty())
+  if (requests.Empty())
     return NULL;
 
-  if (_writeQ.size() == _numWriteBufferEntries)
-    _drain = true;
+  if (requests.Size(WRITE_QUEUE) >= _numWriteBufferEntries)
+    drain = true;
 
-  if (_drain) {
-    if (!_writeQ.empty()) {
-      request = _writeQ.front();
-      _writeQ.pop_front();
-      return request;
-    }
-    else {
-      _drain = false;
-    }
+  if (drain) {
+    if (!requests.Empty(WRITE_QUEUE))
+      return requests.PopOldest(WRITE_QUEUE);
+    drain = false;
   }
 
-  if (_readQ.empty())
-    return NULL;
-
-  request = _readQ.front();
-  _readQ.pop_front();
-  return request;
+  return requests.PopOldest(READ_QUEUE);
 }
 
 
 // -------------------------------------------------------------------------
-// FR-FCFS with drain-when-full
+// FR-FCFS scheduler. Row hits first, then the oldest request.
 // -------------------------------------------------------------------------
 
-#if 0
-MemoryRequest * FRFCFSDrainWhenFull() {
-
-  MemoryRequest *request;
-
-  if (_readQ.empty() && _writeQ.empty() && _readRowHits.empty() && 
-      _writeRowHits.empty())
-    return NULL;
-
-  if (_writeQ.size() >= _numWriteBufferEntries)
-    _drain = true;
-
-  list <MemoryRequest *>::iterator it;
-  list <list <MemoryRequest *>::iterator> erlist;
-
-  if (_drain) {
-
-    if (!_writeRowHits.empty()) {
-      request = _writeRowHits.front();
-      _writeRowHits.pop_front();
-      return request;
-    }
-
-    if (!_writeQ.empty()) {
-      for (it = _writeQ.begin(); it != _writeQ.end(); it ++) {
-        request = *it;
-        if (IsRowBufferHit(request)) {
-          _writeRowHits.push_back(request);
-          erlist.push_back(it);
-        }
-      }
-      while (!erlist.empty()) {
-        _writeQ.erase(erlist.front());
-        erlist.pop_front();
-      }
-      if (!_writeRowHits.empty()) {
-        request = _writeRowHits.front();
-        _writeRowHits.pop_front();
-        return request;
-      }
-      request = _writeQ.front();
-      _writeQ.pop_front();
-      return request;
-    }
-    else {
-      _drain = false;
-    }
-  }
-
-  // choose the next read request that hits the row buffer
-  if (!_readRowHits.empty()) {
-    request = _readRowHits.front();
-    _readRowHits.pop_front();
-    return request;
-  }
-
-  if (_readQ.empty())
-    return NULL;
-
-  for (it = _readQ.begin(); it != _readQ.end(); it ++) {
-    request = *it;
-    if (IsRowBufferHit(request)) {
-      _readRowHits.push_back(request);
-      erlist.push_back(it);
-    }
-  }
-  while (!erlist.empty()) {
-    _writeQ.erase(erlist.front());
-    erlist.pop_front();
-  }
-
-  if (!_readRowHits.empty()) {
-    request = _readRowHits.front();
-    _readRowHits.pop_front();
+MemoryRequest * FRFCFS(MemoryRequestQueue &requests, bool &drain) {
+  MemoryRequest *request = requests.PopOldestHit();
+  if (request != NULL)
     return request;
-  }
-
-  request = _readQ.front();
-  _readQ.pop_front();
-  return request;
-
+  return requests.PopOldest();
 }
-#endif
+
 
 // -------------------------------------------------------------------------
 // FR-FCFS with drain-when-full
 // -------------------------------------------------------------------------
 
-MemoryRequest * FRFCFSDrainWhenFull() {
+MemoryRequest * FRFCFSDrainWhenFull(MemoryRequestQueue &requests,
+    bool &drain) {
 
   MemoryRequest *request;
 
-  if (_readQ.empty() && _writeQ.empty())
+  if (requests.Empty())
     return NULL;
 
-  if (_writeQ.size() >= _numWriteBufferEntries)
-    _drain = true;
-
-  list <MemoryRequest *>::iterator it;
-
-  if (_drain) {
-    if (!_writeQ.empty()) {
-      for (it = _writeQ.begin(); it != _writeQ.end(); it ++) {
-        request = *it;
-        if (IsRowBufferHit(request)) {
-          _writeQ.erase(it);
-          return request;
-        }
-      }
-      request = _writeQ.front();
-      _writeQ.pop_front();
-      return request;
-    }
-    else {
-      _drain = false;
-    }
-  }
-
-
-  if (_readQ.empty())
-    return NULL;
+  if (requests.Size(WRITE_QUEUE) >= _numWriteBufferEntries)
+    drain = true;
 
-  for (it = _readQ.begin(); it != _readQ.end(); it ++) {
-    request = *it;
-    if (IsRowBufferHit(request)) {
-      _readQ.erase(it);
-      return request;
+  if (drain) {
+    if (!requests.Empty(WRITE_QUEUE)) {
+      request = requests.PopOldestHit(WRITE_QUEUE);
+      if (request != NULL)
+        return request;
+      return requests.PopOldest(WRITE_QUEUE);
     }
+    drain = false;
   }
 
-  request = _readQ.front();
-  _readQ.pop_front();
-  return request;
-
+  request = requests.PopOldestHit(READ_QUEUE);
+  if (request != NULL)
+    return request;
+  return requests.PopOldest(READ_QUEUE);
 }
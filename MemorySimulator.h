@@ -13,6 +13,8 @@
 // -----------------------------------------------------------------------------
 
 #include "MemoryComponent.h"
+#include "RequestTracer.h"
+#include "StatsRegistry.h"
 #include "Types.h"
 
 
@@ -51,6 +53,26 @@ class MemorySimulator {
     // simulation log file
     FILE *_simulationLog;
 
+    // statistics registry and the formats it is written in
+    StatsRegistry _statsRegistry;
+    bool _statsBinary;
+    bool _statsCSV;
+    bool _statsJSON;
+
+    // latency histograms of the components
+    bool _latencyHistograms;
+
+    // request tracer. one in _traceSample cpu requests is traced after the
+    // warm up (0 is off)
+    RequestTracer _tracer;
+    uint32 _traceSample;
+    uint32 _traceCount;
+    uint32 _traceNext;
+    bool _tracing;
+    // tracer statistics, set when the trace is closed
+    uint64 _tracedRequests;
+    uint64 _traceRecords;
+
     // current time of the simulator
     cycles_t _currentCycle;
 
@@ -66,6 +88,16 @@ class MemorySimulator {
       _hier.clear();
       _numCPUs = 0;
       _currentCycle = 0;
+      _statsBinary = false;
+      _statsCSV = false;
+      _statsJSON = false;
+      _latencyHistograms = false;
+      _traceSample = 0;
+      _traceCount = 0;
+      _traceNext = 0;
+      _tracing = false;
+      _tracedRequests = 0;
+      _traceRecords = 0;
     }
 
 
@@ -87,6 +119,59 @@ class MemorySimulator {
     }
 
 
+    // -------------------------------------------------------------------------
+    // Function to set the formats of the statistics files. Argument is a
+    // comma separated list of binary, csv and json. The registry snapshots
+    // the statistics only if a format is set.
+    // -------------------------------------------------------------------------
+
+    void SetStatsFormats(string formats) {
+      string::size_type index = 0;
+      while (index <= formats.size()) {
+        string::size_type next = formats.find_first_of(",", index);
+        if (next == string::npos) next = formats.size();
+        string format = formats.substr(index, next - index);
+        if (format.compare("binary") == 0) _statsBinary = true;
+        else if (format.compare("csv") == 0) _statsCSV = true;
+        else if (format.compare("json") == 0) _statsJSON = true;
+        else if (format.compare("") != 0) {
+          fprintf(stderr, "Error: Unknown statistics format `%s'\n",
+              format.c_str());
+          exit(-1);
+        }
+        index = next + 1;
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to check if the statistics registry is in use
+    // -------------------------------------------------------------------------
+
+    bool StatsEnabled() {
+      return _statsBinary || _statsCSV || _statsJSON;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to turn on the latency histograms of the components
+    // -------------------------------------------------------------------------
+
+    void EnableLatencyHistograms() {
+      _latencyHistograms = true;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to trace one in sample cpu requests. The trace is written to
+    // trace.bin in the simulation folder
+    // -------------------------------------------------------------------------
+
+    void SetTraceSample(uint32 sample) {
+      _traceSample = sample;
+    }
+
+
     // -------------------------------------------------------------------------
     // Function to set the start cycle of the simulator
     // -------------------------------------------------------------------------
@@ -110,11 +195,16 @@ class MemorySimulator {
       list <MemoryComponent *>::iterator cmp;
       for (cmp = _components.begin(); cmp != _components.end(); cmp ++) {
         (*cmp) -> SetBackPointers(&_hier, &_currentCycle);
-        (*cmp) -> SetLogDetails(_simulationFolderName, _simulationLog);
+        if (_latencyHistograms)
+          (*cmp) -> StartLatencyHistograms();
+        (*cmp) -> SetLogDetails(_simulationFolderName, _simulationLog,
+            &_statsRegistry);
         (*cmp) -> InitializeStatistics();
         (*cmp) -> StartSimulation();
       }
-       
+
+      if (_traceSample != 0)
+        StartTracer();
     }
 
 
@@ -143,64 +233,28 @@ class MemorySimulator {
     // -------------------------------------------------------------------------
 
     void AutoAdvance() {
-      
-      // For each component, find the earliest request that can be processed.
-      // Take the min of all and advance simulation to that point.
-      //cout << "auto advance start\n";
-      cycles_t min;
+
+      // For each component, find the earliest cycle at which it has work to
+      // do. Take the min of all and advance simulation to that point.
+      cycles_t min = _currentCycle;
+      cycles_t cycle;
       bool flag = false;
-      bool update = false;
-      min = _currentCycle;
 
-      MemoryComponent* cmpe;
-      MemoryRequest *request;
       list <MemoryComponent *>::iterator cmp;
       for (cmp = _components.begin(); cmp != _components.end(); cmp ++) {
-        //cout << "size of the comp " << (*cmp) -> Name() << "  is " << (*cmp) -> Size() << endl; 
-		
-        request = (*cmp) -> EarliestRequest();
-        
-	// EarliestRequest just returns the top of the queue
-        if (request != NULL) {
-	
-
-	if(request->s_f_d){
-	//(request -> currentCycle) += 5;
-        //(*cmp) -> UpdateQueue();
-	update = true;
-	}
-
-	  if (!flag) {
-	    //cout << "stuck at point x" << endl;
-            flag = true;	
-            min = request -> currentCycle;
-	    
-          }
-          else {
-            //cout << "stuck at point 3" << endl;
-            if (min > request -> currentCycle)
-              min = request -> currentCycle;
-	      cmpe = *cmp;
-	//cout << "component stuck is " << cmpe -> Name() << endl;
-          }
+        if ((*cmp) -> NextEvent(cycle)) {
+          if (!flag || cycle < min)
+            min = cycle;
+          flag = true;
         }
-      
-	if(update){(*cmp) -> UpdateQueue();update = false;}
       }
 
-	
-	
-
       if (!flag) {
-        fprintf(stderr, "Request is waiting for nothing?\n"); // occurs when all components have empty queues
-	// possibly I am sending all requests to DRAMSim and emptying all my request queues
+        // occurs when all components have nothing to do
+        fprintf(stderr, "Request is waiting for nothing?\n");
         exit(0);
       }
 
-	//if(min == _currentCycle){	min ++;cout << "min cycle is " << min << " and current cycle is " << _currentCycle << endl;}
-	//cout << "outside min cycle is " << min << " and current cycle is " << _currentCycle << endl;
-	
-	//cout << "auto advance end with min as " << min << endl << endl;
       AdvanceSimulation(min);
     }
 
@@ -211,10 +265,33 @@ class MemorySimulator {
     void EndSimulation() {
       // end the simulation for all the components
       list <MemoryComponent *>::iterator cmp;
-      for (cmp = _components.begin(); cmp != _components.end(); cmp ++)
+      for (cmp = _components.begin(); cmp != _components.end(); cmp ++) {
         (*cmp) -> EndSimulation();
+        (*cmp) -> WriteLatencyHistograms();
+      }
+      // close the trace
+      if (_traceSample != 0) {
+        _tracedRequests = _traceNext;
+        _traceRecords = _tracer.Finish();
+        fprintf(_simulationLog, "tracer:traced-requests = %llu\n",
+            _tracedRequests);
+        fprintf(_simulationLog, "tracer:trace-records = %llu\n",
+            _traceRecords);
+      }
       // close the simulation log
       fclose(_simulationLog);
+
+      // take the final snapshot and write the statistics files
+      if (!StatsEnabled())
+        return;
+      _statsRegistry.Snapshot(_currentCycle);
+      if (_statsBinary)
+        _statsRegistry.WriteBinary(_simulationFolderName + "/stats.bin");
+      if (_statsCSV)
+        _statsRegistry.WriteCSV(_simulationFolderName + "/stats.csv",
+            _simulationFolderName + "/stats.intervals.csv");
+      if (_statsJSON)
+        _statsRegistry.WriteJSON(_simulationFolderName + "/stats.json");
     }
 
 
@@ -224,8 +301,12 @@ class MemorySimulator {
 
     void EndWarmUp() {
       list <MemoryComponent *>::iterator cmp;
-      for (cmp = _components.begin(); cmp != _components.end(); cmp ++)
+      for (cmp = _components.begin(); cmp != _components.end(); cmp ++) {
         (*cmp) -> EndWarmUp();
+        (*cmp) -> ResetLatencyHistograms();
+      }
+      _statsRegistry.EndWarmUp(_currentCycle);
+      _tracing = (_traceSample != 0);
     }
 
   void EndProcWarmUp(uint32 cpuID) {
@@ -250,6 +331,17 @@ class MemorySimulator {
     }
 
 
+    // -------------------------------------------------------------------------
+    // Function to get the names of the components in the hierarchy of a cpu
+    // -------------------------------------------------------------------------
+
+    void HierarchyNames(uint32 cpuID, vector <string> &names) {
+      names.clear();
+      for (uint32 i = 0; i < _hier[cpuID].size(); i ++)
+        names.push_back(_hier[cpuID][i] -> GetName());
+    }
+
+
     // -------------------------------------------------------------------------
     // Function to handle heart beats of all components
     // -------------------------------------------------------------------------
@@ -258,6 +350,9 @@ class MemorySimulator {
       list <MemoryComponent *>::iterator cmp;
       for (cmp = _components.begin(); cmp != _components.end(); cmp ++)
         (*cmp) -> HeartBeat(hbCount);
+      // snapshot the statistics after the components have updated them
+      if (StatsEnabled())
+        _statsRegistry.Snapshot(_currentCycle);
     }
 
 
@@ -291,6 +386,12 @@ class MemorySimulator {
         return;
       }
 
+      // sample the request for tracing
+      if (_tracing && ++ _traceCount == _traceSample) {
+        _traceCount = 0;
+        request -> traceID = ++ _traceNext;
+      }
+
       // set the requests component ID and add it to the 
       // corresponding component's request
       request -> cmpID = 0;
@@ -302,6 +403,35 @@ class MemorySimulator {
     }
 
 
+    // -------------------------------------------------------------------------
+    // Function to start the request tracer. Components are numbered in the
+    // order of the definition file
+    // -------------------------------------------------------------------------
+
+    void StartTracer() {
+      map <MemoryComponent *, uint32> index;
+      vector <string> names;
+      list <MemoryComponent *>::iterator cmp;
+      for (cmp = _components.begin(); cmp != _components.end(); cmp ++) {
+        (*cmp) -> SetTracer(&_tracer, names.size());
+        index[*cmp] = names.size();
+        names.push_back((*cmp) -> GetName());
+      }
+
+      vector <vector <uint32> > hier(_numCPUs);
+      for (uint32 i = 0; i < _numCPUs; i ++)
+        for (uint32 j = 0; j < _hier[i].size(); j ++)
+          hier[i].push_back(index[_hier[i][j]]);
+
+      _tracer.Start(_simulationFolderName + "/trace.bin", names, hier);
+
+      _statsRegistry.AddScalar("tracer", "traced-requests", "Traced requests",
+          &_tracedRequests);
+      _statsRegistry.AddScalar("tracer", "trace-records", "Trace records",
+          &_traceRecords);
+    }
+
+
     // -------------------------------------------------------------------------
     // Function to parse the simulator configuration
     // -------------------------------------------------------------------------
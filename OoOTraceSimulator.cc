@@ -11,6 +11,7 @@
 // -----------------------------------------------------------------------------
 
 #include "OoOTraceSimulator.h"
+#include "IntervalTraceSimulator.h"
 
 
 // -----------------------------------------------------------------------------
@@ -40,7 +41,13 @@ int main(int argc, char **argv) {
   string simulatorConfiguration("");
   string folder("");
   uint32 numCPUs = 0;
-  uint32 oooWindow = 1;
+  vector <uint32> robSizes;
+  vector <uint32> widths;
+  vector <uint32> loadQueueSizes;
+  vector <uint32> storeBufferSizes;
+  vector <double> branchMPKIs;
+  vector <uint32> branchPenalties;
+  string coreModel("ooo");
   uint64 warmUp = 0;
   uint64 runTime = 0;
   uint64 heartBeat = 0;
@@ -48,6 +55,9 @@ int main(int argc, char **argv) {
   bool synthetic = false;
   uint32 workingSetSize = 0;
   uint32 memGap = 50;
+  string statsFormats("");
+  bool latencyHistograms = false;
+  uint32 traceSample = 0;
   
 
   struct option cmd_options[] = {
@@ -60,8 +70,19 @@ int main(int argc, char **argv) {
     {"run-time", required_argument, 0, 'g'},
     {"heart-beat", required_argument, 0, 'h'},
     {"ooo-window", required_argument, 0, 'i'},
+    {"rob-size", required_argument, 0, 'i'},
     {"synthetic", required_argument, 0, 'k'},
     {"mem-gap", required_argument, 0, 'm'},
+    {"width", required_argument, 0, 'n'},
+    {"load-queue", required_argument, 0, 'o'},
+    {"store-buffer", required_argument, 0, 'p'},
+    {"core-model", required_argument, 0, 'q'},
+    {"branch-mpki", required_argument, 0, 'r'},
+    {"branch-penalty", required_argument, 0, 's'},
+    {"stats-format", required_argument, 0, 't'},
+    {"latency-histograms", no_argument, 0, 'u'},
+    {"trace-sample", required_argument, 0, 'v'},
+    {0, 0, 0, 0}
   };
 
   int c = 0;
@@ -142,10 +163,75 @@ int main(int argc, char **argv) {
         break;
 
       // -----------------------------------------------------------------------
-      // ooo window
+      // ooo window (reorder buffer size). a comma separated list gives the
+      // value for each cpu. the same applies to the other core parameters
       // -----------------------------------------------------------------------
       case 'i':
-        oooWindow = atoi(optarg);
+        ParseCoreValues(optarg, robSizes);
+        break;
+
+      // -----------------------------------------------------------------------
+      // issue and retire width
+      // -----------------------------------------------------------------------
+      case 'n':
+        ParseCoreValues(optarg, widths);
+        break;
+
+      // -----------------------------------------------------------------------
+      // load queue size (0 for unlimited)
+      // -----------------------------------------------------------------------
+      case 'o':
+        ParseCoreValues(optarg, loadQueueSizes);
+        break;
+
+      // -----------------------------------------------------------------------
+      // store buffer size (0 for unlimited)
+      // -----------------------------------------------------------------------
+      case 'p':
+        ParseCoreValues(optarg, storeBufferSizes);
+        break;
+
+      // -----------------------------------------------------------------------
+      // core model (ooo or interval)
+      // -----------------------------------------------------------------------
+      case 'q':
+        coreModel = optarg;
+        break;
+
+      // -----------------------------------------------------------------------
+      // branch mispredictions per kilo instruction (interval model)
+      // -----------------------------------------------------------------------
+      case 'r':
+        ParseCoreValues(optarg, branchMPKIs);
+        break;
+
+      // -----------------------------------------------------------------------
+      // branch misprediction penalty (interval model)
+      // -----------------------------------------------------------------------
+      case 's':
+        ParseCoreValues(optarg, branchPenalties);
+        break;
+
+      // -----------------------------------------------------------------------
+      // formats of the statistics files (comma separated list of binary, csv
+      // and json). statistics are snapshot at each heart beat
+      // -----------------------------------------------------------------------
+      case 't':
+        statsFormats = optarg;
+        break;
+
+      // -----------------------------------------------------------------------
+      // latency histograms of the components
+      // -----------------------------------------------------------------------
+      case 'u':
+        latencyHistograms = true;
+        break;
+
+      // -----------------------------------------------------------------------
+      // trace one in every so many cpu requests after the warm up
+      // -----------------------------------------------------------------------
+      case 'v':
+        traceSample = atoi(optarg);
         break;
 
     case 'k':
@@ -169,11 +255,39 @@ int main(int argc, char **argv) {
     c = getopt_long(argc, argv, "a:b:c:d:e:", cmd_options, &optindex);
   }
 
-  OoOTraceSimulator traceSim(numCPUs, simulatorDefinition, 
-                             simulatorConfiguration, oooWindow, traceFiles,
-                             folder, synthetic, workingSetSize, memGap);
+  // ---------------------------------------------------------------------------
+  // Get the parameters of each core
+  // ---------------------------------------------------------------------------
+
+  vector <CoreParameters> cores(numCPUs);
+  for (uint32 i = 0; i < numCPUs; i ++) {
+    cores[i].robSize = CoreValue(robSizes, i, 1);
+    cores[i].width = CoreValue(widths, i, 1);
+    cores[i].loadQueueSize = CoreValue(loadQueueSizes, i, 0);
+    cores[i].storeBufferSize = CoreValue(storeBufferSizes, i, 0);
+    cores[i].branchMPKI = CoreValue(branchMPKIs, i, 0.0);
+    cores[i].branchPenalty = CoreValue(branchPenalties, i, 15);
+  }
+
+  OoOTraceSimulator *traceSim;
+  if (coreModel.compare("ooo") == 0)
+    traceSim = new OoOTraceSimulator(numCPUs, simulatorDefinition,
+        simulatorConfiguration, cores, traceFiles, folder, synthetic,
+        workingSetSize, memGap);
+  else if (coreModel.compare("interval") == 0)
+    traceSim = new IntervalTraceSimulator(numCPUs, simulatorDefinition,
+        simulatorConfiguration, cores, traceFiles, folder, synthetic,
+        workingSetSize, memGap);
+  else {
+    cerr << "Unknown core model `" << coreModel << "'" << endl;
+    return 1;
+  }
 
-  traceSim.StartSimulation();
-  traceSim.RunSimulation(warmUp, runTime, heartBeat);
+  traceSim -> SetStatsFormats(statsFormats);
+  if (latencyHistograms)
+    traceSim -> EnableLatencyHistograms();
+  traceSim -> SetTraceSample(traceSample);
+  traceSim -> StartSimulation();
+  traceSim -> RunSimulation(warmUp, runTime, heartBeat);
   return 0;
 }
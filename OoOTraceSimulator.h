@@ -17,6 +17,7 @@
 // -----------------------------------------------------------------------------
 
 #include "MemorySimulator.h"
+#include "InstructionWindow.h"
 #include "TraceReader.h"
 #include "Types.h"
 #include "SyntheticTrace.h"
@@ -46,13 +47,19 @@ using namespace std;
 // -----------------------------------------------------------------------------
 // Class: OoOTraceSimulator
 // Description:
-//    Defines a trace simulator with crude out-of-order model. 
+//    Defines a trace simulator with crude out-of-order model. Every cycle of
+//    a processor is attributed to a cause of its cpi stack. Cycles in which
+//    it retires instructions at its width are base cycles. The rest are
+//    stalls on the request at the head of the window, split into the cycles
+//    the request waited for a free MSHR, the cycles its issue was delayed by
+//    a full load queue or store buffer, and the rest, which go to the
+//    deepest level of the hierarchy the request reached.
 // Parameters:
 //    - simulator definition (to pass to the memory simulator)
 //    - simulator configuration (to pass to the memory simulator)
 //    - number of cpus
 //    - trace files
-//    - out-of-order window
+//    - core parameters (rob size, width, load queue, store buffer) per cpu
 // -----------------------------------------------------------------------------
 
 class OoOTraceSimulator {
@@ -68,7 +75,6 @@ class OoOTraceSimulator {
     string _simulationFolder;
     uint32 _numCPUs;
     vector <string> _traceFiles;
-    uint32 _oooWindow;
   bool _synthetic;
   uint32 _workingSetSize;
   uint32 _memGap;
@@ -90,8 +96,30 @@ class OoOTraceSimulator {
       // checkpoint at finish
       uint64 finishIcount;
       cycles_t finishCycle;
-      // list of outstanding requests
-      list <MemoryRequest *> outstanding;
+      // core parameters
+      CoreParameters params;
+      // window of outstanding requests. the last entry is the next request
+      // to be issued
+      RequestWindow outstanding;
+      // retire slots left over from the previous retirement
+      uint64 retireCarry;
+      // issue blocked by the load queue or store buffer
+      bool queueStall;
+      // cycles of each cause of the cpi stack, and their values at the end
+      // of the warm up and at the last heart beat
+      vector <cycles_t> cpiStack;
+      vector <cycles_t> cpiCheckpoint;
+      vector <cycles_t> cpiHeartBeat;
+      uint64 heartBeatIcount;
+    };
+
+    // causes of the cpi stack. the stall on each level of the hierarchy
+    // follows CPI_LEVELS
+    enum {
+      CPI_BASE,
+      CPI_MSHR_FULL,
+      CPI_WINDOW_FULL,
+      CPI_LEVELS
     };
 
     MemorySimulator _simulator;
@@ -116,14 +144,124 @@ class OoOTraceSimulator {
     // progress file
     FILE *_progress;
 
+    // cpi stack files, at the end of simulation and at each heart beat
+    FILE *_cpiFile;
+    FILE *_cpiIntervalFile;
+    vector <vector <string> > _cpiNames;
+
 #define PROGRESS_LEAP 10000000
 
 
+    // -------------------------------------------------------------------------
+    // Function to check if the next request of a processor can be issued. It
+    // has to fit in the reorder buffer and the load queue or store buffer.
+    // -------------------------------------------------------------------------
+
+    bool CanIssue(uint32 cpuID) {
+      ProcInfo &proc = _procs[cpuID];
+      MemoryRequest *next = proc.outstanding.back();
+      if ((next -> icount - proc.outstanding.front() -> icount) >=
+          proc.params.robSize)
+        return false;
+      if (!proc.outstanding.CanIssue(next, proc.params)) {
+        proc.queueStall = true;
+        return false;
+      }
+      return true;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to attribute the stall cycles of a processor to the causes of
+    // the cpi stack. A full MSHR and a full load queue or store buffer are
+    // charged the cycles they delayed the head request by, up to the stall
+    // -------------------------------------------------------------------------
+
+    void AccountStall(ProcInfo &proc, MemoryRequest *head, cycles_t stall) {
+      cycles_t mshr = min(stall, head -> mshrStallCycles);
+      cycles_t window = min(stall - mshr, head -> windowStallCycles);
+      proc.cpiStack[CPI_MSHR_FULL] += mshr;
+      proc.cpiStack[CPI_WINDOW_FULL] += window;
+      proc.cpiStack[CPI_LEVELS + head -> serviceLevel] +=
+        stall - mshr - window;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to write the cpi stack of a processor since a checkpoint. One
+    // line per cause
+    // -------------------------------------------------------------------------
+
+    void WriteCPIStack(FILE *file, const char *prefix, uint32 cpuID,
+        const vector <cycles_t> &since, uint64 instructions) {
+      ProcInfo &proc = _procs[cpuID];
+      for (uint32 i = 0; i < proc.cpiStack.size(); i ++) {
+        cycles_t cycles = proc.cpiStack[i] - since[i];
+        fprintf(file, "%s%u %s %llu %.4lf\n", prefix, cpuID,
+            _cpiNames[cpuID][i].c_str(), cycles,
+            instructions == 0 ? 0.0 : (double)cycles / instructions);
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to write the cpi stack of each processor since the last heart
+    // beat
+    // -------------------------------------------------------------------------
+
+    void CPIHeartBeat() {
+      char prefix[32];
+      sprintf(prefix, "%llu ", _simulator.CurrentCycle());
+      for (uint32 i = 0; i < _numCPUs; i ++) {
+        ProcInfo &proc = _procs[i];
+        WriteCPIStack(_cpiIntervalFile, prefix, i, proc.cpiHeartBeat,
+            proc.currentIcount - proc.heartBeatIcount);
+        proc.cpiHeartBeat = proc.cpiStack;
+        proc.heartBeatIcount = proc.currentIcount;
+      }
+      fflush(_cpiIntervalFile);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to name the causes of the cpi stack of each processor and open
+    // the cpi stack files
+    // -------------------------------------------------------------------------
+
+    void StartCPIStacks() {
+      _cpiNames.resize(_numCPUs);
+      for (uint32 i = 0; i < _numCPUs; i ++) {
+        vector <string> levels;
+        _simulator.HierarchyNames(i, levels);
+        _cpiNames[i].clear();
+        _cpiNames[i].push_back("base");
+        _cpiNames[i].push_back("mshr-full");
+        _cpiNames[i].push_back("window-full");
+        _cpiNames[i].insert(_cpiNames[i].end(), levels.begin(), levels.end());
+        if (levels.empty())
+          _cpiNames[i].push_back("memory");
+        _procs[i].cpiStack.assign(_cpiNames[i].size(), 0);
+        _procs[i].cpiCheckpoint = _procs[i].cpiStack;
+        _procs[i].cpiHeartBeat = _procs[i].cpiStack;
+        _procs[i].heartBeatIcount = 0;
+      }
+
+      string cpiFileName = _simulationFolder + "/sim.cpi";
+      _cpiFile = fopen(cpiFileName.c_str(), "w");
+      if (_cpiFile == NULL)
+        _cpiFile = stdout;
+      string cpiIntervalFileName = _simulationFolder + "/sim.cpi.intervals";
+      _cpiIntervalFile = fopen(cpiIntervalFileName.c_str(), "w");
+      if (_cpiIntervalFile == NULL)
+        _cpiIntervalFile = stdout;
+    }
+
+
     // -------------------------------------------------------------------------
     // Simulate Function
     // -------------------------------------------------------------------------
 
-    void Simulate() {
+    virtual void Simulate() {
 
       bitset <128> finished;
       bitset <128> warmUp;
@@ -147,6 +285,7 @@ class OoOTraceSimulator {
         if (_hbCount > 0) {
           if (_simulator.CurrentCycle() > _nextHeartBeatCycle) {
             _simulator.HeartBeat(_hbCount);
+            CPIHeartBeat();
             _nextHeartBeatCycle += _hbCount;
           }
         }
@@ -190,10 +329,23 @@ class OoOTraceSimulator {
             MemoryRequest *oldest = _procs[cpuID].outstanding.front();
             _procs[cpuID].outstanding.pop_front();
 
-            // compute the current cycle of the oldest request
-            oldest -> currentCycle = max(oldest -> currentCycle,
-                _procs[cpuID].currentCycle + oldest -> icount -
-                _procs[cpuID].currentIcount);
+            // compute the current cycle of the oldest request. the core
+            // retires up to width instructions per cycle
+            uint32 width = _procs[cpuID].params.width;
+            uint64 slots = oldest -> icount - _procs[cpuID].currentIcount +
+              _procs[cpuID].retireCarry;
+            cycles_t ready = _procs[cpuID].currentCycle + slots / width;
+            _procs[cpuID].cpiStack[CPI_BASE] +=
+              ready - _procs[cpuID].currentCycle;
+            if (oldest -> currentCycle > ready) {
+              AccountStall(_procs[cpuID], oldest,
+                  oldest -> currentCycle - ready);
+              _procs[cpuID].retireCarry = 0;
+            }
+            else {
+              oldest -> currentCycle = ready;
+              _procs[cpuID].retireCarry = slots % width;
+            }
 
             if (oldest -> icount > checkpoint[cpuID]) {
               fprintf(_progress, "P%u, %llu\n",
@@ -222,20 +374,33 @@ class OoOTraceSimulator {
             }
 
             // check if any more requests can be added to the queue
-            while (((_procs[cpuID].outstanding.back() -> icount) - 
-                  (_procs[cpuID].outstanding.front() -> icount)) < _oooWindow) {
-
-              _procs[cpuID].outstanding.back() -> issueCycle =
-                _procs[cpuID].currentCycle + 
-                _procs[cpuID].outstanding.back() -> icount - 
-                _procs[cpuID].currentIcount - _oooWindow;
+            while (CanIssue(cpuID)) {
+
+              MemoryRequest *next = _procs[cpuID].outstanding.back();
+              int64 lag = (int64)(next -> icount -
+                  _procs[cpuID].currentIcount) -
+                (int64)_procs[cpuID].params.robSize;
+              int64 issue = (int64)_procs[cpuID].currentCycle +
+                lag / (int64)_procs[cpuID].params.width;
+              next -> issueCycle = (cycles_t)max(issue, (int64)0);
+
+              // if the request waited for the load queue or store buffer, it
+              // cannot be issued before the entry was freed
+              if (_procs[cpuID].queueStall) {
+                if (_procs[cpuID].currentCycle > next -> issueCycle)
+                  next -> windowStallCycles =
+                    _procs[cpuID].currentCycle - next -> issueCycle;
+                next -> issueCycle = max(next -> issueCycle,
+                    _procs[cpuID].currentCycle);
+                _procs[cpuID].queueStall = false;
+              }
 
-              _procs[cpuID].outstanding.back() -> currentCycle = 
-                _procs[cpuID].outstanding.back() -> issueCycle;
+              next -> currentCycle = next -> issueCycle;
 
               // push it to the queue and send to the simulator
-              _queue.push(_procs[cpuID].outstanding.back());
-              _simulator.ProcessMemoryRequest(_procs[cpuID].outstanding.back());
+              _queue.push(next);
+              _simulator.ProcessMemoryRequest(next);
+              _procs[cpuID].outstanding.MarkIssued(next);
 
               // get the next request for the processor
               if (_synthetic)
@@ -261,6 +426,7 @@ class OoOTraceSimulator {
                   case WARM_UP:
                     _procs[cpuID].checkpointIcount = _procs[cpuID].currentIcount;
                     _procs[cpuID].checkpointCycle = _procs[cpuID].currentCycle;
+                    _procs[cpuID].cpiCheckpoint = _procs[cpuID].cpiStack;
                     warmUpMilestone = true;
                     _mIndex[cpuID] ++;
                     warmUp.set(cpuID);
@@ -283,6 +449,11 @@ class OoOTraceSimulator {
                           _procs[cpuID].currentCycle - 
                           _procs[cpuID].checkpointCycle);
                       fflush(_ipcFile);
+                      WriteCPIStack(_cpiFile, "", cpuID,
+                          _procs[cpuID].cpiCheckpoint,
+                          _procs[cpuID].currentIcount -
+                          _procs[cpuID].checkpointIcount);
+                      fflush(_cpiFile);
                     }
                     break;
                 }
@@ -302,14 +473,13 @@ class OoOTraceSimulator {
     // -------------------------------------------------------------------------
 
     OoOTraceSimulator(uint32 numCPUs, string simulatorDefinition, 
-        string simulatorConfiguration, uint32 oooWindow, 
+        string simulatorConfiguration, const vector <CoreParameters> &cores,
                       const vector <string> &traceFiles, string simulationFolder,
                       bool synthetic, uint32 workingSetSize, uint32 memGap) {
 
       _numCPUs = numCPUs;
       _simulatorDefinition = simulatorDefinition;
       _simulatorConfiguration = simulatorConfiguration;
-      _oooWindow = oooWindow;
       _simulationFolder = simulationFolder;
 
       _synthetic = synthetic;
@@ -322,6 +492,16 @@ class OoOTraceSimulator {
       _procs.resize(_numCPUs);
       _mIndex.resize(_numCPUs, 0);
 
+      // the window holds at most one request per instruction in the reorder
+      // buffer and the next request to be issued
+      for (uint32 i = 0; i < _numCPUs; i ++) {
+        _procs[i].params = cores[i];
+        assert(_procs[i].params.robSize > 0 && _procs[i].params.width > 0);
+        _procs[i].outstanding.SetCapacity(_procs[i].params.robSize + 1);
+        _procs[i].retireCarry = 0;
+        _procs[i].queueStall = false;
+      }
+
       if (!synthetic) {
         for (uint32 i = 0; i < _numCPUs; i ++)
           _traceFiles[i] = traceFiles[i];
@@ -339,6 +519,38 @@ class OoOTraceSimulator {
       _progress = fopen(progressFileName.c_str(), "w");
       if (_progress == NULL)
         _progress = stdout;
+
+      _cpiFile = NULL;
+      _cpiIntervalFile = NULL;
+    }
+
+    virtual ~OoOTraceSimulator() {}
+
+
+    // -------------------------------------------------------------------------
+    // Function to set the formats of the statistics files
+    // -------------------------------------------------------------------------
+
+    void SetStatsFormats(string formats) {
+      _simulator.SetStatsFormats(formats);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to turn on the latency histograms of the components
+    // -------------------------------------------------------------------------
+
+    void EnableLatencyHistograms() {
+      _simulator.EnableLatencyHistograms();
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to trace one in sample cpu requests
+    // -------------------------------------------------------------------------
+
+    void SetTraceSample(uint32 sample) {
+      _simulator.SetTraceSample(sample);
     }
 
 
@@ -346,12 +558,14 @@ class OoOTraceSimulator {
     // Function to start the simulation
     // -------------------------------------------------------------------------
 
-    void StartSimulation() {
+    virtual void StartSimulation() {
 
       // start the simulator
       _simulator.SetStartCycle(0);
       _simulator.StartSimulation();
 
+      StartCPIStacks();
+
       // open the trace readers
       if (!_synthetic) {
         for (uint32 i = 0; i < _numCPUs; i ++)
@@ -389,11 +603,11 @@ class OoOTraceSimulator {
         _procs[i].outstanding.push_back(request);
 
         // while there is room in the out-of-order window
-        while (((_procs[i].outstanding.back() -> icount) - 
-            (_procs[i].outstanding.front() -> icount)) < _oooWindow) {
+        while (CanIssue(i)) {
 
           _queue.push(_procs[i].outstanding.back());
           _simulator.ProcessMemoryRequest(_procs[i].outstanding.back());
+          _procs[i].outstanding.MarkIssued(_procs[i].outstanding.back());
 
 	// **** Are we completing the simulation here?
 
@@ -408,7 +622,7 @@ class OoOTraceSimulator {
             assert(false && "No requests from processor");
           }
 
-          request -> issueCycle = request -> icount;
+          request -> issueCycle = request -> icount / _procs[i].params.width;
           request -> currentCycle = request -> issueCycle;
           _procs[i].outstanding.push_back(request);
         }
@@ -420,7 +634,7 @@ class OoOTraceSimulator {
     // Function to run the simulation
     // -------------------------------------------------------------------------
     
-    void RunSimulation(uint64 warmUp, uint64 mainRun, uint64 hbCount) {
+    virtual void RunSimulation(uint64 warmUp, uint64 mainRun, uint64 hbCount) {
     
       _hbCount = hbCount;
       _nextHeartBeatCycle = _hbCount;
@@ -438,6 +652,10 @@ class OoOTraceSimulator {
 
       fclose(_ipcFile);
       fclose(_progress);
+      if (_cpiFile != NULL && _cpiFile != stdout)
+        fclose(_cpiFile);
+      if (_cpiIntervalFile != NULL && _cpiIntervalFile != stdout)
+        fclose(_cpiIntervalFile);
     }
     
 };
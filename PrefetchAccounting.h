@@ -0,0 +1,365 @@
+// -----------------------------------------------------------------------------
+// File: PrefetchAccounting.h
+// Description:
+//    Defines a prefetch accounting module that caches attach. It classifies
+//    the prefetches that fill the cache, per cpu and prefetcher id, and
+//    writes the breakdown to a file at the end of simulation.
+// -----------------------------------------------------------------------------
+
+#ifndef __PREFETCH_ACCOUNTING_H__
+#define __PREFETCH_ACCOUNTING_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "MemoryComponent.h"
+#include "MemoryRequest.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+
+
+// -----------------------------------------------------------------------------
+// Structure: PrefetchTag
+// Description:
+//    Per block state of the accounting module. Tag entries of the caches
+//    that attach the module carry one.
+// -----------------------------------------------------------------------------
+
+struct PrefetchTag {
+  // filled by a prefetch and not yet demanded
+  bool prefetched;
+  uint32 cpuID;
+  uint32 prefID;
+  cycles_t fillCycle;
+  PrefetchTag() { prefetched = false; }
+};
+
+
+// -----------------------------------------------------------------------------
+// Class: PrefetchAccounting
+// Description:
+//    Classifies each prefetch fill as
+//    - timely: a demand hits the block
+//    - late: a demand that missed while the prefetch was in flight (merged
+//      with it in an MSHR below) returns to find the block
+//    - early: the block is evicted unused and demanded again while it is in
+//      the evicted-table
+//    - useless: the block is evicted unused and is not demanded again
+//    Pollution is detected with shadow tags of a few sampled sets that only
+//    demands fill (LRU). A demand miss that hits in the shadow tags, to a
+//    block that a prefetch fill evicted, is a pollution miss of that
+//    prefetcher.
+//
+//    The owner forwards its parameters, calls Start when simulation starts,
+//    Reset when warm up ends and Write when simulation ends, and reports
+//    demand lookups, fills, returns to present blocks and evictions. The
+//    module is off unless prefetch-accounting is set, in which case the owner
+//    skips the calls.
+// -----------------------------------------------------------------------------
+
+class PrefetchAccounting {
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  bool _enabled;
+  uint32 _shadowSets;
+  uint32 _evictedTableSize;
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  struct Counts {
+    uint64 fills;
+    uint64 timely;
+    uint64 late;
+    uint64 early;
+    uint64 useless;
+    uint64 pollution;
+    uint64 useCycles;
+    Counts() {
+      fills = timely = late = early = useless = pollution = useCycles = 0;
+    }
+  };
+
+  // block and the prefetch that filled or evicted it. blocks are stored plus
+  // one, 0 is empty
+  struct BlockOwner {
+    addr_t block;
+    uint32 cpuID;
+    uint32 prefID;
+  };
+
+  uint32 _numSets;
+  uint32 _associativity;
+
+  // cycle at which warm up ended. blocks filled before are not counted
+  cycles_t _since;
+
+  // counts of each cpu, indexed by prefetcher id
+  vector <vector <Counts> > _counts;
+
+  // unused prefetched blocks that were evicted. direct mapped
+  vector <BlockOwner> _evicted;
+
+  // shadow tags of the sampled sets, MRU first, and the blocks that
+  // prefetch fills evicted from the sampled sets
+  uint32 _shadowStride;
+  vector <vector <addr_t> > _shadow;
+  vector <vector <BlockOwner> > _victims;
+  vector <uint32> _victimNext;
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor
+  // -------------------------------------------------------------------------
+
+  PrefetchAccounting() {
+    _enabled = false;
+    _shadowSets = 32;
+    _evictedTableSize = 4096;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter. Returns false if the parameter is not one
+  // of the module.
+  // -------------------------------------------------------------------------
+
+  bool AddParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      CMP_PARAMETER_BOOLEAN("prefetch-accounting", _enabled)
+      CMP_PARAMETER_UINT("accounting-shadow-sets", _shadowSets)
+      CMP_PARAMETER_UINT("accounting-evicted-size", _evictedTableSize)
+      else return false;
+
+    return true;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to check if the module is on
+  // -------------------------------------------------------------------------
+
+  bool Enabled() {
+    return _enabled;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to set up the module for a cache
+  // -------------------------------------------------------------------------
+
+  void Start(uint32 numCPUs, uint32 numSets, uint32 associativity) {
+    if (!_enabled) return;
+
+    _numSets = numSets;
+    _associativity = associativity;
+    _since = 0;
+    _counts.assign(numCPUs, vector <Counts> ());
+
+    BlockOwner empty;
+    empty.block = 0;
+    _evicted.assign(max(_evictedTableSize, 1U), empty);
+
+    uint32 sampled = min(_shadowSets, _numSets);
+    _shadowStride = (sampled == 0 ? 0 : _numSets / sampled);
+    _shadow.assign(sampled, vector <addr_t> (_associativity, 0));
+    _victims.assign(sampled, vector <BlockOwner> (_associativity, empty));
+    _victimNext.assign(sampled, 0);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to reset the counts when warm up ends
+  // -------------------------------------------------------------------------
+
+  void Reset(cycles_t now) {
+    if (!_enabled) return;
+    _since = now;
+    for (uint32 i = 0; i < _counts.size(); i ++)
+      _counts[i].assign(_counts[i].size(), Counts());
+    for (uint32 i = 0; i < _evicted.size(); i ++)
+      _evicted[i].block = 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called on a demand lookup. tag is the block's state on a hit
+  // and NULL on a miss
+  // -------------------------------------------------------------------------
+
+  void Demand(MemoryRequest *request, addr_t block, PrefetchTag *tag) {
+
+    if (tag != NULL) {
+      if (tag -> prefetched && tag -> fillCycle >= _since) {
+        Counts &counts = Row(tag -> cpuID, tag -> prefID);
+        counts.timely ++;
+        counts.useCycles += request -> currentCycle - tag -> fillCycle;
+      }
+      tag -> prefetched = false;
+    }
+    else {
+      BlockOwner &evicted = _evicted[block % _evicted.size()];
+      if (evicted.block == block + 1) {
+        Counts &counts = Row(evicted.cpuID, evicted.prefID);
+        counts.early ++;
+        counts.useless --;
+        evicted.block = 0;
+      }
+    }
+
+    // shadow tags of a sampled set
+    int32 sample = Sample(block);
+    if (sample < 0) return;
+
+    vector <addr_t> &shadow = _shadow[sample];
+    uint32 way = 0;
+    while (way + 1 < _associativity && shadow[way] != block + 1) way ++;
+    bool shadowHit = (shadow[way] == block + 1);
+    for (; way > 0; way --)
+      shadow[way] = shadow[way - 1];
+    shadow[0] = block + 1;
+
+    if (tag != NULL || !shadowHit) return;
+
+    vector <BlockOwner> &victims = _victims[sample];
+    for (uint32 i = 0; i < victims.size(); i ++) {
+      if (victims[i].block == block + 1) {
+        Row(victims[i].cpuID, victims[i].prefID).pollution ++;
+        victims[i].block = 0;
+        break;
+      }
+    }
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when a returning request fills a block
+  // -------------------------------------------------------------------------
+
+  void Fill(MemoryRequest *request, PrefetchTag &tag) {
+    tag.prefetched = (request -> type == MemoryRequest::PREFETCH);
+    if (!tag.prefetched) return;
+
+    tag.cpuID = request -> cpuID;
+    tag.prefID = request -> prefetcherID;
+    tag.fillCycle = request -> currentCycle;
+    Row(tag.cpuID, tag.prefID).fills ++;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when a returning request finds its block present
+  // -------------------------------------------------------------------------
+
+  void Return(MemoryRequest *request, PrefetchTag &tag) {
+    if (!tag.prefetched || request -> type == MemoryRequest::PREFETCH)
+      return;
+    if (request -> type != MemoryRequest::READ &&
+        request -> type != MemoryRequest::READ_FOR_WRITE)
+      return;
+
+    if (tag.fillCycle >= _since)
+      Row(tag.cpuID, tag.prefID).late ++;
+    tag.prefetched = false;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function called when a block is evicted. request is the one whose fill
+  // evicted it
+  // -------------------------------------------------------------------------
+
+  void Evict(addr_t block, PrefetchTag &tag, MemoryRequest *request) {
+
+    if (tag.prefetched && tag.fillCycle >= _since) {
+      Row(tag.cpuID, tag.prefID).useless ++;
+      BlockOwner &evicted = _evicted[block % _evicted.size()];
+      evicted.block = block + 1;
+      evicted.cpuID = tag.cpuID;
+      evicted.prefID = tag.prefID;
+    }
+
+    if (request -> type != MemoryRequest::PREFETCH) return;
+
+    int32 sample = Sample(block);
+    if (sample < 0) return;
+
+    BlockOwner &victim = _victims[sample][_victimNext[sample]];
+    _victimNext[sample] = (_victimNext[sample] + 1) % _associativity;
+    victim.block = block + 1;
+    victim.cpuID = request -> cpuID;
+    victim.prefID = request -> prefetcherID;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to write the breakdown, one row per cpu and prefetcher id that
+  // filled or polluted the cache
+  // -------------------------------------------------------------------------
+
+  void Write(string fileName) {
+    if (!_enabled) return;
+
+    FILE *file = fopen(fileName.c_str(), "w");
+    assert(file != NULL);
+    fprintf(file, "cpu,prefetcher,fills,timely,late,early,useless,pollution,"
+            "accuracy,avg-use-cycles\n");
+    for (uint32 cpu = 0; cpu < _counts.size(); cpu ++) {
+      for (uint32 id = 0; id < _counts[cpu].size(); id ++) {
+        Counts &c = _counts[cpu][id];
+        if (c.fills == 0 && c.pollution == 0) continue;
+        fprintf(file, "%u,%u,%llu,%llu,%llu,%llu,%llu,%llu,%.3lf,%.1lf\n",
+                cpu, id, c.fills, c.timely, c.late, c.early, c.useless,
+                c.pollution,
+                c.fills == 0 ? 0.0 : (double)(c.timely + c.late) / c.fills,
+                c.timely == 0 ? 0.0 : (double)c.useCycles / c.timely);
+      }
+    }
+    fclose(file);
+  }
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to get the counts of a cpu and prefetcher id
+  // -------------------------------------------------------------------------
+
+  Counts &Row(uint32 cpuID, uint32 prefID) {
+    vector <Counts> &row = _counts[cpuID];
+    if (prefID >= row.size())
+      row.resize(prefID + 1);
+    return row[prefID];
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to get the shadow tags of a block's set. -1 if the set is not
+  // sampled
+  // -------------------------------------------------------------------------
+
+  int32 Sample(addr_t block) {
+    if (_shadowStride == 0) return -1;
+    uint32 set = block % _numSets;
+    if (set % _shadowStride != 0 || set / _shadowStride >= _shadow.size())
+      return -1;
+    return set / _shadowStride;
+  }
+};
+
+#endif // __PREFETCH_ACCOUNTING_H__
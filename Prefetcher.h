@@ -0,0 +1,274 @@
+// -----------------------------------------------------------------------------
+// File: Prefetcher.h
+// Description:
+//    Defines the base class of the prefetchers. Prefetchers hand every
+//    prefetch they generate to an issue queue, which drops redundant
+//    prefetches, limits the prefetch issue rate and chooses the level that
+//    the prefetched block fills. All of it is off by default, in which case
+//    prefetches are sent as soon as they are generated.
+// -----------------------------------------------------------------------------
+
+#ifndef __PREFETCHER_H__
+#define __PREFETCHER_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "MemoryComponent.h"
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+
+
+// -----------------------------------------------------------------------------
+// Class: Prefetcher
+// Description:
+//    Prefetcher with an issue queue. In order, a prefetch is dropped if
+//    - it is in the recent-prefetch filter (filter-size entries, direct
+//      mapped)
+//    - the first cache below the prefetcher holds the block (filter-cached)
+//    - the first MSHR below the prefetcher has a miss outstanding for the
+//      block (filter-in-flight)
+//    - that MSHR has max-mshr-occupancy or more misses outstanding
+//    - the issue queue is full (queue-size prefetches waiting)
+//    The queue issues issue-rate prefetches per cycle, and is modeled by the
+//    cycle of its next free issue slot, so it needs no events of its own.
+//
+//    fill-level is the number of components above the prefetcher that a
+//    returning prefetch continues to, filling the caches among them. With the
+//    prefetcher below l2-mshr, 2 fills the L2.
+// -----------------------------------------------------------------------------
+
+class Prefetcher : public MemoryComponent {
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Parameters
+  // -------------------------------------------------------------------------
+
+  uint32 _filterSize;
+  bool _filterCached;
+  bool _filterInFlight;
+  uint32 _maxMSHROccupancy;
+  uint32 _queueSize;
+  uint32 _issueRate;
+  uint32 _fillLevel;
+
+  // -------------------------------------------------------------------------
+  // Private members
+  // -------------------------------------------------------------------------
+
+  // recent-prefetch filter. holds block numbers plus one, 0 is empty
+  vector <addr_t> _recentFilter;
+
+  // first cache and MSHR below the prefetcher in each cpu's hierarchy
+  vector <bool> _belowKnown;
+  vector <MemoryComponent *> _cacheBelow;
+  vector <MemoryComponent *> _mshrBelow;
+
+  // next issue slot: cycle and prefetches already issued in that cycle
+  cycles_t _issueCycle;
+  uint32 _issuedInCycle;
+
+  // -------------------------------------------------------------------------
+  // Declare Counters
+  // -------------------------------------------------------------------------
+
+  NEW_COUNTER(queue_requests);
+  NEW_COUNTER(queue_issued);
+  NEW_COUNTER(queue_filtered_recent);
+  NEW_COUNTER(queue_filtered_cached);
+  NEW_COUNTER(queue_filtered_in_flight);
+  NEW_COUNTER(queue_dropped_mshr);
+  NEW_COUNTER(queue_dropped_full);
+  NEW_COUNTER(queue_delay_cycles);
+
+public:
+
+  // -------------------------------------------------------------------------
+  // Constructor
+  // -------------------------------------------------------------------------
+
+  Prefetcher() {
+    _filterSize = 0;
+    _filterCached = false;
+    _filterInFlight = false;
+    _maxMSHROccupancy = 0;
+    _queueSize = 0;
+    _issueRate = 0;
+    _fillLevel = 0;
+    _issueCycle = 0;
+    _issuedInCycle = 0;
+  }
+
+
+protected:
+
+  // -------------------------------------------------------------------------
+  // Function to add a parameter of the issue queue. Returns false if the
+  // parameter is not one.
+  // -------------------------------------------------------------------------
+
+  bool AddQueueParameter(string pname, string pvalue) {
+
+    CMP_PARAMETER_BEGIN
+
+      CMP_PARAMETER_UINT("filter-size", _filterSize)
+      CMP_PARAMETER_BOOLEAN("filter-cached", _filterCached)
+      CMP_PARAMETER_BOOLEAN("filter-in-flight", _filterInFlight)
+      CMP_PARAMETER_UINT("max-mshr-occupancy", _maxMSHROccupancy)
+      CMP_PARAMETER_UINT("queue-size", _queueSize)
+      CMP_PARAMETER_UINT("issue-rate", _issueRate)
+      CMP_PARAMETER_UINT("fill-level", _fillLevel)
+      else return false;
+
+    return true;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to initialize the statistics of the issue queue
+  // -------------------------------------------------------------------------
+
+  void InitializeQueueStatistics() {
+    INITIALIZE_COUNTER(queue_requests, "Prefetches handed to the issue queue")
+    INITIALIZE_COUNTER(queue_issued, "Prefetches issued")
+    INITIALIZE_COUNTER(queue_filtered_recent, "Prefetches in the recent filter")
+    INITIALIZE_COUNTER(queue_filtered_cached, "Prefetches to cached blocks")
+    INITIALIZE_COUNTER(queue_filtered_in_flight, "Prefetches to blocks in flight")
+    INITIALIZE_COUNTER(queue_dropped_mshr, "Prefetches dropped for MSHR occupancy")
+    INITIALIZE_COUNTER(queue_dropped_full, "Prefetches dropped on a full queue")
+    INITIALIZE_COUNTER(queue_delay_cycles, "Cycles prefetches waited to issue")
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to set up the issue queue when simulation starts
+  // -------------------------------------------------------------------------
+
+  void StartQueue() {
+    _recentFilter.assign(_filterSize, 0);
+    _belowKnown.assign(_numCPUs, false);
+    _cacheBelow.assign(_numCPUs, (MemoryComponent *)NULL);
+    _mshrBelow.assign(_numCPUs, (MemoryComponent *)NULL);
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to queue a prefetch of size bytes triggered by a request.
+  // Returns true if the prefetch is issued.
+  // -------------------------------------------------------------------------
+
+  bool IssuePrefetch(MemoryRequest *request, addr_t vaddr, addr_t paddr,
+                     uint32 size, uint32 prefetcherID) {
+
+    INCREMENT(queue_requests);
+
+    // recent-prefetch filter
+    if (_filterSize != 0) {
+      addr_t block = vaddr / size + 1;
+      addr_t &slot = _recentFilter[(block * 0x9E3779B97F4A7C15ULL >> 32) %
+                                   _filterSize];
+      if (slot == block) {
+        INCREMENT(queue_filtered_recent);
+        return false;
+      }
+      slot = block;
+    }
+
+    // cache and MSHR below
+    if (_filterCached || _filterInFlight || _maxMSHROccupancy != 0) {
+      FindBelow(request);
+      MemoryComponent *cache = _cacheBelow[request -> cpuID];
+      MemoryComponent *mshr = _mshrBelow[request -> cpuID];
+
+      if (_filterCached && cache != NULL && cache -> HoldsBlock(vaddr, paddr)) {
+        INCREMENT(queue_filtered_cached);
+        return false;
+      }
+      if (_filterInFlight && mshr != NULL && mshr -> HasOutstandingMiss(paddr)) {
+        INCREMENT(queue_filtered_in_flight);
+        return false;
+      }
+      if (_maxMSHROccupancy != 0 && mshr != NULL &&
+          mshr -> OutstandingMisses() >= _maxMSHROccupancy) {
+        INCREMENT(queue_dropped_mshr);
+        return false;
+      }
+    }
+
+    // issue slot
+    cycles_t now = request -> currentCycle;
+    cycles_t issue = now;
+    if (_issueRate != 0) {
+      if (_issueCycle < now) {
+        _issueCycle = now;
+        _issuedInCycle = 0;
+      }
+      if (_issuedInCycle == _issueRate) {
+        _issueCycle ++;
+        _issuedInCycle = 0;
+      }
+      if (_queueSize != 0 &&
+          (_issueCycle - now) * _issueRate + _issuedInCycle >= _queueSize) {
+        INCREMENT(queue_dropped_full);
+        return false;
+      }
+      issue = _issueCycle;
+      _issuedInCycle ++;
+      ADD_TO_COUNTER(queue_delay_cycles, issue - now);
+    }
+
+    MemoryRequest *prefetch =
+      new MemoryRequest(MemoryRequest::COMPONENT, request -> cpuID, this,
+                        MemoryRequest::PREFETCH, request -> cmpID,
+                        vaddr, paddr, size, issue);
+    prefetch -> icount = request -> icount;
+    prefetch -> ip = request -> ip;
+    prefetch -> prefetcherID = prefetcherID;
+    if (_fillLevel != 0)
+      prefetch -> fillCmpID = max(request -> cmpID - (int32)_fillLevel, 0);
+
+    INCREMENT(queue_issued);
+    SendToNextComponent(prefetch);
+    return true;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to check if a returning request of this component goes on to
+  // fill the levels above it
+  // -------------------------------------------------------------------------
+
+  bool FillsAbove(MemoryRequest *request) {
+    return request -> fillCmpID >= 0;
+  }
+
+
+  // -------------------------------------------------------------------------
+  // Function to find the first cache and MSHR below the prefetcher in the
+  // hierarchy of the request's cpu
+  // -------------------------------------------------------------------------
+
+  void FindBelow(MemoryRequest *request) {
+    uint32 cpu = request -> cpuID;
+    if (_belowKnown[cpu]) return;
+    _belowKnown[cpu] = true;
+
+    vector <MemoryComponent *> &hier = (*_hier)[cpu];
+    for (uint32 i = request -> cmpID + 1; i < hier.size(); i ++) {
+      if (_cacheBelow[cpu] == NULL && hier[i] -> IsCache())
+        _cacheBelow[cpu] = hier[i];
+      if (_mshrBelow[cpu] == NULL && hier[i] -> IsMSHR())
+        _mshrBelow[cpu] = hier[i];
+    }
+  }
+};
+
+#endif // __PREFETCHER_H__
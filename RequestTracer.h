@@ -0,0 +1,264 @@
+// -----------------------------------------------------------------------------
+// File: RequestTracer.h
+// Description:
+//    Defines the request tracer. It records the events of sampled requests at
+//    each component into a binary trace file.
+// -----------------------------------------------------------------------------
+
+#ifndef __REQUEST_TRACER_H__
+#define __REQUEST_TRACER_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+#include <pthread.h>
+
+using namespace std;
+
+
+// -----------------------------------------------------------------------------
+// Structure: TraceRecord
+// Description:
+//    One event of a traced request. 16 bytes, written as is
+// -----------------------------------------------------------------------------
+
+struct TraceRecord {
+  cycles_t cycle;
+  uint32 traceID;
+  uint16 component;
+  uint8 cpuID;
+  // event in the low nibble, request type in the high nibble
+  uint8 event;
+};
+
+
+// -----------------------------------------------------------------------------
+// Class: RequestTracer
+// Description:
+//    Records the events of sampled requests. The events of a request at a
+//    component are
+//    - ARRIVE: added to the component's queue on its way down
+//    - PROCESS: the component starts to process it (again after a stall)
+//    - FORWARD: sent to the next component down
+//    - RETURN: added to the component's queue on its way back, or serviced
+//      by the last component
+//    - DEPART: leaves the component on its way back, or is deleted by it
+//    The first ARRIVE to the first PROCESS is queueing time. A miss that an
+//    MSHR creates for a traced request carries its trace id, so its events
+//    are those of the request below the MSHR.
+//
+//    Records go to a ring of buffers. A full buffer is handed to a writer
+//    thread, and the simulator only waits if the writer falls a whole ring
+//    behind.
+//
+//    File format (host byte order):
+//      char   magic[8]          "CMPTRACE"
+//      uint32 version           1
+//      uint32 numComponents
+//      numComponents times: uint16 length, name
+//      uint32 numCPUs
+//      numCPUs times: uint32 levels, uint16 component[levels]
+//      TraceRecord records until the end of the file
+// -----------------------------------------------------------------------------
+
+class RequestTracer {
+
+  public:
+
+    enum Event {
+      ARRIVE = 0,
+      PROCESS = 1,
+      FORWARD = 2,
+      RETURN = 3,
+      DEPART = 4
+    };
+
+    static const uint32 BUFFER_RECORDS = 65536;
+    static const uint32 NUM_BUFFERS = 4;
+
+  protected:
+
+    FILE *_file;
+
+    // ring of buffers. the simulator fills buffer _fill, the writer writes
+    // buffers _write to _fill - 1
+    vector <vector <TraceRecord> > _buffers;
+    vector <uint32> _sizes;
+    uint32 _fill;
+    uint32 _write;
+    uint32 _position;
+    bool _done;
+
+    pthread_t _thread;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _filled;
+    pthread_cond_t _written;
+
+    uint64 _records;
+
+  public:
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+
+    RequestTracer() {
+      _file = NULL;
+      _records = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to open the trace file, write its header and start the
+    // writer. hier holds the component index of each level for each cpu
+    // -------------------------------------------------------------------------
+
+    void Start(string fileName, vector <string> &components,
+        vector <vector <uint32> > &hier) {
+      _file = fopen(fileName.c_str(), "wb");
+      if (_file == NULL) {
+        fprintf(stderr, "Error: cannot open `%s'\n", fileName.c_str());
+        exit(-1);
+      }
+
+      fwrite("CMPTRACE", 1, 8, _file);
+      PutUInt32(1);
+      PutUInt32(components.size());
+      for (uint32 i = 0; i < components.size(); i ++) {
+        uint16 length = components[i].size();
+        fwrite(&length, sizeof(length), 1, _file);
+        fwrite(components[i].data(), 1, length, _file);
+      }
+      PutUInt32(hier.size());
+      for (uint32 i = 0; i < hier.size(); i ++) {
+        PutUInt32(hier[i].size());
+        for (uint32 j = 0; j < hier[i].size(); j ++) {
+          uint16 component = hier[i][j];
+          fwrite(&component, sizeof(component), 1, _file);
+        }
+      }
+
+      _buffers.assign(NUM_BUFFERS, vector <TraceRecord> (BUFFER_RECORDS));
+      _sizes.assign(NUM_BUFFERS, 0);
+      _fill = 0;
+      _write = 0;
+      _position = 0;
+      _done = false;
+
+      pthread_mutex_init(&_mutex, NULL);
+      pthread_cond_init(&_filled, NULL);
+      pthread_cond_init(&_written, NULL);
+      pthread_create(&_thread, NULL, Writer, this);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to record an event
+    // -------------------------------------------------------------------------
+
+    void Record(cycles_t cycle, uint32 traceID, uint32 component,
+        uint32 cpuID, uint32 event, uint32 type) {
+      TraceRecord &record = _buffers[_fill][_position];
+      record.cycle = cycle;
+      record.traceID = traceID;
+      record.component = component;
+      record.cpuID = cpuID;
+      record.event = event | (type << 4);
+      _records ++;
+      if (++ _position == BUFFER_RECORDS)
+        Handoff();
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to write the remaining records, stop the writer and close the
+    // file. Returns the number of records
+    // -------------------------------------------------------------------------
+
+    uint64 Finish() {
+      if (_file == NULL) return 0;
+      if (_position != 0)
+        Handoff();
+
+      pthread_mutex_lock(&_mutex);
+      _done = true;
+      pthread_cond_signal(&_filled);
+      pthread_mutex_unlock(&_mutex);
+      pthread_join(_thread, NULL);
+
+      pthread_mutex_destroy(&_mutex);
+      pthread_cond_destroy(&_filled);
+      pthread_cond_destroy(&_written);
+      fclose(_file);
+      _file = NULL;
+      return _records;
+    }
+
+
+  protected:
+
+    // -------------------------------------------------------------------------
+    // Function to hand the buffer being filled to the writer and move to the
+    // next one, waiting for it to be written if needed
+    // -------------------------------------------------------------------------
+
+    void Handoff() {
+      pthread_mutex_lock(&_mutex);
+      _sizes[_fill] = _position;
+      _fill = (_fill + 1) % NUM_BUFFERS;
+      pthread_cond_signal(&_filled);
+      while (_sizes[_fill] != 0)
+        pthread_cond_wait(&_written, &_mutex);
+      pthread_mutex_unlock(&_mutex);
+      _position = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Writer thread
+    // -------------------------------------------------------------------------
+
+    static void *Writer(void *arg) {
+      RequestTracer *tracer = (RequestTracer *)arg;
+
+      pthread_mutex_lock(&tracer -> _mutex);
+      while (true) {
+        while (tracer -> _sizes[tracer -> _write] == 0 && !tracer -> _done)
+          pthread_cond_wait(&tracer -> _filled, &tracer -> _mutex);
+        uint32 buffer = tracer -> _write;
+        uint32 size = tracer -> _sizes[buffer];
+        if (size == 0)
+          break;
+
+        // write without holding the lock
+        pthread_mutex_unlock(&tracer -> _mutex);
+        fwrite(&tracer -> _buffers[buffer][0], sizeof(TraceRecord), size,
+            tracer -> _file);
+        pthread_mutex_lock(&tracer -> _mutex);
+
+        tracer -> _sizes[buffer] = 0;
+        tracer -> _write = (buffer + 1) % NUM_BUFFERS;
+        pthread_cond_signal(&tracer -> _written);
+      }
+      pthread_mutex_unlock(&tracer -> _mutex);
+      return NULL;
+    }
+
+    void PutUInt32(uint32 value) {
+      fwrite(&value, sizeof(value), 1, _file);
+    }
+};
+
+#endif // __REQUEST_TRACER_H__
@@ -19,6 +19,7 @@ import commands
 import re
 from kvdata import KeyValueData
 from plotlib import PlotLib
+from stats_reader import read_stats, final_values
 
 # ------------------------------------------------------------------------------
 # DEFINITIONS
@@ -33,23 +34,36 @@ WORKLOAD_FOLDER = "Simulator/Workloads/"
 def parse_simulation_log(bench_folder):
 
     # --------------------------------------------------------------------------
-    # Open the main simulation log
+    # Read the statistics from the binary statistics file. Only runs without
+    # one fall back to the simulation log
     # --------------------------------------------------------------------------
 
-    fin = open(bench_folder + "/SimulationLog", "r")
-    data = {}
+    if os.path.exists(bench_folder + "/stats.bin"):
+        data = final_values(read_stats(bench_folder + "/stats.bin"))
+        for component in data:
+            for field in data[component]:
+                data[component][field] = float(data[component][field])
 
-    # --------------------------------------------------------------------------
-    # for each line in the file, read the data into the dictionary
-    # --------------------------------------------------------------------------
-    
-    for line in fin:
-        (component, field, value) = re.split("[:= ]+", line.strip())
-        if component not in data:
-            data[component] = {}
-        data[component][field] = float(value)
+    else:
 
-    fin.close()
+        # ----------------------------------------------------------------------
+        # Open the main simulation log
+        # ----------------------------------------------------------------------
+
+        fin = open(bench_folder + "/SimulationLog", "r")
+        data = {}
+
+        # ----------------------------------------------------------------------
+        # for each line in the file, read the data into the dictionary
+        # ----------------------------------------------------------------------
+
+        for line in fin:
+            (component, field, value) = re.split("[:= ]+", line.strip())
+            if component not in data:
+                data[component] = {}
+            data[component][field] = float(value)
+
+        fin.close()
 
     # --------------------------------------------------------------------------
     # Open the ipc file
@@ -62,6 +62,16 @@ parser.add_argument("--workload", action = "append", \
     help = "a specific workload to run")
 parser.add_argument("--ooo-window", action = "store",  default = "1", \
     help = "out-of-order window to use for simulation")
+parser.add_argument("--width", action = "store",  default = "1", \
+    help = "issue/retire width of each core")
+parser.add_argument("--load-queue", action = "store",  default = "0", \
+    help = "load queue size of each core [0 for unlimited]")
+parser.add_argument("--store-buffer", action = "store",  default = "0", \
+    help = "store buffer size of each core [0 for unlimited]")
+parser.add_argument("--core-model", action = "store",  default = "ooo", \
+    help = "core timing model [ooo or interval]")
+parser.add_argument("--branch-mpki", action = "store",  default = "0", \
+    help = "branch mispredictions per kilo instruction (interval model)")
 parser.add_argument("--machine", action = "append", \
     help = "list of machines to use for condor submission")
 parser.add_argument("--condor", action = "store_true", default = False, \
@@ -136,6 +146,10 @@ print "            Run-time : ", args.run_time
 print "          Heart-beat : ", args.heart_beat
 print "      Trace Selector : ", args.trace_selector
 print "          OoO Window : ", args.ooo_window
+print "               Width : ", args.width
+print "          Load Queue : ", args.load_queue
+print "        Store Buffer : ", args.store_buffer
+print "          Core Model : ", args.core_model
 print "           Nice user : ", not args.no_nice
 print
 print "List of configuration files: "
@@ -168,6 +182,9 @@ run_time = args.run_time
 warm_up = args.warm_up
 heart_beat = args.heart_beat
 ooo_window = args.ooo_window
+width = args.width
+load_queue = args.load_queue
+store_buffer = args.store_buffer
 
 # ------------------------------------------------------------------------------
 # For each workload, check if all the benchmarks are available. If yes, then
@@ -233,7 +250,11 @@ for workload in workloads:
             config + " --folder " + run_folder + " --num-cpus " + \
             str(len(benchmarks)) + \
             " --warm-up " + warm_up + " --run-time " + run_time + \
-            " --heart-beat " + heart_beat + " --ooo-window " + ooo_window
+            " --heart-beat " + heart_beat + " --ooo-window " + ooo_window + \
+            " --width " + width + " --load-queue " + load_queue + \
+            " --store-buffer " + store_buffer + \
+            " --core-model " + args.core_model + \
+            " --branch-mpki " + args.branch_mpki
 
         if not args.synthetic:
             arguments += " --trace-files " + trace_file_string
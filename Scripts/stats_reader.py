@@ -0,0 +1,156 @@
+#!/usr/bin/env python
+
+# ------------------------------------------------------------------------------
+# File: stats_reader.py
+# Description:
+# 		This script reads the binary statistics file (stats.bin) that the
+# 		simulator writes with --stats-format=binary. See StatsRegistry.h for
+# 		the file format. Run as a script, it prints the final values in the
+# 		format of the simulation log, or the whole file as JSON.
+# ------------------------------------------------------------------------------
+
+
+# ------------------------------------------------------------------------------
+# Import necessary libraries
+# ------------------------------------------------------------------------------
+
+import sys
+import struct
+import json
+import argparse
+
+# ------------------------------------------------------------------------------
+# DEFINITIONS
+# ------------------------------------------------------------------------------
+
+MAGIC = b"CMPSTATS"
+KINDS = ["scalar", "vector", "histogram"]
+
+
+# ------------------------------------------------------------------------------
+# Class to walk through the contents of the file
+# ------------------------------------------------------------------------------
+
+class Reader:
+
+    def __init__(self, buf):
+        self._buf = buf
+        self._pos = 0
+
+    def take(self, fmt):
+        values = struct.unpack_from("<" + fmt, self._buf, self._pos)
+        self._pos += struct.calcsize("<" + fmt)
+        return values[0] if len(values) == 1 else values
+
+    def string(self):
+        length = self.take("H")
+        value = self._buf[self._pos:self._pos + length].decode("utf-8")
+        self._pos += length
+        return value
+
+    def column(self, count):
+        size = self.take("I")
+        end = self._pos + size
+        values = []
+        value = 0
+        while len(values) < count:
+            shift = 0
+            zigzag = 0
+            while True:
+                byte = bytearray(self._buf[self._pos:self._pos + 1])[0]
+                self._pos += 1
+                zigzag |= (byte & 0x7F) << shift
+                shift += 7
+                if not (byte & 0x80):
+                    break
+            delta = (zigzag >> 1) ^ -(zigzag & 1)
+            value = (value + delta) & 0xFFFFFFFFFFFFFFFF
+            values.append(value)
+        assert self._pos == end
+        return values
+
+
+# ------------------------------------------------------------------------------
+# Function to read a statistics file. Each statistic holds one list of values
+# per element, with one value per snapshot. The last snapshot holds the final
+# values
+# ------------------------------------------------------------------------------
+
+def read_stats(filename):
+
+    fin = open(filename, "rb")
+    reader = Reader(fin.read())
+    fin.close()
+
+    if reader.take("8s") != MAGIC:
+        raise ValueError(filename + " is not a statistics file")
+
+    (version, num_stats, num_columns, num_snapshots) = reader.take("IIII")
+    if version != 1:
+        raise ValueError(filename + ": unknown version " + str(version))
+
+    data = {"warm_up_cycle": reader.take("Q"), "stats": []}
+
+    for i in range(num_stats):
+        (kind, first, length) = reader.take("BII")
+        data["stats"].append({"kind": KINDS[kind],
+                              "first_column": first,
+                              "length": length,
+                              "component": reader.string(),
+                              "name": reader.string(),
+                              "description": reader.string()})
+
+    data["cycles"] = [reader.take("Q") for i in range(num_snapshots)]
+    columns = [reader.column(num_snapshots) for i in range(num_columns)]
+
+    for stat in data["stats"]:
+        first = stat.pop("first_column")
+        stat["columns"] = columns[first:first + stat.pop("length")]
+
+    return data
+
+
+# ------------------------------------------------------------------------------
+# Function to get the final values as a dictionary of components. Elements of
+# vectors and histograms are named <name>-<index> as in the simulation log
+# ------------------------------------------------------------------------------
+
+def final_values(data):
+
+    values = {}
+    for stat in data["stats"]:
+        component = values.setdefault(stat["component"], {})
+        if stat["kind"] == "scalar":
+            component[stat["name"]] = stat["columns"][0][-1]
+        else:
+            for i in range(len(stat["columns"])):
+                component[stat["name"] + "-" + str(i)] = stat["columns"][i][-1]
+    return values
+
+
+# ------------------------------------------------------------------------------
+# Main
+# ------------------------------------------------------------------------------
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser(description = "Read a statistics file")
+    parser.add_argument("file", help = "stats.bin file")
+    parser.add_argument("--json", action = "store_true",
+                        help = "print all snapshots as JSON")
+    args = parser.parse_args()
+
+    data = read_stats(args.file)
+
+    if args.json:
+        json.dump(data, sys.stdout, indent = 1)
+        sys.stdout.write("\n")
+    else:
+        for stat in data["stats"]:
+            if stat["kind"] == "scalar":
+                print("%s:%s = %d" % (stat["component"], stat["name"],
+                                      stat["columns"][0][-1]))
+            else:
+                for i in range(len(stat["columns"])):
+                    print("%s:%s-%d = %d" % (stat["component"], stat["name"],
+                                             i, stat["columns"][i][-1]))
@@ -0,0 +1,236 @@
+#!/usr/bin/env python
+
+# ------------------------------------------------------------------------------
+# File: trace_tool.py
+# Description:
+# 		This script reads the request trace (trace.bin) that the simulator
+# 		writes with --trace-sample=N. See RequestTracer.h for the file
+# 		format. It prints the latency breakdown of the traced requests at
+# 		each level of the hierarchy, and can write the trace as Chrome trace
+# 		event JSON (chrome://tracing, Perfetto).
+# ------------------------------------------------------------------------------
+
+
+# ------------------------------------------------------------------------------
+# Import necessary libraries
+# ------------------------------------------------------------------------------
+
+import sys
+import struct
+import json
+import argparse
+
+# ------------------------------------------------------------------------------
+# DEFINITIONS
+# ------------------------------------------------------------------------------
+
+MAGIC = b"CMPTRACE"
+RECORD = struct.Struct("<QIHBB")
+
+ARRIVE, PROCESS, FORWARD, RETURN, DEPART = range(5)
+TYPES = ["read", "write", "partial_write", "writeback", "read_for_write",
+         "fake_read", "prefetch", "clean"]
+
+# parts of the time a request spends at a level
+PARTS = ["queued", "service", "below", "return", "total"]
+
+
+# ------------------------------------------------------------------------------
+# Function to read a trace file. Returns the header and the events of each
+# request, as a dictionary of trace id to a list of (cycle, component, cpu,
+# event, type)
+# ------------------------------------------------------------------------------
+
+def read_trace(filename):
+
+    fin = open(filename, "rb")
+    buf = fin.read()
+    fin.close()
+
+    if buf[0:8] != MAGIC:
+        raise ValueError(filename + " is not a trace file")
+
+    pos = 8
+    (version, num_components) = struct.unpack_from("<II", buf, pos)
+    pos += 8
+    if version != 1:
+        raise ValueError(filename + ": unknown version " + str(version))
+
+    components = []
+    for i in range(num_components):
+        length = struct.unpack_from("<H", buf, pos)[0]
+        pos += 2
+        components.append(buf[pos:pos + length].decode("utf-8"))
+        pos += length
+
+    num_cpus = struct.unpack_from("<I", buf, pos)[0]
+    pos += 4
+    hier = []
+    for i in range(num_cpus):
+        levels = struct.unpack_from("<I", buf, pos)[0]
+        pos += 4
+        hier.append(list(struct.unpack_from("<%dH" % levels, buf, pos)))
+        pos += 2 * levels
+
+    requests = {}
+    end = pos + (len(buf) - pos) // RECORD.size * RECORD.size
+    while pos < end:
+        (cycle, trace, component, cpu, event) = RECORD.unpack_from(buf, pos)
+        pos += RECORD.size
+        requests.setdefault(trace, []).append(
+            (cycle, component, cpu, event & 0xF, event >> 4))
+
+    return {"components": components, "hier": hier}, requests
+
+
+# ------------------------------------------------------------------------------
+# Function to split the events of a request by component and request type.
+# The miss an MSHR sends below carries the trace id of the request, so a
+# write and its read_for_write miss are separate visits at the MSHR, and the
+# visit of the miss starts when the MSHR forwards it. Returns
+# a list of (component, cpu, type, parts) in the order the request reached
+# them, where parts holds the cycles of each of PARTS. A request that a
+# component retries after a stall is queued until it is processed for the
+# last time.
+# ------------------------------------------------------------------------------
+
+def breakdown(events):
+
+    visits = {}
+    order = []
+    for (cycle, component, cpu, event, rtype) in events:
+        key = (component, rtype)
+        if key not in visits:
+            visits[key] = {"cpu": cpu}
+            order.append(key)
+        visit = visits[key]
+        if event == ARRIVE:
+            visit.setdefault(ARRIVE, cycle)
+        elif event == RETURN:
+            visit.setdefault(RETURN, cycle)
+        else:
+            visit[event] = cycle
+
+    result = []
+    for (component, rtype) in order:
+        visit = visits[(component, rtype)]
+        if DEPART not in visit or (ARRIVE not in visit and
+                                   FORWARD not in visit):
+            continue
+        start = visit.get(ARRIVE, visit.get(FORWARD))
+        process = visit.get(PROCESS, start)
+        leave = visit.get(FORWARD, visit.get(RETURN, visit[DEPART]))
+        back = visit.get(RETURN, leave)
+        parts = {"queued": process - start,
+                 "service": leave - process,
+                 "below": back - leave if FORWARD in visit else 0,
+                 "return": visit[DEPART] - back,
+                 "total": visit[DEPART] - start}
+        result.append((component, visit["cpu"], rtype, parts))
+    return result
+
+
+# ------------------------------------------------------------------------------
+# Function to get a percentile of a sorted list
+# ------------------------------------------------------------------------------
+
+def percentile(values, p):
+    if not values:
+        return 0
+    index = int(p / 100.0 * len(values) + 0.5) - 1
+    return values[min(max(index, 0), len(values) - 1)]
+
+
+# ------------------------------------------------------------------------------
+# Function to print the breakdown at each level, for each request type.
+# Components are listed in the order of the hierarchy of the first cpu that
+# has them
+# ------------------------------------------------------------------------------
+
+def print_breakdown(header, requests, types):
+
+    samples = {}
+    for events in requests.values():
+        for (component, cpu, rtype, parts) in breakdown(events):
+            if types and TYPES[rtype] not in types:
+                continue
+            entry = samples.setdefault((component, rtype),
+                                       dict((part, []) for part in PARTS))
+            for part in PARTS:
+                entry[part].append(parts[part])
+
+    order = []
+    for levels in header["hier"]:
+        for component in levels:
+            if component not in order:
+                order.append(component)
+
+    print("%-16s %-14s %8s  %-8s %10s %10s %10s" %
+          ("component", "type", "requests", "part", "mean", "p50", "p99"))
+    for component in order:
+        for rtype in range(len(TYPES)):
+            if (component, rtype) not in samples:
+                continue
+            entry = samples[(component, rtype)]
+            for part in PARTS:
+                values = sorted(entry[part])
+                print("%-16s %-14s %8d  %-8s %10.1f %10d %10d" %
+                      (header["components"][component], TYPES[rtype],
+                       len(values), part, float(sum(values)) / len(values),
+                       percentile(values, 50), percentile(values, 99)))
+
+
+# ------------------------------------------------------------------------------
+# Function to write the trace as Chrome trace events. Each cpu is a process
+# and each component a thread, and a cycle is shown as a microsecond
+# ------------------------------------------------------------------------------
+
+def write_chrome(header, requests, filename):
+
+    events = []
+    for cpu in range(len(header["hier"])):
+        events.append({"ph": "M", "name": "process_name", "pid": cpu,
+                       "args": {"name": "cpu " + str(cpu)}})
+        for (level, component) in enumerate(header["hier"][cpu]):
+            events.append({"ph": "M", "name": "thread_name", "pid": cpu,
+                           "tid": component,
+                           "args": {"name": header["components"][component]}})
+            events.append({"ph": "M", "name": "thread_sort_index",
+                           "pid": cpu, "tid": component,
+                           "args": {"sort_index": level}})
+
+    for (trace, request) in sorted(requests.items()):
+        start = {}
+        for (cycle, component, cpu, event, rtype) in request:
+            start.setdefault((component, rtype), cycle)
+        for (component, cpu, rtype, parts) in breakdown(request):
+            events.append({"ph": "X", "name": TYPES[rtype],
+                           "pid": cpu, "tid": component,
+                           "ts": start[(component, rtype)],
+                           "dur": parts["total"],
+                           "args": dict([("trace", trace)] +
+                                        list(parts.items()))})
+
+    fout = open(filename, "w")
+    json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, fout)
+    fout.close()
+
+
+# ------------------------------------------------------------------------------
+# Main
+# ------------------------------------------------------------------------------
+
+if __name__ == "__main__":
+
+    parser = argparse.ArgumentParser(description = "Read a request trace")
+    parser.add_argument("file", help = "trace.bin file")
+    parser.add_argument("--type", action = "append", choices = TYPES,
+                        help = "only requests of this type (repeatable)")
+    parser.add_argument("--chrome", metavar = "JSON",
+                        help = "write Chrome trace events to this file")
+    args = parser.parse_args()
+
+    (header, requests) = read_trace(args.file)
+    print_breakdown(header, requests, args.type)
+    if args.chrome:
+        write_chrome(header, requests, args.chrome)
@@ -0,0 +1,462 @@
+// -----------------------------------------------------------------------------
+// File: StatsRegistry.h
+// Description:
+//    Defines the statistics registry of the simulator. Components register
+//    their counters with it, the simulator snapshots them at heart beats and
+//    at the end of simulation, and the snapshots are written to a binary
+//    columnar file, a CSV file or a JSON file.
+// -----------------------------------------------------------------------------
+
+#ifndef __STATS_REGISTRY_H__
+#define __STATS_REGISTRY_H__
+
+// -----------------------------------------------------------------------------
+// Module includes
+// -----------------------------------------------------------------------------
+
+#include "Types.h"
+
+// -----------------------------------------------------------------------------
+// Standard includes
+// -----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cassert>
+
+using namespace std;
+
+
+// -----------------------------------------------------------------------------
+// Class: StatsRegistry
+// Description:
+//    Central registry of statistics. A statistic is a scalar counter, a
+//    vector of counters (one per cpu) or a histogram, and is named by its
+//    component and its name. Registration returns an integer handle that is
+//    used for all later lookups.
+//
+//    The registry only holds pointers to the counters, so updating a counter
+//    costs nothing more than before. A snapshot copies every counter into
+//    one column per element. The column layout is fixed at the first
+//    snapshot: vectors and histograms are sized by then (components size
+//    them when simulation starts), elements added later are not recorded and
+//    missing ones read as 0. The last snapshot is taken at the end of
+//    simulation and holds the final values.
+//
+//    Binary file format. Integers are little endian, strings are a uint16
+//    length followed by the characters. A column is stored as the
+//    differences between consecutive snapshots (the first from 0), zigzag
+//    encoded (0, -1, 1, -2 ... map to 0, 1, 2, 3 ...) and written as LEB128
+//    varints, 7 bits per byte with the high bit set on all but the last:
+//      char   magic[8]          "CMPSTATS"
+//      uint32 version           1
+//      uint32 numStats
+//      uint32 numColumns
+//      uint32 numSnapshots
+//      uint64 warmUpCycle       cycle at which warm up ended
+//      numStats times:
+//        uint8  kind            0 scalar, 1 vector, 2 histogram
+//        uint32 firstColumn
+//        uint32 length          number of columns of the statistic
+//        string component, string name, string description
+//      uint64 cycles[numSnapshots]
+//      numColumns times:
+//        uint32 bytes           size of the encoded column
+//        varint deltas[numSnapshots]
+// -----------------------------------------------------------------------------
+
+class StatsRegistry {
+
+  public:
+
+    enum Kind {
+      SCALAR = 0,
+      VECTOR = 1,
+      HISTOGRAM = 2
+    };
+
+    typedef uint32 handle_t;
+
+    static const handle_t INVALID_HANDLE = 0xFFFFFFFF;
+
+    struct Stat {
+      string component;
+      string name;
+      string longname;
+      Kind kind;
+      // counter of a scalar, vector of a vector or histogram
+      uint64 *ptr;
+      vector <uint64> *vec;
+      // columns in the snapshots
+      uint32 firstColumn;
+      uint32 length;
+    };
+
+  protected:
+
+    vector <Stat> _stats;
+
+    // snapshots. one vector of values per column
+    bool _frozen;
+    uint32 _numColumns;
+    vector <cycles_t> _cycles;
+    vector <vector <uint64> > _columns;
+
+    cycles_t _warmUpCycle;
+
+  public:
+
+    // -------------------------------------------------------------------------
+    // Constructor
+    // -------------------------------------------------------------------------
+
+    StatsRegistry() {
+      _frozen = false;
+      _numColumns = 0;
+      _warmUpCycle = 0;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Functions to register a statistic. They return its handle
+    // -------------------------------------------------------------------------
+
+    handle_t AddScalar(string component, string name, string longname,
+        uint64 *ptr) {
+      return Add(component, name, longname, SCALAR, ptr, NULL);
+    }
+
+    handle_t AddVector(string component, string name, string longname,
+        vector <uint64> *vec) {
+      return Add(component, name, longname, VECTOR, NULL, vec);
+    }
+
+    handle_t AddHistogram(string component, string name, string longname,
+        vector <uint64> *vec) {
+      return Add(component, name, longname, HISTOGRAM, NULL, vec);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to find the handle of a statistic. Meant to be called once,
+    // before the handle is used
+    // -------------------------------------------------------------------------
+
+    handle_t Find(string component, string name) {
+      for (handle_t h = 0; h < _stats.size(); h ++)
+        if (_stats[h].component == component && _stats[h].name == name)
+          return h;
+      return INVALID_HANDLE;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Functions to access statistics through their handles
+    // -------------------------------------------------------------------------
+
+    uint32 NumStats() {
+      return _stats.size();
+    }
+
+    const Stat &Get(handle_t handle) {
+      assert(handle < _stats.size());
+      return _stats[handle];
+    }
+
+    uint32 Length(handle_t handle) {
+      Stat &stat = _stats[handle];
+      return (stat.kind == SCALAR ? 1 : stat.vec -> size());
+    }
+
+    uint64 Value(handle_t handle, uint32 index = 0) {
+      Stat &stat = _stats[handle];
+      if (stat.kind == SCALAR)
+        return *(stat.ptr);
+      return (index < stat.vec -> size() ? (*stat.vec)[index] : 0);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to record the cycle at which warm up ended
+    // -------------------------------------------------------------------------
+
+    void EndWarmUp(cycles_t now) {
+      _warmUpCycle = now;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to take a snapshot of all statistics
+    // -------------------------------------------------------------------------
+
+    void Snapshot(cycles_t now) {
+      if (!_frozen)
+        Freeze();
+
+      _cycles.push_back(now);
+      for (uint32 h = 0; h < _stats.size(); h ++) {
+        Stat &stat = _stats[h];
+        for (uint32 i = 0; i < stat.length; i ++)
+          _columns[stat.firstColumn + i].push_back(Value(h, i));
+      }
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to write the snapshots to the binary columnar file
+    // -------------------------------------------------------------------------
+
+    void WriteBinary(string fileName) {
+      FILE *file = fopen(fileName.c_str(), "wb");
+      assert(file != NULL);
+
+      fwrite("CMPSTATS", 1, 8, file);
+      Put(file, 1, 4);
+      Put(file, _stats.size(), 4);
+      Put(file, _numColumns, 4);
+      Put(file, _cycles.size(), 4);
+      Put(file, _warmUpCycle, 8);
+
+      for (uint32 h = 0; h < _stats.size(); h ++) {
+        Stat &stat = _stats[h];
+        Put(file, stat.kind, 1);
+        Put(file, stat.firstColumn, 4);
+        Put(file, stat.length, 4);
+        PutString(file, stat.component);
+        PutString(file, stat.name);
+        PutString(file, stat.longname);
+      }
+
+      for (uint32 s = 0; s < _cycles.size(); s ++)
+        Put(file, _cycles[s], 8);
+      vector <unsigned char> encoded;
+      for (uint32 c = 0; c < _numColumns; c ++) {
+        encoded.clear();
+        uint64 previous = 0;
+        for (uint32 s = 0; s < _cycles.size(); s ++) {
+          int64 delta = (int64)(_columns[c][s] - previous);
+          uint64 zigzag = ((uint64)delta << 1) ^ (uint64)(delta >> 63);
+          while (zigzag >= 0x80) {
+            encoded.push_back((zigzag & 0x7F) | 0x80);
+            zigzag >>= 7;
+          }
+          encoded.push_back(zigzag);
+          previous = _columns[c][s];
+        }
+        Put(file, encoded.size(), 4);
+        if (!encoded.empty())
+          fwrite(&encoded[0], 1, encoded.size(), file);
+      }
+
+      fclose(file);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to write the snapshots as CSV. The final values go to one row
+    // per element of each statistic, the snapshots to one row per snapshot in
+    // the intervals file
+    // -------------------------------------------------------------------------
+
+    void WriteCSV(string fileName, string intervalsFileName) {
+      if (_cycles.empty()) return;
+      uint32 last = _cycles.size() - 1;
+
+      FILE *file = fopen(fileName.c_str(), "w");
+      assert(file != NULL);
+      fprintf(file, "component,stat,kind,index,value\n");
+      for (uint32 h = 0; h < _stats.size(); h ++) {
+        Stat &stat = _stats[h];
+        for (uint32 i = 0; i < stat.length; i ++)
+          fprintf(file, "%s,%s,%s,%u,%llu\n", stat.component.c_str(),
+              stat.name.c_str(), KindName(stat.kind), i,
+              _columns[stat.firstColumn + i][last]);
+      }
+      fclose(file);
+
+      file = fopen(intervalsFileName.c_str(), "w");
+      assert(file != NULL);
+      fprintf(file, "cycle");
+      for (uint32 h = 0; h < _stats.size(); h ++) {
+        Stat &stat = _stats[h];
+        if (stat.kind == SCALAR)
+          fprintf(file, ",%s.%s", stat.component.c_str(), stat.name.c_str());
+        else {
+          for (uint32 i = 0; i < stat.length; i ++)
+            fprintf(file, ",%s.%s.%u", stat.component.c_str(),
+                stat.name.c_str(), i);
+        }
+      }
+      fprintf(file, "\n");
+      for (uint32 s = 0; s < _cycles.size(); s ++) {
+        fprintf(file, "%llu", _cycles[s]);
+        for (uint32 c = 0; c < _numColumns; c ++)
+          fprintf(file, ",%llu", _columns[c][s]);
+        fprintf(file, "\n");
+      }
+      fclose(file);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to write the snapshots as JSON. Each statistic holds its final
+    // value and its value at each snapshot
+    // -------------------------------------------------------------------------
+
+    void WriteJSON(string fileName) {
+      if (_cycles.empty()) return;
+      uint32 last = _cycles.size() - 1;
+
+      FILE *file = fopen(fileName.c_str(), "w");
+      assert(file != NULL);
+
+      fprintf(file, "{\n  \"version\": 1,\n  \"warm-up-cycle\": %llu,\n",
+          _warmUpCycle);
+      fprintf(file, "  \"cycles\": [");
+      for (uint32 s = 0; s < _cycles.size(); s ++)
+        fprintf(file, "%s%llu", s == 0 ? "" : ", ", _cycles[s]);
+      fprintf(file, "],\n  \"stats\": [");
+
+      for (uint32 h = 0; h < _stats.size(); h ++) {
+        Stat &stat = _stats[h];
+        fprintf(file, "%s\n    {\"component\": ", h == 0 ? "" : ",");
+        PutJSONString(file, stat.component);
+        fprintf(file, ", \"name\": ");
+        PutJSONString(file, stat.name);
+        fprintf(file, ", \"description\": ");
+        PutJSONString(file, stat.longname);
+        fprintf(file, ", \"kind\": \"%s\",\n     \"value\": ",
+            KindName(stat.kind));
+        PutJSONValue(file, stat, last);
+        fprintf(file, ",\n     \"intervals\": [");
+        for (uint32 s = 0; s < _cycles.size(); s ++) {
+          if (s != 0) fprintf(file, ", ");
+          PutJSONValue(file, stat, s);
+        }
+        fprintf(file, "]}");
+      }
+
+      fprintf(file, "\n  ]\n}\n");
+      fclose(file);
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to write the current values of the statistics of a component
+    // to the simulation log, in registration order. Vectors and histograms
+    // take one line per element
+    // -------------------------------------------------------------------------
+
+    void WriteLog(FILE *file, string component) {
+      for (uint32 h = 0; h < _stats.size(); h ++) {
+        Stat &stat = _stats[h];
+        if (stat.component != component) continue;
+        if (stat.kind == SCALAR) {
+          fprintf(file, "%s:%s = %llu\n", component.c_str(),
+              stat.name.c_str(), *(stat.ptr));
+          continue;
+        }
+        for (uint32 i = 0; i < stat.vec -> size(); i ++)
+          fprintf(file, "%s:%s-%u = %llu\n", component.c_str(),
+              stat.name.c_str(), i, (*stat.vec)[i]);
+      }
+    }
+
+
+  protected:
+
+    // -------------------------------------------------------------------------
+    // Function to add a statistic
+    // -------------------------------------------------------------------------
+
+    handle_t Add(string component, string name, string longname, Kind kind,
+        uint64 *ptr, vector <uint64> *vec) {
+      if (_frozen) {
+        fprintf(stderr, "Error: statistic `%s:%s' registered after the "
+            "first snapshot\n", component.c_str(), name.c_str());
+        exit(-1);
+      }
+
+      Stat stat;
+      stat.component = component;
+      stat.name = name;
+      stat.longname = longname;
+      stat.kind = kind;
+      stat.ptr = ptr;
+      stat.vec = vec;
+      stat.firstColumn = 0;
+      stat.length = 0;
+      _stats.push_back(stat);
+      return _stats.size() - 1;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Function to fix the column layout of the snapshots
+    // -------------------------------------------------------------------------
+
+    void Freeze() {
+      _numColumns = 0;
+      for (uint32 h = 0; h < _stats.size(); h ++) {
+        _stats[h].firstColumn = _numColumns;
+        _stats[h].length = Length(h);
+        _numColumns += _stats[h].length;
+      }
+      _columns.resize(_numColumns);
+      _frozen = true;
+    }
+
+
+    // -------------------------------------------------------------------------
+    // Output helpers
+    // -------------------------------------------------------------------------
+
+    const char *KindName(Kind kind) {
+      switch (kind) {
+        case SCALAR: return "scalar";
+        case VECTOR: return "vector";
+        case HISTOGRAM: return "histogram";
+      }
+      return "";
+    }
+
+    void Put(FILE *file, uint64 value, uint32 bytes) {
+      unsigned char buffer[8];
+      for (uint32 i = 0; i < bytes; i ++)
+        buffer[i] = (value >> (8 * i)) & 0xFF;
+      fwrite(buffer, 1, bytes, file);
+    }
+
+    void PutString(FILE *file, const string &str) {
+      uint32 length = min((uint32)str.size(), (uint32)0xFFFF);
+      Put(file, length, 2);
+      fwrite(str.data(), 1, length, file);
+    }
+
+    void PutJSONString(FILE *file, const string &str) {
+      fputc('"', file);
+      for (uint32 i = 0; i < str.size(); i ++) {
+        if (str[i] == '"' || str[i] == '\\')
+          fputc('\\', file);
+        fputc(str[i], file);
+      }
+      fputc('"', file);
+    }
+
+    void PutJSONValue(FILE *file, Stat &stat, uint32 snapshot) {
+      if (stat.kind == SCALAR) {
+        fprintf(file, "%llu", _columns[stat.firstColumn][snapshot]);
+        return;
+      }
+      fprintf(file, "[");
+      for (uint32 i = 0; i < stat.length; i ++)
+        fprintf(file, "%s%llu", i == 0 ? "" : ", ",
+            _columns[stat.firstColumn + i][snapshot]);
+      fprintf(file, "]");
+    }
+};
+
+#endif // __STATS_REGISTRY_H__